@@ -48,6 +48,7 @@
 #include "error.h"
 #include "session.h"
 #include "cfg.h"
+#include "txn.h"
 
 STRS(applier_state, applier_STATE);
 
@@ -378,6 +379,232 @@ applier_join(struct applier *applier)
 	applier_set_state(applier, APPLIER_READY);
 }
 
+/** A row received from the master and being applied. */
+struct applier_row {
+	/** Applier that received the row. */
+	struct applier *applier;
+	/** Session of the applier fiber. */
+	struct session *session;
+	/** The row. Its body points to applier_row::data. */
+	struct xrow_header row;
+	/** Set when ordering latches have been released. */
+	bool is_submitted;
+	/** Latch ordering rows of the same replica id. */
+	struct latch *latch;
+	/** Trigger releasing the latches on WAL submission. */
+	struct trigger on_submit;
+	/** Trigger restoring the vclock on WAL failure. */
+	struct trigger on_rollback;
+	/** Copy of the row body. */
+	char data[0];
+};
+
+/** Release the latches held while applying a row. */
+static void
+applier_row_release(struct applier_row *ar)
+{
+	if (ar->is_submitted)
+		return;
+	ar->is_submitted = true;
+	latch_unlock(ar->latch);
+	latch_unlock(&ar->applier->order_latch);
+}
+
+static void
+applier_row_on_submit(struct trigger *trigger, void *event)
+{
+	(void) event;
+	applier_row_release((struct applier_row *) trigger->data);
+}
+
+static void
+applier_row_on_rollback(struct trigger *trigger, void *event)
+{
+	(void) event;
+	struct applier_row *ar = (struct applier_row *) trigger->data;
+	/*
+	 * A row that failed to execute is skipped, see
+	 * applier_apply_f(). A row that was submitted failed
+	 * to be written to WAL, together with the rows that
+	 * followed it, so move the vclock back to let them be
+	 * received again when the replication is resumed.
+	 * Rows are rolled back in reverse order, the first
+	 * failed row is the last to get here.
+	 */
+	if (!ar->is_submitted)
+		return;
+	struct xrow_header *row = &ar->row;
+	if (vclock_get(&replicaset.vclock, row->replica_id) >= row->lsn)
+		vclock_reset(&replicaset.vclock, row->replica_id,
+			     row->lsn - 1);
+}
+
+/**
+ * Fiber function applying a row. Rows are executed one by one
+ * in the order they were received, but a fiber lets the next
+ * row go as soon as its own row has been submitted to WAL, so
+ * that WAL writes of consecutive rows are pipelined.
+ */
+static int
+applier_apply_f(va_list ap)
+{
+	struct applier_row *ar = va_arg(ap, struct applier_row *);
+	struct applier *applier = ar->applier;
+	struct xrow_header *row = &ar->row;
+	fiber_set_session(fiber(), ar->session);
+	fiber_set_user(fiber(), &ar->session->credentials);
+
+	struct replica *replica = replica_by_id(row->replica_id);
+	ar->latch = (replica ? &replica->order_latch :
+		     &replicaset.applier.order_latch);
+	/*
+	 * Rows received from the master are ordered by the
+	 * applier latch. Fibers are started in the order
+	 * rows are received and queue on the latch before
+	 * the next row is read, so they take it in turn.
+	 *
+	 * In a full mesh topology, the same set of changes
+	 * may arrive via two concurrently running appliers.
+	 * Thanks to vclock_follow() below, the first row in
+	 * the set will be skipped - but the remaining may
+	 * execute out of order, when the following
+	 * xstream_write() yields on WAL. Hence we need a latch
+	 * to strictly order all changes which belong to the
+	 * same server id.
+	 */
+	latch_lock(&applier->order_latch);
+	latch_lock(ar->latch);
+	if (!diag_is_empty(&applier->diag) ||
+	    vclock_get(&replicaset.vclock, row->replica_id) >= row->lsn) {
+		/*
+		 * A preceding row failed to apply or the row
+		 * has been applied by another applier.
+		 */
+		applier_row_release(ar);
+		goto out;
+	}
+	/**
+	 * Promote the replica set vclock before
+	 * applying the row. If there is an
+	 * exception (conflict) applying the row,
+	 * the row is skipped when the replication
+	 * is resumed. If the row fails to be written
+	 * to WAL, the vclock is moved back on rollback.
+	 */
+	vclock_follow_xrow(&replicaset.vclock, row);
+	int res;
+	if (txn_begin(true) == NULL) {
+		res = -1;
+	} else {
+		trigger_create(&ar->on_submit, applier_row_on_submit, ar, NULL);
+		txn_on_submit(in_txn(), &ar->on_submit);
+		trigger_create(&ar->on_rollback, applier_row_on_rollback,
+			       ar, NULL);
+		txn_on_rollback(in_txn(), &ar->on_rollback);
+		res = xstream_write(applier->subscribe_stream, row);
+		/*
+		 * The row is committed by the first statement
+		 * unless it failed before it was started.
+		 */
+		if (in_txn() != NULL)
+			txn_rollback();
+	}
+	applier_row_release(ar);
+	if (res != 0) {
+		struct error *e = diag_last_error(diag_get());
+		/**
+		 * Silently skip ER_TUPLE_FOUND error if such
+		 * option is set in config.
+		 */
+		if (e->type == &type_ClientError &&
+		    box_error_code(e) == ER_TUPLE_FOUND &&
+		    replication_skip_conflict)
+			diag_clear(diag_get());
+		else if (diag_is_empty(&applier->diag))
+			diag_move(diag_get(), &applier->diag);
+	}
+	if (applier->state == APPLIER_SYNC ||
+	    applier->state == APPLIER_FOLLOW)
+		fiber_cond_signal(&applier->writer_cond);
+out:
+	free(ar);
+	assert(applier->queue_len > 0);
+	applier->queue_len--;
+	fiber_cond_broadcast(&applier->queue_cond);
+	fiber_gc();
+	return 0;
+}
+
+/**
+ * Wait until all rows received from the master are applied.
+ * Not cancellable, since rows refer to the applier.
+ */
+static void
+applier_wait_queue(struct applier *applier)
+{
+	bool was_cancellable = fiber_set_cancellable(false);
+	while (applier->queue_len > 0)
+		fiber_cond_wait(&applier->queue_cond);
+	fiber_set_cancellable(was_cancellable);
+}
+
+/**
+ * Raise the error of a row that failed to apply, if any,
+ * once all rows being applied are done.
+ */
+static void
+applier_check_diag(struct applier *applier)
+{
+	if (!diag_is_empty(&applier->diag)) {
+		applier_wait_queue(applier);
+		diag_move(&applier->diag, diag_get());
+		diag_raise();
+	}
+}
+
+/**
+ * Apply a row received from the master in a new fiber.
+ * Raise the error of a row that failed to apply, if any.
+ */
+static void
+applier_apply_row(struct applier *applier, struct xrow_header *row)
+{
+	/* Don't read ahead too much. */
+	while (applier->queue_len >= APPLIER_QUEUE_MAX) {
+		fiber_cond_wait(&applier->queue_cond);
+		fiber_testcancel();
+	}
+	applier_check_diag(applier);
+	/* The input buffer may be reallocated, copy the row body. */
+	size_t size = 0;
+	for (int i = 0; i < row->bodycnt; i++)
+		size += row->body[i].iov_len;
+	struct applier_row *ar = (struct applier_row *)
+		malloc(sizeof(*ar) + size);
+	if (ar == NULL) {
+		tnt_raise(OutOfMemory, sizeof(*ar) + size,
+			  "malloc", "struct applier_row");
+	}
+	ar->applier = applier;
+	ar->session = current_session();
+	ar->row = *row;
+	ar->is_submitted = false;
+	ar->latch = NULL;
+	char *data = ar->data;
+	for (int i = 0; i < row->bodycnt; i++) {
+		memcpy(data, row->body[i].iov_base, row->body[i].iov_len);
+		ar->row.body[i].iov_base = data;
+		data += row->body[i].iov_len;
+	}
+	struct fiber *f = fiber_new("applier/apply", applier_apply_f);
+	if (f == NULL) {
+		free(ar);
+		diag_raise();
+	}
+	applier->queue_len++;
+	fiber_start(f, ar);
+}
+
 /**
  * Execute and process SUBSCRIBE request (follow updates from a master).
  */
@@ -462,6 +689,13 @@ applier_subscribe(struct applier *applier)
 	 * Process a stream of rows from the binary log.
 	 */
 	while (true) {
+		/*
+		 * Don't wait for the next row to report a row
+		 * that failed to apply: a master may send only
+		 * heartbeats for a long time.
+		 */
+		applier_check_diag(applier);
+
 		if (applier->state == APPLIER_FINAL_JOIN &&
 		    instance_id != REPLICA_ID_NIL) {
 			say_info("final data received");
@@ -513,47 +747,8 @@ applier_subscribe(struct applier *applier)
 		applier->lag = ev_now(loop()) - row.tm;
 		applier->last_row_time = ev_monotonic_now(loop());
 
-		if (vclock_get(&replicaset.vclock, row.replica_id) < row.lsn) {
-			/**
-			 * Promote the replica set vclock before
-			 * applying the row. If there is an
-			 * exception (conflict) applying the row,
-			 * the row is skipped when the replication
-			 * is resumed.
-			 */
-			vclock_follow_xrow(&replicaset.vclock, &row);
-			struct replica *replica = replica_by_id(row.replica_id);
-			struct latch *latch = (replica ? &replica->order_latch :
-					       &replicaset.applier.order_latch);
-			/*
-			 * In a full mesh topology, the same set
-			 * of changes may arrive via two
-			 * concurrently running appliers. Thanks
-			 * to vclock_follow() above, the first row
-			 * in the set will be skipped - but the
-			 * remaining may execute out of order,
-			 * when the following xstream_write()
-			 * yields on WAL. Hence we need a latch to
-			 * strictly order all changes which belong
-			 * to the same server id.
-			 */
-			latch_lock(latch);
-			int res = xstream_write(applier->subscribe_stream, &row);
-			latch_unlock(latch);
-			if (res != 0) {
-				struct error *e = diag_last_error(diag_get());
-				/**
-				 * Silently skip ER_TUPLE_FOUND error if such
-				 * option is set in config.
-				 */
-				if (e->type == &type_ClientError &&
-				    box_error_code(e) == ER_TUPLE_FOUND &&
-				    replication_skip_conflict)
-					diag_clear(diag_get());
-				else
-					diag_raise();
-			}
-		}
+		if (vclock_get(&replicaset.vclock, row.replica_id) < row.lsn)
+			applier_apply_row(applier, &row);
 		if (applier->state == APPLIER_SYNC ||
 		    applier->state == APPLIER_FOLLOW)
 			fiber_cond_signal(&applier->writer_cond);
@@ -572,6 +767,8 @@ applier_disconnect(struct applier *applier, enum applier_state state)
 		fiber_join(applier->writer);
 		applier->writer = NULL;
 	}
+	applier_wait_queue(applier);
+	diag_clear(&applier->diag);
 
 	coio_close(loop(), &applier->io);
 	/* Clear all unparsed input. */
@@ -729,6 +926,9 @@ applier_new(const char *uri, struct xstream *join_stream,
 	rlist_create(&applier->on_state);
 	fiber_cond_create(&applier->resume_cond);
 	fiber_cond_create(&applier->writer_cond);
+	fiber_cond_create(&applier->queue_cond);
+	latch_create(&applier->order_latch);
+	diag_create(&applier->diag);
 
 	return applier;
 }
@@ -742,6 +942,10 @@ applier_delete(struct applier *applier)
 	trigger_destroy(&applier->on_state);
 	fiber_cond_destroy(&applier->resume_cond);
 	fiber_cond_destroy(&applier->writer_cond);
+	assert(applier->queue_len == 0);
+	fiber_cond_destroy(&applier->queue_cond);
+	latch_destroy(&applier->order_latch);
+	diag_destroy(&applier->diag);
 	free(applier);
 }
 
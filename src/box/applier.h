@@ -37,7 +37,9 @@
 
 #include <small/ibuf.h>
 
+#include "diag.h"
 #include "fiber_cond.h"
+#include "latch.h"
 #include "trigger.h"
 #include "trivia/util.h"
 #include "tt_uuid.h"
@@ -49,6 +51,16 @@ struct xstream;
 
 enum { APPLIER_SOURCE_MAXLEN = 1024 }; /* enough to fit URI with passwords */
 
+enum {
+	/**
+	 * Max number of rows received from the master that
+	 * may be applied concurrently. When the limit is
+	 * reached, the applier stops reading from the master
+	 * until some of the rows are committed.
+	 */
+	APPLIER_QUEUE_MAX = 256,
+};
+
 #define applier_STATE(_)                                             \
 	_(APPLIER_OFF, 0)                                            \
 	_(APPLIER_CONNECT, 1)                                        \
@@ -120,6 +132,29 @@ struct applier {
 	struct xstream *join_stream;
 	/** xstream to process rows during final JOIN and SUBSCRIBE */
 	struct xstream *subscribe_stream;
+	/**
+	 * Number of rows received from the master which are
+	 * being applied, each in its own fiber. Rows are
+	 * executed and submitted to WAL in the order they were
+	 * received, but the applier doesn't wait for WAL before
+	 * reading the next row, so that the replica can keep up
+	 * with many concurrent writers on the master.
+	 */
+	int queue_len;
+	/** Signaled when a row has been applied. */
+	struct fiber_cond queue_cond;
+	/**
+	 * Held by a fiber applying a row until the row is
+	 * submitted to WAL, so that rows are applied in the
+	 * order they were received.
+	 */
+	struct latch order_latch;
+	/**
+	 * Error that occurred while applying a row. Rows
+	 * received after a failed row are not applied, and the
+	 * error is raised by the reader fiber.
+	 */
+	struct diag diag;
 };
 
 /**
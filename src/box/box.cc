@@ -46,10 +46,12 @@
 #include <rmean.h>
 #include "main.h"
 #include "tuple.h"
+#include "tuple_convert.h"
 #include "session.h"
 #include "schema.h"
 #include "engine.h"
 #include "memtx_engine.h"
+#include "memtx_tx.h"
 #include "sysview.h"
 #include "blackhole.h"
 #include "vinyl.h"
@@ -69,6 +71,7 @@
 #include "path_lock.h"
 #include "gc.h"
 #include "sql.h"
+#include "sql_stmt_cache.h"
 #include "systemd.h"
 #include "call.h"
 #include "func.h"
@@ -166,6 +169,17 @@ box_check_memtx_min_tuple_size(ssize_t memtx_min_tuple_size)
 		  "specified value is out of bounds");
 }
 
+static int
+box_check_memtx_sort_threads(int threads)
+{
+	if (threads < 0 || threads > MEMTX_SORT_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "memtx_sort_threads",
+			  tt_sprintf("must be in range [0, %d]",
+				     MEMTX_SORT_THREADS_MAX));
+	}
+	return threads;
+}
+
 int
 box_process_rw(struct request *request, struct space *space,
 	       struct tuple **result)
@@ -520,6 +534,32 @@ box_check_readahead(int readahead)
 	}
 }
 
+static int
+box_check_iproto_threads(void)
+{
+	int threads = cfg_geti("iproto_threads");
+	if (threads < 1 || threads > IPROTO_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "iproto_threads",
+			  tt_sprintf("must be greater than or equal to 1 "
+				     "and less than or equal to %d",
+				     IPROTO_THREADS_MAX));
+	}
+	return threads;
+}
+
+static int
+box_check_iproto_read_threads(void)
+{
+	int threads = cfg_geti("iproto_read_threads");
+	if (threads < 0 || threads > IPROTO_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "iproto_read_threads",
+			  tt_sprintf("must be greater than or equal to 0 "
+				     "and less than or equal to %d",
+				     IPROTO_THREADS_MAX));
+	}
+	return threads;
+}
+
 static void
 box_check_checkpoint_count(int checkpoint_count)
 {
@@ -551,6 +591,36 @@ box_check_wal_max_size(int64_t wal_max_size)
 	return wal_max_size;
 }
 
+static double
+box_check_wal_batch_max_delay(double delay)
+{
+	if (delay < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_batch_max_delay",
+			  "must not be less than 0");
+	}
+	return delay;
+}
+
+static int64_t
+box_check_wal_batch_max_bytes(int64_t bytes)
+{
+	if (bytes <= 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_batch_max_bytes",
+			  "must be greater than 0");
+	}
+	return bytes;
+}
+
+static int64_t
+box_check_wal_cache_size(int64_t size)
+{
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_cache_size",
+			  "must not be less than 0");
+	}
+	return size;
+}
+
 static int64_t
 box_check_memtx_memory(int64_t memory)
 {
@@ -571,6 +641,27 @@ box_check_vinyl_memory(int64_t memory)
 	return memory;
 }
 
+static int64_t
+box_check_sql_cache_size(int64_t size)
+{
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "sql_cache_size",
+			  "must not be less than 0");
+	}
+	return size;
+}
+
+static int
+box_check_sql_sort_threads(int threads)
+{
+	if (threads < 0 || threads > SQL_SORT_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "sql_sort_threads",
+			  tt_sprintf("must be in range [0, %d]",
+				     SQL_SORT_THREADS_MAX));
+	}
+	return threads;
+}
+
 static void
 box_check_vinyl_options(void)
 {
@@ -630,13 +721,21 @@ box_check_config()
 	box_check_replication_sync_lag();
 	box_check_replication_sync_timeout();
 	box_check_readahead(cfg_geti("readahead"));
+	box_check_iproto_threads();
+	box_check_iproto_read_threads();
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
 	box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
+	box_check_wal_batch_max_delay(cfg_getd("wal_batch_max_delay"));
+	box_check_wal_batch_max_bytes(cfg_geti64("wal_batch_max_bytes"));
+	box_check_wal_cache_size(cfg_geti64("wal_cache_size"));
 	box_check_memtx_memory(cfg_geti64("memtx_memory"));
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
+	box_check_memtx_sort_threads(cfg_geti("memtx_sort_threads"));
 	box_check_vinyl_options();
+	box_check_sql_cache_size(cfg_geti64("sql_cache_size"));
+	box_check_sql_sort_threads(cfg_geti("sql_sort_threads"));
 }
 
 /*
@@ -823,6 +922,16 @@ box_set_memtx_max_tuple_size(void)
 			cfg_geti("memtx_max_tuple_size"));
 }
 
+void
+box_set_memtx_sort_threads(void)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_sort_threads(memtx,
+		box_check_memtx_sort_threads(cfg_geti("memtx_sort_threads")));
+}
+
 void
 box_set_too_long_threshold(void)
 {
@@ -864,6 +973,23 @@ box_set_checkpoint_wal_threshold(void)
 	wal_set_checkpoint_threshold(threshold);
 }
 
+void
+box_set_wal_batch(void)
+{
+	double delay = box_check_wal_batch_max_delay(
+			cfg_getd("wal_batch_max_delay"));
+	int64_t bytes = box_check_wal_batch_max_bytes(
+			cfg_geti64("wal_batch_max_bytes"));
+	wal_set_batch(delay, bytes);
+}
+
+void
+box_set_wal_cache_size(void)
+{
+	wal_set_cache_size(box_check_wal_cache_size(
+			cfg_geti64("wal_cache_size")));
+}
+
 void
 box_set_vinyl_memory(void)
 {
@@ -893,6 +1019,15 @@ box_set_vinyl_cache(void)
 	vinyl_engine_set_cache(vinyl, cfg_geti64("vinyl_cache"));
 }
 
+void
+box_set_vinyl_page_cache(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_page_cache(vinyl, cfg_geti64("vinyl_page_cache"));
+}
+
 void
 box_set_vinyl_timeout(void)
 {
@@ -902,13 +1037,28 @@ box_set_vinyl_timeout(void)
 	vinyl_engine_set_timeout(vinyl,	cfg_getd("vinyl_timeout"));
 }
 
+void
+box_set_sql_cache_size(void)
+{
+	sql_stmt_cache_set_size(
+		box_check_sql_cache_size(cfg_geti64("sql_cache_size")));
+}
+
+void
+box_set_sql_sort_threads(void)
+{
+	sql_set_sort_threads(
+		box_check_sql_sort_threads(cfg_geti("sql_sort_threads")));
+}
+
 void
 box_set_net_msg_max(void)
 {
 	int new_iproto_msg_max = cfg_geti("net_msg_max");
 	iproto_set_msg_max(new_iproto_msg_max);
+	/* net_msg_max limits requests of each network thread. */
 	fiber_pool_set_max_size(&tx_fiber_pool,
-				new_iproto_msg_max *
+				new_iproto_msg_max * iproto_threads_count *
 				IPROTO_FIBER_POOL_SIZE_FACTOR);
 }
 
@@ -1050,52 +1200,68 @@ box_process1(struct request *request, box_tuple_t **result)
 	return box_process_rw(request, space, result);
 }
 
-int
-box_select(uint32_t space_id, uint32_t index_id,
-	   int iterator, uint32_t offset, uint32_t limit,
-	   const char *key, const char *key_end,
-	   struct port *port)
+/**
+ * Check a SELECT request, begin a read-only statement and
+ * create an iterator over the requested index. On success
+ * the caller must end the statement.
+ */
+static struct iterator *
+box_select_begin(uint32_t space_id, uint32_t index_id, int iterator,
+		 const char *key, struct txn **txn)
 {
-	(void)key_end;
-
 	rmean_collect(rmean_box, IPROTO_SELECT, 1);
 
 	if (iterator < 0 || iterator >= iterator_type_MAX) {
 		diag_set(ClientError, ER_ILLEGAL_PARAMS,
 			 "Invalid iterator type");
 		diag_log();
-		return -1;
+		return NULL;
 	}
 
 	struct space *space = space_cache_find(space_id);
 	if (space == NULL)
-		return -1;
+		return NULL;
 	if (access_check_space(space, PRIV_R) != 0)
-		return -1;
+		return NULL;
 	struct index *index = index_find(space, index_id);
 	if (index == NULL)
-		return -1;
+		return NULL;
 
 	enum iterator_type type = (enum iterator_type) iterator;
 	uint32_t part_count = key ? mp_decode_array(&key) : 0;
 	if (key_validate(index->def, type, key, part_count))
-		return -1;
+		return NULL;
 
 	ERROR_INJECT(ERRINJ_TESTING, {
 		diag_set(ClientError, ER_INJECTION, "ERRINJ_TESTING");
-		return -1;
+		return NULL;
 	});
 
-	struct txn *txn;
-	if (txn_begin_ro_stmt(space, &txn) != 0)
-		return -1;
+	if (txn_begin_ro_stmt(space, txn) != 0)
+		return NULL;
 
 	struct iterator *it = index_create_iterator(index, type,
 						    key, part_count);
 	if (it == NULL) {
 		txn_rollback_stmt();
-		return -1;
+		return NULL;
 	}
+	return it;
+}
+
+int
+box_select(uint32_t space_id, uint32_t index_id,
+	   int iterator, uint32_t offset, uint32_t limit,
+	   const char *key, const char *key_end,
+	   struct port *port)
+{
+	(void)key_end;
+
+	struct txn *txn;
+	struct iterator *it = box_select_begin(space_id, index_id, iterator,
+					       key, &txn);
+	if (it == NULL)
+		return -1;
 
 	int rc = 0;
 	uint32_t found = 0;
@@ -1125,6 +1291,60 @@ box_select(uint32_t space_id, uint32_t index_id,
 	return 0;
 }
 
+bool
+box_select_can_stream(uint32_t space_id)
+{
+	struct space *space = space_by_id(space_id);
+	return space != NULL &&
+	       (space->engine->flags & ENGINE_READ_NO_YIELD) != 0;
+}
+
+int
+box_select_to_obuf(uint32_t space_id, uint32_t index_id,
+		   int iterator, uint32_t offset, uint32_t limit,
+		   const char *key, const char *key_end,
+		   struct obuf *out)
+{
+	(void)key_end;
+	assert(box_select_can_stream(space_id));
+
+	struct txn *txn;
+	struct iterator *it = box_select_begin(space_id, index_id, iterator,
+					       key, &txn);
+	if (it == NULL)
+		return -1;
+
+	int rc = 0;
+	uint32_t found = 0;
+	struct tuple *tuple;
+	while (found < limit) {
+		rc = iterator_next(it, &tuple);
+		if (rc != 0 || tuple == NULL)
+			break;
+		if (offset > 0) {
+			offset--;
+			continue;
+		}
+		rc = tuple_to_obuf(tuple, out);
+		ERROR_INJECT(ERRINJ_PORT_DUMP, {
+			diag_set(OutOfMemory, tuple_size(tuple), "obuf_dup",
+				 "data");
+			rc = -1;
+		});
+		if (rc != 0)
+			break;
+		found++;
+	}
+	iterator_delete(it);
+
+	if (rc != 0) {
+		txn_rollback_stmt();
+		return -1;
+	}
+	txn_commit_ro_stmt(txn);
+	return found;
+}
+
 int
 box_insert(uint32_t space_id, const char *tuple, const char *tuple_end,
 	   box_tuple_t **result)
@@ -1706,6 +1926,7 @@ engine_init()
 	 * so it must be registered first.
 	 */
 	struct memtx_engine *memtx;
+	memtx_tx_manager_use_mvcc_engine = cfg_getb("memtx_use_mvcc_engine");
 	memtx = memtx_engine_new_xc(cfg_gets("memtx_dir"),
 				    cfg_geti("force_recovery"),
 				    cfg_getd("memtx_memory"),
@@ -1713,6 +1934,7 @@ engine_init()
 				    cfg_getd("slab_alloc_factor"));
 	engine_register((struct engine *)memtx);
 	box_set_memtx_max_tuple_size();
+	box_set_memtx_sort_threads();
 
 	struct sysview_engine *sysview = sysview_engine_new_xc();
 	engine_register((struct engine *)sysview);
@@ -1729,6 +1951,7 @@ engine_init()
 	engine_register((struct engine *)vinyl);
 	box_set_vinyl_max_tuple_size();
 	box_set_vinyl_cache();
+	box_set_vinyl_page_cache();
 	box_set_vinyl_timeout();
 }
 
@@ -2082,8 +2305,11 @@ box_cfg_xc(void)
 	schema_init();
 	replication_init();
 	port_init();
-	iproto_init();
+	iproto_init(box_check_iproto_threads(),
+		    box_check_iproto_read_threads());
 	sql_init();
+	box_set_sql_cache_size();
+	box_set_sql_sort_threads();
 	wal_thread_start();
 
 	title("loading");
@@ -2264,4 +2490,6 @@ box_reset_stat(void)
 	rmean_cleanup(rmean_error);
 	engine_reset_stat();
 	space_foreach(box_reset_space_stat, NULL);
+	wal_reset_stat();
+	sql_stmt_cache_reset_stat();
 }
@@ -196,11 +196,15 @@ void box_set_readahead(void);
 void box_set_checkpoint_count(void);
 void box_set_checkpoint_interval(void);
 void box_set_checkpoint_wal_threshold(void);
+void box_set_wal_batch(void);
+void box_set_wal_cache_size(void);
 void box_set_memtx_memory(void);
 void box_set_memtx_max_tuple_size(void);
+void box_set_memtx_sort_threads(void);
 void box_set_vinyl_memory(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_cache(void);
+void box_set_vinyl_page_cache(void);
 void box_set_vinyl_timeout(void);
 void box_set_replication_timeout(void);
 void box_set_replication_connect_timeout(void);
@@ -209,6 +213,8 @@ void box_set_replication_sync_lag(void);
 void box_set_replication_sync_timeout(void);
 void box_set_replication_skip_conflict(void);
 void box_set_net_msg_max(void);
+void box_set_sql_cache_size(void);
+void box_set_sql_sort_threads(void);
 
 extern "C" {
 #endif /* defined(__cplusplus) */
@@ -222,6 +228,30 @@ box_select(uint32_t space_id, uint32_t index_id,
 	   const char *key, const char *key_end,
 	   struct port *port);
 
+/**
+ * Return true if tuples selected from the space can be written
+ * directly to an output buffer with box_select_to_obuf(), i.e.
+ * if the space engine never yields while reading.
+ */
+bool
+box_select_can_stream(uint32_t space_id);
+
+/**
+ * Same as box_select(), but encodes found tuples directly to
+ * @a out as they are read instead of collecting them in a port
+ * first. The space must satisfy box_select_can_stream(), so that
+ * no other fiber can write to @a out in the meantime.
+ *
+ * @retval >= 0 Number of tuples written to @a out.
+ * @retval -1 Error, diag is set, @a out must be rolled back
+ *            by the caller.
+ */
+int
+box_select_to_obuf(uint32_t space_id, uint32_t index_id,
+		   int iterator, uint32_t offset, uint32_t limit,
+		   const char *key, const char *key_end,
+		   struct obuf *out);
+
 /** \cond public */
 
 /*
@@ -199,6 +199,12 @@ enum {
 	 * transactions w/o throwing ER_CROSS_ENGINE_TRANSACTION.
 	 */
 	ENGINE_BYPASS_TX = 1 << 0,
+	/**
+	 * If set, index iterators of the engine's spaces never
+	 * yield, so read results may be written straight to an
+	 * output buffer shared with other fibers.
+	 */
+	ENGINE_READ_NO_YIELD = 1 << 1,
 };
 
 struct engine {
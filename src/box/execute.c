@@ -40,6 +40,7 @@
 #include "sql.h"
 #include "xrow.h"
 #include "schema.h"
+#include "sql_stmt_cache.h"
 #include "port.h"
 #include "tuple.h"
 #include "sql/vdbe.h"
@@ -528,30 +529,69 @@ sql_execute(sqlite3 *db, struct sqlite3_stmt *stmt, struct port *port,
 	return 0;
 }
 
+/**
+ * Bind parameters to a statement acquired from the statement
+ * cache and execute it. The statement is released on error.
+ */
+static int
+sql_execute_cached(struct sqlite3_stmt *stmt,
+		   struct sql_stmt_cache_entry *entry,
+		   const struct sql_bind *bind, uint32_t bind_count,
+		   struct sql_response *response, struct region *region)
+{
+	port_tuple_create(&response->port);
+	response->prep_stmt = stmt;
+	response->cache_entry = entry;
+	if (sql_bind(stmt, bind, bind_count) == 0 &&
+	    sql_execute(sql_get(), stmt, &response->port, region) == 0)
+		return 0;
+	port_destroy(&response->port);
+	sql_stmt_cache_release(entry, stmt);
+	return -1;
+}
+
+int
+sql_prepare(const char *sql, int len, uint32_t *stmt_id)
+{
+	if (sql_get() == NULL) {
+		diag_set(ClientError, ER_LOADING);
+		return -1;
+	}
+	return sql_stmt_cache_prepare(sql, len, stmt_id);
+}
+
 int
 sql_prepare_and_execute(const char *sql, int len, const struct sql_bind *bind,
 			uint32_t bind_count, struct sql_response *response,
 			struct region *region)
 {
 	struct sqlite3_stmt *stmt;
-	sqlite3 *db = sql_get();
-	if (db == NULL) {
+	struct sql_stmt_cache_entry *entry;
+	if (sql_get() == NULL) {
 		diag_set(ClientError, ER_LOADING);
 		return -1;
 	}
-	if (sqlite3_prepare_v2(db, sql, len, &stmt, NULL) != SQLITE_OK) {
-		diag_set(ClientError, ER_SQL_EXECUTE, sqlite3_errmsg(db));
+	if (sql_stmt_cache_acquire(sql, len, &stmt, &entry) != 0)
+		return -1;
+	return sql_execute_cached(stmt, entry, bind, bind_count, response,
+				  region);
+}
+
+int
+sql_execute_prepared(uint32_t stmt_id, const struct sql_bind *bind,
+		     uint32_t bind_count, struct sql_response *response,
+		     struct region *region)
+{
+	struct sqlite3_stmt *stmt;
+	struct sql_stmt_cache_entry *entry;
+	if (sql_get() == NULL) {
+		diag_set(ClientError, ER_LOADING);
 		return -1;
 	}
-	assert(stmt != NULL);
-	port_tuple_create(&response->port);
-	response->prep_stmt = stmt;
-	if (sql_bind(stmt, bind, bind_count) == 0 &&
-	    sql_execute(db, stmt, &response->port, region) == 0)
-		return 0;
-	port_destroy(&response->port);
-	sqlite3_finalize(stmt);
-	return -1;
+	if (sql_stmt_cache_acquire_by_id(stmt_id, &stmt, &entry) != 0)
+		return -1;
+	return sql_execute_cached(stmt, entry, bind, bind_count, response,
+				  region);
 }
 
 int
@@ -635,6 +675,6 @@ err:
 	}
 finish:
 	port_destroy(&response->port);
-	sqlite3_finalize(stmt);
+	sql_stmt_cache_release(response->cache_entry, stmt);
 	return rc;
 }
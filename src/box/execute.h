@@ -51,6 +51,7 @@ extern const char *sql_info_key_strs[];
 struct obuf;
 struct region;
 struct sql_bind;
+struct sql_stmt_cache_entry;
 
 /** Response on EXECUTE request. */
 struct sql_response {
@@ -58,6 +59,8 @@ struct sql_response {
 	struct port port;
 	/** Prepared SQL statement with metadata. */
 	void *prep_stmt;
+	/** Statement cache entry of @a prep_stmt or NULL. */
+	struct sql_stmt_cache_entry *cache_entry;
 };
 
 /**
@@ -115,7 +118,8 @@ int
 sql_response_dump(struct sql_response *response, int *keys, struct obuf *out);
 
 /**
- * Prepare and execute an SQL statement.
+ * Prepare and execute an SQL statement. The compiled statement
+ * is taken from the statement cache if it is there.
  * @param sql SQL statement.
  * @param len Length of @a sql.
  * @param bind Array of parameters.
@@ -132,6 +136,36 @@ sql_prepare_and_execute(const char *sql, int len, const struct sql_bind *bind,
 			uint32_t bind_count, struct sql_response *response,
 			struct region *region);
 
+/**
+ * Compile an SQL statement and store it in the statement cache
+ * for later execution with sql_execute_prepared().
+ * @param sql SQL statement.
+ * @param len Length of @a sql.
+ * @param[out] stmt_id Id of the prepared statement.
+ *
+ * @retval  0 Success.
+ * @retval -1 Client or memory error.
+ */
+int
+sql_prepare(const char *sql, int len, uint32_t *stmt_id);
+
+/**
+ * Execute an SQL statement prepared with sql_prepare().
+ * @param stmt_id Id of the prepared statement.
+ * @param bind Array of parameters.
+ * @param bind_count Length of @a bind.
+ * @param[out] response Response to store result.
+ * @param region Runtime allocator for temporary objects
+ *        (columns, tuples ...).
+ *
+ * @retval  0 Success.
+ * @retval -1 Client or memory error.
+ */
+int
+sql_execute_prepared(uint32_t stmt_id, const struct sql_bind *bind,
+		     uint32_t bind_count, struct sql_response *response,
+		     struct region *region);
+
 #if defined(__cplusplus)
 } /* extern "C" { */
 #endif
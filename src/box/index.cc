@@ -493,6 +493,7 @@ index_create(struct index *index, struct engine *engine,
 	index->engine = engine;
 	index->def = def;
 	index->space_cache_version = space_cache_version;
+	index->sketch = NULL;
 	return 0;
 }
 
@@ -45,6 +45,7 @@ struct index;
 struct index_def;
 struct key_def;
 struct info_handler;
+struct tuple_sketch;
 
 /** \cond public */
 
@@ -456,6 +457,12 @@ struct index {
 	struct index_def *def;
 	/* Space cache version at the time of construction. */
 	uint32_t space_cache_version;
+	/**
+	 * Distinct key estimates maintained by the engine on
+	 * write or NULL if the engine doesn't collect them.
+	 * Used by the SQL planner. Owned by the engine.
+	 */
+	struct tuple_sketch *sketch;
 };
 
 /**
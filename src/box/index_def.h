@@ -153,6 +153,11 @@ struct index_opts {
 	double run_size_ratio;
 	/* Bloom filter false positive rate. */
 	double bloom_fpr;
+	/**
+	 * Maintain distinct key estimates for the SQL planner
+	 * on write, see index::sketch.
+	 */
+	bool sketch;
 	/**
 	 * LSN from the time of index creation.
 	 */
@@ -212,6 +217,8 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		return o1->run_size_ratio < o2->run_size_ratio ? -1 : 1;
 	if (o1->bloom_fpr != o2->bloom_fpr)
 		return o1->bloom_fpr < o2->bloom_fpr ? -1 : 1;
+	if (o1->sketch != o2->sketch)
+		return o1->sketch < o2->sketch ? -1 : 1;
 	if ((o1->sql == NULL) != (o2->sql == NULL))
 		return 1;
 	if (o1->sql != NULL)
@@ -34,12 +34,14 @@
 #include <stdio.h>
 
 #include <msgpuck.h>
+#include <pmatomic.h>
 #include <small/ibuf.h>
 #include <small/obuf.h>
 #include "third_party/base64.h"
 
 #include "version.h"
 #include "fiber.h"
+#include "fiber_cond.h"
 #include "cbus.h"
 #include "say.h"
 #include "sio.h"
@@ -48,6 +50,7 @@
 #include "scoped_guard.h"
 #include "memory.h"
 #include "random.h"
+#include "assoc.h"
 
 #include "port.h"
 #include "box.h"
@@ -56,10 +59,15 @@
 #include "session.h"
 #include "xrow.h"
 #include "schema.h" /* schema_version */
+#include "space.h"
+#include "user.h"
+#include "tuple.h"
+#include "memtx_hash.h"
 #include "replication.h" /* instance_uuid */
 #include "iproto_constants.h"
 #include "rmean.h"
 #include "execute.h"
+#include "txn.h"
 #include "errinj.h"
 
 enum {
@@ -124,7 +132,11 @@ struct iproto_kharon {
  */
 unsigned iproto_readahead = 16320;
 
-/* The maximal number of iproto messages in fly. */
+/**
+ * The maximal number of iproto messages in fly. Owned by
+ * the tx thread, network threads use their own copy, see
+ * iproto_thread::msg_max.
+ */
 static int iproto_msg_max = IPROTO_MSG_MAX_MIN;
 
 /**
@@ -156,6 +168,8 @@ iproto_reset_input(struct ibuf *ibuf)
 
 /* {{{ iproto_msg - declaration */
 
+struct iproto_stream;
+
 /**
  * A single msg from io thread. All requests
  * from all connections are queued into a single queue
@@ -176,7 +190,7 @@ struct iproto_msg
 		struct call_request call;
 		/** Authentication request. */
 		struct auth_request auth;
-		/* SQL request, if this is the EXECUTE request. */
+		/* SQL request, if this is EXECUTE or PREPARE. */
 		struct sql_request sql;
 		/** In case of iproto parse error, saved diagnostics. */
 		struct diag diag;
@@ -213,75 +227,250 @@ struct iproto_msg
 	 * and the connection must be closed.
 	 */
 	bool close_connection;
+	/**
+	 * Stream executing the request or NULL if the request
+	 * doesn't belong to a stream. Set by the tx thread when
+	 * the request is queued to the stream and reset when
+	 * it has been executed.
+	 */
+	struct iproto_stream *stream;
+	/** Link in iproto_stream::pending. */
+	struct stailq_entry in_stream;
+	/**
+	 * Read view the request is served from by a reader
+	 * thread or NULL if it is executed by the tx thread.
+	 */
+	struct iproto_read_view *read_view;
+	/** Index of the read view to look the key up in. */
+	struct iproto_read_view_index *read_view_index;
+	/**
+	 * Reply prepared by a reader thread or NULL if the
+	 * request has to be executed by the tx thread after all.
+	 */
+	struct iproto_read_reply *read_reply;
+	/**
+	 * True if reads of the connection must not be offloaded
+	 * while the request is in progress, see
+	 * iproto_connection::tx_barrier_count.
+	 */
+	bool is_tx_barrier;
 };
 
-static struct mempool iproto_msg_pool;
+enum rmean_net_name {
+	IPROTO_SENT,
+	IPROTO_RECEIVED,
+	/** Requests served by reader threads. */
+	IPROTO_OFFLOADED,
+	IPROTO_LAST,
+};
 
-static struct iproto_msg *
-iproto_msg_new(struct iproto_connection *con);
+const char *rmean_net_strings[IPROTO_LAST] = {
+	"SENT", "RECEIVED", "OFFLOADED"
+};
 
 /**
- * Resume stopped connections, if any.
+ * Context of a network thread. Each network thread runs its
+ * own event loop, accepts its share of client connections
+ * and talks to the tx thread over its own pair of pipes, so
+ * that connections served by different threads never contend
+ * for the same buffers, message pools or cbus queues.
  */
-static void
-iproto_resume();
-
-static void
-iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
-		  bool *stop_input);
+struct iproto_thread {
+	/** Thread id, an index in iproto_threads array. */
+	int id;
+	/**
+	 * Slab cache used for allocating memory for output
+	 * network buffers in the tx thread.
+	 */
+	struct slab_cache net_slabc;
+	/** Network thread. */
+	struct cord net_cord;
+	/**
+	 * A single queue for all requests in all connections
+	 * of this thread. All requests from all connections are
+	 * processed concurrently. Is also used as a queue for
+	 * just established connections and to execute
+	 * disconnect triggers. A few notes about these triggers:
+	 * - they need to be run in a fiber
+	 * - unlike an ordinary request failure, on_connect
+	 *   trigger failure must lead to connection close.
+	 * - on_connect trigger must be processed before any
+	 *   other request on this connection.
+	 */
+	struct cpipe tx_pipe;
+	struct cpipe net_pipe;
+	/** Pool of iproto messages allocated in this thread. */
+	struct mempool iproto_msg_pool;
+	/** Pool of connections served by this thread. */
+	struct mempool iproto_connection_pool;
+	/** Connections with input stopped by net_msg_max limit. */
+	struct rlist stopped_connections;
+	/**
+	 * The maximal number of iproto messages in fly in this
+	 * thread, a copy of iproto_msg_max updated by
+	 * IPROTO_CFG_MSG_MAX.
+	 */
+	int msg_max;
+	/** Network statistics of this thread. */
+	struct rmean *rmean;
+	/** iproto binary listener. */
+	struct evio_service binary;
+	/**
+	 * Message routes. They refer to the thread pipes, so
+	 * every thread has its own copy, see
+	 * iproto_thread_init_routes().
+	 */
+	struct cmsg_hop destroy_route[2];
+	struct cmsg_hop push_route[2];
+	struct cmsg_hop misc_route[2];
+	struct cmsg_hop call_route[2];
+	struct cmsg_hop select_route[2];
+	struct cmsg_hop process1_route[2];
+	struct cmsg_hop sql_route[2];
+	struct cmsg_hop join_route[2];
+	struct cmsg_hop subscribe_route[2];
+	struct cmsg_hop error_route[2];
+	struct cmsg_hop connect_route[2];
+	struct cmsg_hop stream_route[2];
+	const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX];
+	/**
+	 * Read view to serve SELECTs from or NULL. Installed
+	 * by the tx thread, see iproto_read_view.
+	 */
+	struct iproto_read_view *read_view;
+	/** Pipes to reader threads, by reader id. */
+	struct cpipe *reader_pipes;
+	/** Reader thread to send the next offloaded request to. */
+	int next_reader;
+};
 
-static inline void
-iproto_msg_delete(struct iproto_msg *msg)
-{
-	mempool_free(&iproto_msg_pool, msg);
-	iproto_resume();
-}
+/** Network threads, box.cfg.iproto_threads. */
+static struct iproto_thread *iproto_threads;
+int iproto_threads_count;
 
 /**
- * A single global queue for all requests in all connections. All
- * requests from all connections are processed concurrently.
- * Is also used as a queue for just established connections and to
- * execute disconnect triggers. A few notes about these triggers:
- * - they need to be run in a fiber
- * - unlike an ordinary request failure, on_connect trigger
- *   failure must lead to connection close.
- * - on_connect trigger must be processed before any other
- *   request on this connection.
+ * A read view of memtx HASH indexes. A SELECT looking up a full
+ * key in such an index is served from the view by a reader
+ * thread, box.cfg.iproto_read_threads, instead of the tx thread,
+ * so that point lookups don't queue up behind writes.
+ *
+ * The view is created by the tx thread and installed in the
+ * network threads, which send eligible requests to the readers.
+ * A request of a connection is eligible only if there are no
+ * other requests of the connection but SELECTs in progress in tx
+ * and the view is newer than the replies the connection has got,
+ * so that a client reads its own writes.
+ *
+ * Every IPROTO_READ_VIEW_PERIOD seconds the tx thread checks if
+ * any transaction has ended since the view was created. If not,
+ * the view is up to date and only gets a new generation. Else it
+ * is removed from the network threads, deleted as soon as the
+ * last request served from it ends, and a new one is created.
+ * The views keep the memtx allocator in the delayed free mode.
+ * Tuples freed while a view exists are freed for real before
+ * the next view enters the mode, see
+ * memtx_enter_delayed_free_mode().
  */
-static struct cpipe tx_pipe;
-static struct cpipe net_pipe;
+struct iproto_read_view {
+	/**
+	 * Generation of the view, see iproto_read_view_gen.
+	 * Raised by tx while the view is in use.
+	 */
+	uint64_t gen;
+	/** Schema version at the time the view was created. */
+	uint32_t schema_version;
+	/** txn_end_count at the time the view was created. */
+	int64_t txn_end_count;
+	/**
+	 * Number of requests being served from the view plus
+	 * the number of network threads it is installed in.
+	 */
+	int refs;
+	/**
+	 * Sent to tx by the network thread that drops the last
+	 * reference to the view.
+	 */
+	struct cmsg release_msg;
+	/** Set in tx when the last reference has been dropped. */
+	bool is_released;
+	/** Signaled when is_released is set. */
+	struct fiber_cond release_cond;
+	/** (space id << 32 | index id) -> iproto_read_view_index. */
+	struct mh_i64ptr_t *indexes;
+};
+
+/** A HASH index in a read view. */
+struct iproto_read_view_index {
+	struct memtx_hash_read_view *rv;
+	/** Auth tokens of the users that may read the space. */
+	uint32_t readers;
+};
+
+static_assert(BOX_USER_MAX <= sizeof(uint32_t) * CHAR_BIT,
+	      "auth tokens must fit in iproto_read_view_index::readers");
+
+/** A SELECT reply prepared by a reader thread. */
+struct iproto_read_reply {
+	/** Link in iproto_connection::read_replies. */
+	struct stailq_entry in_queue;
+	/** Size of the reply. */
+	size_t size;
+	/** Encoded iproto header and body. */
+	char data[0];
+};
 
 /**
- * Network thread.
+ * Generation of the latest read view. Incremented by the tx
+ * thread right before it creates a view, loaded by network
+ * threads when they get a reply from tx.
  */
-static struct cord net_cord;
+static uint64_t iproto_read_view_gen;
+
+/** How often read views are recreated, in seconds. */
+static const double IPROTO_READ_VIEW_PERIOD = 0.01;
 
 /**
- * Slab cache used for allocating memory for output network buffers
- * in the tx thread.
+ * Context of a reader thread. A reader has no state of its
+ * own: a request carries the read view it is served from.
  */
-static struct slab_cache net_slabc;
+struct iproto_reader {
+	/** Reader id, an index in iproto_readers array. */
+	int id;
+	/** Reader thread. */
+	struct cord cord;
+	/** Pipes to network threads, by thread id. */
+	struct cpipe *net_pipes;
+};
 
-struct rmean *rmean_net;
+/** Reader threads, box.cfg.iproto_read_threads. */
+static struct iproto_reader *iproto_readers;
+static int iproto_readers_count;
 
-enum rmean_net_name {
-	IPROTO_SENT,
-	IPROTO_RECEIVED,
-	IPROTO_LAST,
-};
+static struct iproto_msg *
+iproto_msg_new(struct iproto_connection *con);
 
-const char *rmean_net_strings[IPROTO_LAST] = { "SENT", "RECEIVED" };
+/**
+ * Resume stopped connections of a network thread, if any.
+ */
+static void
+iproto_resume(struct iproto_thread *iproto_thread);
+
+static void
+iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
+		  bool *stop_input);
+
+static inline void
+iproto_msg_delete(struct iproto_msg *msg);
 
 static void
 tx_process_destroy(struct cmsg *m);
 
+/** Roll back open stream transactions and stop stream fibers. */
 static void
-net_finish_destroy(struct cmsg *m);
+tx_destroy_streams(struct iproto_connection *con);
 
-static const struct cmsg_hop destroy_route[] = {
-	{ tx_process_destroy, &net_pipe },
-	{ net_finish_destroy, NULL },
-};
+static void
+net_finish_destroy(struct cmsg *m);
 
 /** Fire on_disconnect triggers in the tx thread. */
 static void
@@ -291,6 +480,47 @@ static const struct cmsg_hop disconnect_route[] = {
 	{ tx_process_disconnect, NULL }
 };
 
+/**
+ * Send a request to a reader thread if it can be served from
+ * the read view installed in the network thread.
+ * @retval true The request has been sent to a reader.
+ * @retval false The request must be sent to the tx thread.
+ */
+static bool
+iproto_msg_offload(struct iproto_msg *msg);
+
+/** Serve a SELECT from a read view in a reader thread. */
+static void
+reader_process_select(struct cmsg *m);
+
+/**
+ * Queue the reply prepared by a reader thread for sending or
+ * pass the request to the tx thread if the reader couldn't
+ * serve it.
+ */
+static void
+net_end_read(struct cmsg *m);
+
+/**
+ * The routes don't have pipes: the reader and the network
+ * thread the request comes from are chosen per request.
+ */
+static const struct cmsg_hop read_route[] = {
+	{ reader_process_select, NULL }
+};
+
+static const struct cmsg_hop read_reply_route[] = {
+	{ net_end_read, NULL }
+};
+
+/** Wake up the tx fiber waiting for a read view to be released. */
+static void
+tx_release_read_view(struct cmsg *m);
+
+static const struct cmsg_hop read_view_release_route[] = {
+	{ tx_release_read_view, NULL }
+};
+
 /**
  * Kharon is in the dead world (iproto). Schedule an event to
  * flush new obuf as reflected in the fresh wpos.
@@ -308,11 +538,6 @@ iproto_process_push(struct cmsg *m);
 static void
 tx_end_push(struct cmsg *m);
 
-static const struct cmsg_hop push_route[] = {
-	{ iproto_process_push, &tx_pipe },
-	{ tx_end_push, NULL }
-};
-
 
 /* }}} */
 
@@ -402,6 +627,28 @@ struct iproto_connection
 	 * connections.
 	 */
 	int long_poll_count;
+	/**
+	 * Replies prepared by reader threads, in order of
+	 * arrival. They are written to the socket between
+	 * the replies of the tx thread, see iproto_flush().
+	 */
+	struct stailq read_replies;
+	/** How much of the first reader reply has been written. */
+	size_t read_reply_offset;
+	/**
+	 * Number of requests other than SELECTs sent to the tx
+	 * thread and not replied yet. SELECTs aren't offloaded
+	 * to reader threads while there are any, so that they
+	 * don't overtake a write or an authentication.
+	 */
+	int tx_barrier_count;
+	/**
+	 * Minimal generation of a read view SELECTs of the
+	 * connection can be served from. Bumped when a barrier
+	 * request is replied, so that the client sees its
+	 * changes.
+	 */
+	uint64_t min_read_view_gen;
 	struct ev_io input;
 	struct ev_io output;
 	/** Logical session. */
@@ -470,32 +717,36 @@ struct iproto_connection
 		 * return.
 		 */
 		bool is_push_pending;
+		/**
+		 * Streams of the connection, stream id ->
+		 * struct iproto_stream. Created on demand.
+		 */
+		struct mh_i64ptr_t *streams;
 	} tx;
 	/** Authentication salt. */
 	char salt[IPROTO_SALT_SIZE];
+	/** Network thread serving the connection. */
+	struct iproto_thread *iproto_thread;
 };
 
-static struct mempool iproto_connection_pool;
-static RLIST_HEAD(stopped_connections);
-
 /**
  * Return true if we have not enough spare messages
- * in the message pool.
+ * in the message pool of a network thread.
  */
 static inline bool
-iproto_check_msg_max()
+iproto_check_msg_max(struct iproto_thread *iproto_thread)
 {
-	size_t request_count = mempool_count(&iproto_msg_pool);
-	return request_count > (size_t) iproto_msg_max;
+	size_t request_count = mempool_count(&iproto_thread->iproto_msg_pool);
+	return request_count > (size_t) iproto_thread->msg_max;
 }
 
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con)
 {
-	struct iproto_msg *msg =
-		(struct iproto_msg *) mempool_alloc(&iproto_msg_pool);
+	struct mempool *pool = &con->iproto_thread->iproto_msg_pool;
+	struct iproto_msg *msg = (struct iproto_msg *) mempool_alloc(pool);
 	ERROR_INJECT(ERRINJ_TESTING, {
-		mempool_free(&iproto_msg_pool, msg);
+		mempool_free(pool, msg);
 		msg = NULL;
 	});
 	if (msg == NULL) {
@@ -505,9 +756,35 @@ iproto_msg_new(struct iproto_connection *con)
 		return NULL;
 	}
 	msg->connection = con;
+	msg->stream = NULL;
+	msg->read_view = NULL;
+	msg->read_view_index = NULL;
+	msg->read_reply = NULL;
+	msg->is_tx_barrier = false;
 	return msg;
 }
 
+static inline void
+iproto_msg_delete(struct iproto_msg *msg)
+{
+	struct iproto_connection *con = msg->connection;
+	struct iproto_thread *iproto_thread = con->iproto_thread;
+	assert(msg->read_view == NULL && msg->read_reply == NULL);
+	if (msg->is_tx_barrier) {
+		assert(con->tx_barrier_count > 0);
+		con->tx_barrier_count--;
+		/*
+		 * Read views created or given a new generation
+		 * from now on include the changes made by the
+		 * request.
+		 */
+		con->min_read_view_gen =
+			pm_atomic_load(&iproto_read_view_gen) + 1;
+	}
+	mempool_free(&iproto_thread->iproto_msg_pool, msg);
+	iproto_resume(iproto_thread);
+}
+
 /**
  * A connection is idle when the client is gone
  * and there are no outstanding msgs in the msg queue.
@@ -559,7 +836,8 @@ iproto_connection_stop_msg_max_limit(struct iproto_connection *con)
 	 * Important to add to tail and fetch from head to ensure
 	 * strict lifo order (fairness) for stopped connections.
 	 */
-	rlist_add_tail(&stopped_connections, &con->in_stop_list);
+	rlist_add_tail(&con->iproto_thread->stopped_connections,
+		       &con->in_stop_list);
 }
 
 /**
@@ -586,7 +864,8 @@ iproto_connection_close(struct iproto_connection *con)
 		 * is done only once.
 		 */
 		con->p_ibuf->wpos -= con->parse_size;
-		cpipe_push(&tx_pipe, &con->disconnect_msg);
+		cpipe_push(&con->iproto_thread->tx_pipe,
+			   &con->disconnect_msg);
 	}
 	/*
 	 * If the connection has no outstanding requests in the
@@ -603,7 +882,7 @@ iproto_connection_close(struct iproto_connection *con)
 	if (iproto_connection_is_idle(con)) {
 		assert(! con->is_destroy_sent);
 		con->is_destroy_sent = true;
-		cpipe_push(&tx_pipe, &con->destroy_msg);
+		cpipe_push(&con->iproto_thread->tx_pipe, &con->destroy_msg);
 	}
 	rlist_del(&con->in_stop_list);
 }
@@ -712,13 +991,14 @@ static inline int
 iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 {
 	assert(rlist_empty(&con->in_stop_list));
+	struct cpipe *tx_pipe = &con->iproto_thread->tx_pipe;
 	int n_requests = 0;
 	bool stop_input = false;
 	const char *errmsg;
 	while (con->parse_size != 0 && !stop_input) {
-		if (iproto_check_msg_max()) {
+		if (iproto_check_msg_max(con->iproto_thread)) {
 			iproto_connection_stop_msg_max_limit(con);
-			cpipe_flush_input(&tx_pipe);
+			cpipe_flush_input(tx_pipe);
 			return 0;
 		}
 		const char *reqstart = in->wpos - con->parse_size;
@@ -727,7 +1007,7 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		if (mp_typeof(*pos) != MP_UINT) {
 			errmsg = "packet length";
 err_msgpack:
-			cpipe_flush_input(&tx_pipe);
+			cpipe_flush_input(tx_pipe);
 			diag_set(ClientError, ER_INVALID_MSGPACK,
 				 errmsg);
 			return -1;
@@ -759,11 +1039,17 @@ err_msgpack:
 		msg->len = reqend - reqstart; /* total request length */
 
 		iproto_msg_decode(msg, &pos, reqend, &stop_input);
-		/*
-		 * This can't throw, but should not be
-		 * done in case of exception.
-		 */
-		cpipe_push_input(&tx_pipe, &msg->base);
+		if (!iproto_msg_offload(msg)) {
+			if (msg->header.type != IPROTO_SELECT) {
+				msg->is_tx_barrier = true;
+				con->tx_barrier_count++;
+			}
+			/*
+			 * This can't throw, but should not be
+			 * done in case of exception.
+			 */
+			cpipe_push_input(tx_pipe, &msg->base);
+		}
 		n_requests++;
 		/* Request is parsed */
 		assert(reqend > reqstart);
@@ -801,7 +1087,7 @@ err_msgpack:
 		 */
 		ev_feed_event(con->loop, &con->input, EV_READ);
 	}
-	cpipe_flush_input(&tx_pipe);
+	cpipe_flush_input(tx_pipe);
 	return 0;
 }
 
@@ -813,7 +1099,7 @@ err_msgpack:
 static void
 iproto_connection_resume(struct iproto_connection *con)
 {
-	assert(! iproto_check_msg_max());
+	assert(! iproto_check_msg_max(con->iproto_thread));
 	rlist_del(&con->in_stop_list);
 	/*
 	 * Enqueue_batch() stops the connection again, if the
@@ -837,15 +1123,16 @@ iproto_connection_resume(struct iproto_connection *con)
  * necessary to use up the limit.
  */
 static void
-iproto_resume()
+iproto_resume(struct iproto_thread *iproto_thread)
 {
-	while (!iproto_check_msg_max() && !rlist_empty(&stopped_connections)) {
+	while (!iproto_check_msg_max(iproto_thread) &&
+	       !rlist_empty(&iproto_thread->stopped_connections)) {
 		/*
 		 * Shift from list head to ensure strict FIFO
 		 * (fairness) for resumed connections.
 		 */
 		struct iproto_connection *con =
-			rlist_first_entry(&stopped_connections,
+			rlist_first_entry(&iproto_thread->stopped_connections,
 					  struct iproto_connection,
 					  in_stop_list);
 		iproto_connection_resume(con);
@@ -867,7 +1154,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	 * otherwise we might deplete the fiber pool in tx
 	 * thread and deadlock.
 	 */
-	if (iproto_check_msg_max()) {
+	if (iproto_check_msg_max(con->iproto_thread)) {
 		iproto_connection_stop_msg_max_limit(con);
 		return;
 	}
@@ -892,7 +1179,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			return;
 		}
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
+		rmean_collect(con->iproto_thread->rmean, IPROTO_RECEIVED, nrd);
 
 		/* Update the read position and connection state. */
 		in->wpos += nrd;
@@ -908,10 +1195,10 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	}
 }
 
-/** writev() to the socket and handle the result. */
+/** writev() the tx output to the socket and handle the result. */
 
 static int
-iproto_flush(struct iproto_connection *con)
+iproto_flush_obuf(struct iproto_connection *con)
 {
 	int fd = con->output.fd;
 	struct obuf *obuf = con->wpos.obuf;
@@ -951,7 +1238,7 @@ iproto_flush(struct iproto_connection *con)
 
 	if (nwr > 0) {
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_SENT, nwr);
+		rmean_collect(con->iproto_thread->rmean, IPROTO_SENT, nwr);
 		if (begin->used + nwr == end->used) {
 			*begin = *end;
 			return 0;
@@ -969,6 +1256,71 @@ iproto_flush(struct iproto_connection *con)
 	return -1;
 }
 
+/** writev() the replies of reader threads to the socket. */
+static int
+iproto_flush_read_replies(struct iproto_connection *con)
+{
+	if (stailq_empty(&con->read_replies))
+		return 1;
+	struct iovec iov[SMALL_OBUF_IOV_MAX];
+	int iovcnt = 0;
+	size_t size = 0;
+	struct iproto_read_reply *reply;
+	stailq_foreach_entry(reply, &con->read_replies, in_queue) {
+		iov[iovcnt].iov_base = reply->data;
+		iov[iovcnt].iov_len = reply->size;
+		size += reply->size;
+		if (++iovcnt == (int) lengthof(iov))
+			break;
+	}
+	sio_add_to_iov(iov, -con->read_reply_offset);
+	size -= con->read_reply_offset;
+
+	ssize_t nwr = sio_writev(con->output.fd, iov, iovcnt);
+
+	if (nwr > 0) {
+		rmean_collect(con->iproto_thread->rmean, IPROTO_SENT, nwr);
+		size_t written = con->read_reply_offset + nwr;
+		while (!stailq_empty(&con->read_replies)) {
+			reply = stailq_first_entry(&con->read_replies,
+						   struct iproto_read_reply,
+						   in_queue);
+			if (reply->size > written)
+				break;
+			written -= reply->size;
+			stailq_shift(&con->read_replies);
+			free(reply);
+		}
+		con->read_reply_offset = written;
+		if ((size_t) nwr == size)
+			return 0;
+	} else if (nwr < 0 && ! sio_wouldblock(errno)) {
+		diag_raise();
+	}
+	return -1;
+}
+
+/**
+ * Flush the connection output. The tx thread only appends
+ * whole replies to the output buffer, so once everything it
+ * has produced is written, the socket is at a reply boundary
+ * and the replies of reader threads can go.
+ *
+ * @retval  1 Nothing to flush.
+ * @retval  0 A portion of output has been flushed.
+ * @retval -1 The socket isn't ready for writing.
+ */
+static int
+iproto_flush(struct iproto_connection *con)
+{
+	if (con->read_reply_offset == 0) {
+		int rc = iproto_flush_obuf(con);
+		if (rc != 1)
+			return rc;
+	}
+	return iproto_flush_read_replies(con);
+}
+
 static void
 iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 			    int /* revents */)
@@ -996,10 +1348,10 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 }
 
 static struct iproto_connection *
-iproto_connection_new(int fd)
+iproto_connection_new(struct iproto_thread *iproto_thread, int fd)
 {
 	struct iproto_connection *con = (struct iproto_connection *)
-		mempool_alloc(&iproto_connection_pool);
+		mempool_alloc(&iproto_thread->iproto_connection_pool);
 	if (con == NULL) {
 		diag_set(OutOfMemory, sizeof(*con), "mempool_alloc", "con");
 		return NULL;
@@ -1010,22 +1362,28 @@ iproto_connection_new(int fd)
 	ev_io_init(&con->output, iproto_connection_on_output, fd, EV_WRITE);
 	ibuf_create(&con->ibuf[0], cord_slab_cache(), iproto_readahead);
 	ibuf_create(&con->ibuf[1], cord_slab_cache(), iproto_readahead);
-	obuf_create(&con->obuf[0], &net_slabc, iproto_readahead);
-	obuf_create(&con->obuf[1], &net_slabc, iproto_readahead);
+	obuf_create(&con->obuf[0], &iproto_thread->net_slabc, iproto_readahead);
+	obuf_create(&con->obuf[1], &iproto_thread->net_slabc, iproto_readahead);
 	con->p_ibuf = &con->ibuf[0];
 	con->tx.p_obuf = &con->obuf[0];
 	iproto_wpos_create(&con->wpos, con->tx.p_obuf);
 	iproto_wpos_create(&con->wend, con->tx.p_obuf);
 	con->parse_size = 0;
 	con->long_poll_count = 0;
+	stailq_create(&con->read_replies);
+	con->read_reply_offset = 0;
+	con->tx_barrier_count = 0;
+	con->min_read_view_gen = 0;
 	con->session = NULL;
 	rlist_create(&con->in_stop_list);
+	con->iproto_thread = iproto_thread;
 	/* It may be very awkward to allocate at close. */
-	cmsg_init(&con->destroy_msg, destroy_route);
+	cmsg_init(&con->destroy_msg, iproto_thread->destroy_route);
 	cmsg_init(&con->disconnect_msg, disconnect_route);
 	con->is_destroy_sent = false;
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = false;
+	con->tx.streams = NULL;
 	return con;
 }
 
@@ -1043,11 +1401,14 @@ iproto_connection_delete(struct iproto_connection *con)
 	 */
 	ibuf_destroy(&con->ibuf[0]);
 	ibuf_destroy(&con->ibuf[1]);
+	struct iproto_read_reply *reply, *next;
+	stailq_foreach_entry_safe(reply, next, &con->read_replies, in_queue)
+		free(reply);
 	assert(con->obuf[0].pos == 0 &&
 	       con->obuf[0].iov[0].iov_base == NULL);
 	assert(con->obuf[1].pos == 0 &&
 	       con->obuf[1].iov[0].iov_base == NULL);
-	mempool_free(&iproto_connection_pool, con);
+	mempool_free(&con->iproto_thread->iproto_connection_pool, con);
 }
 
 /* }}} iproto_connection */
@@ -1084,72 +1445,45 @@ net_send_error(struct cmsg *msg);
 static void
 tx_process_join_subscribe(struct cmsg *msg);
 
+static void
+tx_process_stream(struct cmsg *msg);
+
 static void
 net_end_join(struct cmsg *msg);
 
 static void
 net_end_subscribe(struct cmsg *msg);
 
-static const struct cmsg_hop misc_route[] = {
-	{ tx_process_misc, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop call_route[] = {
-	{ tx_process_call, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop select_route[] = {
-	{ tx_process_select, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop process1_route[] = {
-	{ tx_process1, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop sql_route[] = {
-	{ tx_process_sql, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
-	NULL,                                   /* IPROTO_OK */
-	select_route,                           /* IPROTO_SELECT */
-	process1_route,                         /* IPROTO_INSERT */
-	process1_route,                         /* IPROTO_REPLACE */
-	process1_route,                         /* IPROTO_UPDATE */
-	process1_route,                         /* IPROTO_DELETE */
-	call_route,                             /* IPROTO_CALL_16 */
-	misc_route,                             /* IPROTO_AUTH */
-	call_route,                             /* IPROTO_EVAL */
-	process1_route,                         /* IPROTO_UPSERT */
-	call_route,                             /* IPROTO_CALL */
-	sql_route,                              /* IPROTO_EXECUTE */
-	NULL,                                   /* IPROTO_NOP */
-};
-
-static const struct cmsg_hop join_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_join, NULL },
-};
-
-static const struct cmsg_hop subscribe_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_subscribe, NULL },
-};
-
-static const struct cmsg_hop error_route[] = {
-	{ tx_reply_iproto_error, &net_pipe },
-	{ net_send_error, NULL },
-};
+/** True if a request of the given type may belong to a stream. */
+static inline bool
+iproto_type_is_stream(uint32_t type)
+{
+	switch (type) {
+	case IPROTO_SELECT:
+	case IPROTO_INSERT:
+	case IPROTO_REPLACE:
+	case IPROTO_UPDATE:
+	case IPROTO_DELETE:
+	case IPROTO_UPSERT:
+	case IPROTO_CALL_16:
+	case IPROTO_CALL:
+	case IPROTO_EVAL:
+	case IPROTO_EXECUTE:
+	case IPROTO_PREPARE:
+	case IPROTO_BEGIN:
+	case IPROTO_COMMIT:
+	case IPROTO_ROLLBACK:
+		return true;
+	default:
+		return false;
+	}
+}
 
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input)
 {
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
 	uint8_t type;
 
 	if (xrow_header_decode(&msg->header, pos, reqend))
@@ -1173,53 +1507,72 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		if (xrow_decode_dml(&msg->header, &msg->dml,
 				    dml_request_key_map(type)))
 			goto error;
-		assert(type < sizeof(dml_route)/sizeof(*dml_route));
-		cmsg_init(&msg->base, dml_route[type]);
+		assert(type < lengthof(iproto_thread->dml_route));
+		cmsg_init(&msg->base, iproto_thread->dml_route[type]);
 		break;
 	case IPROTO_CALL_16:
 	case IPROTO_CALL:
 	case IPROTO_EVAL:
 		if (xrow_decode_call(&msg->header, &msg->call))
 			goto error;
-		cmsg_init(&msg->base, call_route);
+		cmsg_init(&msg->base, iproto_thread->call_route);
 		break;
 	case IPROTO_EXECUTE:
+	case IPROTO_PREPARE:
 		if (xrow_decode_sql(&msg->header, &msg->sql) != 0)
 			goto error;
-		cmsg_init(&msg->base, sql_route);
+		cmsg_init(&msg->base, iproto_thread->sql_route);
 		break;
 	case IPROTO_PING:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_JOIN:
-		cmsg_init(&msg->base, join_route);
+		cmsg_init(&msg->base, iproto_thread->join_route);
 		*stop_input = true;
 		break;
 	case IPROTO_SUBSCRIBE:
-		cmsg_init(&msg->base, subscribe_route);
+		cmsg_init(&msg->base, iproto_thread->subscribe_route);
 		*stop_input = true;
 		break;
 	case IPROTO_VOTE_DEPRECATED:
 	case IPROTO_VOTE:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_AUTH:
 		if (xrow_decode_auth(&msg->header, &msg->auth))
 			goto error;
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
+		break;
+	case IPROTO_BEGIN:
+	case IPROTO_COMMIT:
+	case IPROTO_ROLLBACK:
+		if (msg->header.stream_id == 0) {
+			diag_set(ClientError, ER_UNSUPPORTED,
+				 "Transaction control request",
+				 "empty stream id");
+			goto error;
+		}
 		break;
 	default:
 		diag_set(ClientError, ER_UNKNOWN_REQUEST_TYPE,
 			 (uint32_t) type);
 		goto error;
 	}
+	/*
+	 * Requests of a stream are executed by the stream
+	 * fiber in the tx thread. Service requests don't
+	 * depend on the stream state, so they ignore the
+	 * stream id.
+	 */
+	if (msg->header.stream_id != 0 && iproto_type_is_stream(type))
+		cmsg_init(&msg->base, iproto_thread->stream_route);
 	return;
 error:
 	/** Log and send the error. */
 	diag_log();
 	diag_create(&msg->diag);
 	diag_move(&fiber()->diag, &msg->diag);
-	cmsg_init(&msg->base, error_route);
+	cmsg_init(&msg->base, iproto_thread->error_route);
 }
 
 static void
@@ -1261,6 +1614,8 @@ tx_process_destroy(struct cmsg *m)
 {
 	struct iproto_connection *con =
 		container_of(m, struct iproto_connection, destroy_msg);
+	if (con->tx.streams != NULL)
+		tx_destroy_streams(con);
 	if (con->session) {
 		session_destroy(con->session);
 		con->session = NULL; /* safety */
@@ -1319,7 +1674,8 @@ tx_discard_input(struct iproto_msg *msg)
 		{ net_discard_input, NULL },
 	};
 	cmsg_init(&msg->discard_input, discard_input_route);
-	cpipe_push(&net_pipe, &msg->discard_input);
+	cpipe_push(&msg->connection->iproto_thread->net_pipe,
+		   &msg->discard_input);
 }
 
 /**
@@ -1365,7 +1721,13 @@ static inline struct iproto_msg *
 tx_accept_msg(struct cmsg *m)
 {
 	struct iproto_msg *msg = (struct iproto_msg *) m;
-	tx_accept_wpos(msg->connection, &msg->wpos);
+	/*
+	 * A stream request has its write position accepted
+	 * when it is queued to the stream, see
+	 * tx_process_stream().
+	 */
+	if (msg->stream == NULL)
+		tx_accept_wpos(msg->connection, &msg->wpos);
 	tx_fiber_init(msg->connection->session, msg->header.sync);
 	return msg;
 }
@@ -1447,12 +1809,33 @@ tx_process_select(struct cmsg *m)
 		goto error;
 
 	tx_inject_delay();
+	out = msg->connection->tx.p_obuf;
+	if (box_select_can_stream(req->space_id)) {
+		/*
+		 * Reads don't yield, so encode tuples directly
+		 * to the output buffer while iterating over the
+		 * index instead of collecting the whole result
+		 * set in a port first.
+		 */
+		if (iproto_prepare_select(out, &svp) != 0)
+			goto error;
+		count = box_select_to_obuf(req->space_id, req->index_id,
+					   req->iterator, req->offset,
+					   req->limit, req->key, req->key_end,
+					   out);
+		if (count < 0) {
+			obuf_rollback_to_svp(out, &svp);
+			goto error;
+		}
+		goto reply;
+	}
 	rc = box_select(req->space_id, req->index_id,
 			req->iterator, req->offset, req->limit,
 			req->key, req->key_end, &port);
 	if (rc < 0)
 		goto error;
 
+	/* Select may yield, other fibers could switch the buffer. */
 	out = msg->connection->tx.p_obuf;
 	if (iproto_prepare_select(out, &svp) != 0) {
 		port_destroy(&port);
@@ -1468,6 +1851,7 @@ tx_process_select(struct cmsg *m)
 		obuf_rollback_to_svp(out, &svp);
 		goto error;
 	}
+reply:
 	iproto_reply_select(out, &svp, msg->header.sync,
 			    ::schema_version, count);
 	iproto_wpos_create(&msg->wpos, out);
@@ -1618,21 +2002,41 @@ tx_process_sql(struct cmsg *m)
 	int bind_count;
 	const char *sql;
 	uint32_t len;
+	uint32_t stmt_id;
 
 	tx_fiber_init(msg->connection->session, msg->header.sync);
 
 	if (tx_check_schema(msg->header.schema_version))
 		goto error;
-	assert(msg->header.type == IPROTO_EXECUTE);
+	assert(msg->header.type == IPROTO_EXECUTE ||
+	       msg->header.type == IPROTO_PREPARE);
 	tx_inject_delay();
+	if (msg->header.type == IPROTO_PREPARE) {
+		sql = msg->sql.sql_text;
+		sql = mp_decode_str(&sql, &len);
+		if (sql_prepare(sql, len, &stmt_id) != 0)
+			goto error;
+		out = msg->connection->tx.p_obuf;
+		if (iproto_reply_stmt_id(out, stmt_id, msg->header.sync,
+					 ::schema_version) != 0)
+			goto error;
+		iproto_wpos_create(&msg->wpos, out);
+		return;
+	}
 	bind_count = sql_bind_list_decode(msg->sql.bind, &bind);
 	if (bind_count < 0)
 		goto error;
-	sql = msg->sql.sql_text;
-	sql = mp_decode_str(&sql, &len);
-	if (sql_prepare_and_execute(sql, len, bind, bind_count, &response,
-				    &fiber()->gc) != 0)
-		goto error;
+	if (msg->sql.sql_text != NULL) {
+		sql = msg->sql.sql_text;
+		sql = mp_decode_str(&sql, &len);
+		if (sql_prepare_and_execute(sql, len, bind, bind_count,
+					    &response, &fiber()->gc) != 0)
+			goto error;
+	} else {
+		if (sql_execute_prepared(msg->sql.stmt_id, bind, bind_count,
+					 &response, &fiber()->gc) != 0)
+			goto error;
+	}
 	/*
 	 * Take an obuf only after execute(). Else the buffer can
 	 * become out of date during yield.
@@ -1655,6 +2059,305 @@ error:
 	tx_reply_error(msg);
 }
 
+/* {{{ iproto_stream */
+
+/**
+ * A stream of requests of a connection. Requests of a stream
+ * are executed one by one, in the order they were received,
+ * by a dedicated fiber, so that a transaction started with
+ * IPROTO_BEGIN stays open in the fiber until IPROTO_COMMIT
+ * or IPROTO_ROLLBACK. Different streams of a connection are
+ * executed concurrently. Streams live in the tx thread.
+ *
+ * A stream exists only while it has requests to execute or
+ * a transaction open, so a client can't pile up idle streams
+ * and fibers by sending requests with ever new stream ids.
+ */
+struct iproto_stream {
+	/** Stream id, as sent by the client. */
+	uint64_t id;
+	/** Connection the stream belongs to. */
+	struct iproto_connection *connection;
+	/** Fiber executing requests and holding the transaction. */
+	struct fiber *fiber;
+	/** Requests waiting to be executed, in order of arrival. */
+	struct stailq pending;
+	/** Signaled when a request is queued or the stream closes. */
+	struct fiber_cond pending_cond;
+	/** Broadcast when a request has been executed. */
+	struct fiber_cond done_cond;
+	/** Set when the connection is destroyed. */
+	bool is_closed;
+};
+
+static void
+tx_process_txn(struct cmsg *m)
+{
+	struct iproto_msg *msg = tx_accept_msg(m);
+	struct obuf *out;
+	int rc;
+	if (tx_check_schema(msg->header.schema_version))
+		goto error;
+	switch (msg->header.type) {
+	case IPROTO_BEGIN:
+		rc = box_txn_begin();
+		break;
+	case IPROTO_COMMIT:
+		rc = box_txn_commit();
+		break;
+	case IPROTO_ROLLBACK:
+		rc = box_txn_rollback();
+		break;
+	default:
+		unreachable();
+	}
+	if (rc != 0)
+		goto error;
+	/* Commit may yield, other fibers could switch the buffer. */
+	out = msg->connection->tx.p_obuf;
+	if (iproto_reply_ok(out, msg->header.sync, ::schema_version) != 0)
+		goto error;
+	iproto_wpos_create(&msg->wpos, out);
+	return;
+error:
+	tx_reply_error(msg);
+}
+
+/**
+ * Statements of a stream transaction are written to WAL on
+ * commit, long after the request input has been discarded.
+ * Copy the request to the stream fiber region, which is kept
+ * until the transaction ends.
+ */
+static int
+tx_stream_copy_request(struct iproto_msg *msg)
+{
+	struct region *region = &fiber()->gc;
+	struct xrow_header *row = region_alloc_object(region,
+						      struct xrow_header);
+	if (row == NULL) {
+		diag_set(OutOfMemory, sizeof(*row),
+			 "region", "struct xrow_header");
+		return -1;
+	}
+	*row = msg->header;
+	if (row->bodycnt != 0) {
+		assert(row->bodycnt == 1);
+		size_t size = row->body[0].iov_len;
+		void *body = region_alloc(region, size);
+		if (body == NULL) {
+			diag_set(OutOfMemory, size, "region", "request body");
+			return -1;
+		}
+		memcpy(body, row->body[0].iov_base, size);
+		row->body[0].iov_base = body;
+	}
+	return xrow_decode_dml(row, &msg->dml, dml_request_key_map(row->type));
+}
+
+/** Execute a request in the stream fiber and write the reply. */
+static void
+tx_stream_process_msg(struct iproto_msg *msg)
+{
+	tx_accept_msg(&msg->base);
+	switch (msg->header.type) {
+	case IPROTO_SELECT:
+		tx_process_select(&msg->base);
+		break;
+	case IPROTO_INSERT:
+	case IPROTO_REPLACE:
+	case IPROTO_UPDATE:
+	case IPROTO_DELETE:
+	case IPROTO_UPSERT:
+		if (in_txn() != NULL && tx_stream_copy_request(msg) != 0) {
+			tx_reply_error(msg);
+			break;
+		}
+		tx_process1(&msg->base);
+		break;
+	case IPROTO_CALL_16:
+	case IPROTO_CALL:
+	case IPROTO_EVAL:
+		/*
+		 * Functions must not leave a transaction open
+		 * and so can't join one either.
+		 */
+		if (in_txn() != NULL) {
+			diag_set(ClientError, ER_ACTIVE_TRANSACTION);
+			tx_reply_error(msg);
+			break;
+		}
+		tx_process_call(&msg->base);
+		break;
+	case IPROTO_EXECUTE:
+	case IPROTO_PREPARE:
+		tx_process_sql(&msg->base);
+		break;
+	case IPROTO_BEGIN:
+	case IPROTO_COMMIT:
+	case IPROTO_ROLLBACK:
+		tx_process_txn(&msg->base);
+		break;
+	default:
+		unreachable();
+	}
+}
+
+/** Remove a stream from its connection and free it. */
+static void
+tx_stream_delete(struct iproto_stream *stream)
+{
+	if (!stream->is_closed) {
+		struct mh_i64ptr_t *streams = stream->connection->tx.streams;
+		mh_int_t k = mh_i64ptr_find(streams, stream->id, NULL);
+		assert(k != mh_end(streams));
+		mh_i64ptr_del(streams, k, NULL);
+	}
+	fiber_cond_destroy(&stream->pending_cond);
+	fiber_cond_destroy(&stream->done_cond);
+	free(stream);
+}
+
+static int
+tx_stream_f(va_list ap)
+{
+	struct iproto_stream *stream = va_arg(ap, struct iproto_stream *);
+	while (true) {
+		if (stailq_empty(&stream->pending)) {
+			/*
+			 * Nothing to keep the stream for. Requests
+			 * waiting for the results have been woken up
+			 * and don't look at the stream anymore.
+			 */
+			if (stream->is_closed || in_txn() == NULL)
+				break;
+			fiber_cond_wait(&stream->pending_cond);
+			continue;
+		}
+		struct iproto_msg *msg =
+			stailq_shift_entry(&stream->pending,
+					   struct iproto_msg, in_stream);
+		tx_stream_process_msg(msg);
+		msg->stream = NULL;
+		fiber_cond_broadcast(&stream->done_cond);
+		/* Keep the region while the transaction is open. */
+		if (in_txn() == NULL)
+			fiber_gc();
+	}
+	/* If the client is gone, roll back what it left open. */
+	txn_rollback();
+	tx_stream_delete(stream);
+	return 0;
+}
+
+/** Find a stream of a connection or create it if not found. */
+static struct iproto_stream *
+tx_stream_get(struct iproto_connection *con, uint64_t stream_id)
+{
+	struct mh_i64ptr_t *streams = con->tx.streams;
+	if (streams == NULL) {
+		streams = mh_i64ptr_new();
+		if (streams == NULL) {
+			diag_set(OutOfMemory, sizeof(*streams),
+				 "mh_i64ptr_new", "streams");
+			return NULL;
+		}
+		con->tx.streams = streams;
+	}
+	mh_int_t k = mh_i64ptr_find(streams, stream_id, NULL);
+	if (k != mh_end(streams))
+		return (struct iproto_stream *) mh_i64ptr_node(streams, k)->val;
+
+	struct iproto_stream *stream =
+		(struct iproto_stream *) malloc(sizeof(*stream));
+	if (stream == NULL) {
+		diag_set(OutOfMemory, sizeof(*stream), "malloc", "stream");
+		return NULL;
+	}
+	struct mh_i64ptr_node_t node = { stream_id, stream };
+	if (mh_i64ptr_put(streams, &node, NULL, NULL) == mh_end(streams)) {
+		diag_set(OutOfMemory, 0, "mh_i64ptr_put", "stream");
+		free(stream);
+		return NULL;
+	}
+	/* Started by the first request, see tx_process_stream(). */
+	stream->fiber = NULL;
+	stream->id = stream_id;
+	stream->connection = con;
+	stailq_create(&stream->pending);
+	fiber_cond_create(&stream->pending_cond);
+	fiber_cond_create(&stream->done_cond);
+	stream->is_closed = false;
+	return stream;
+}
+
+static void
+tx_destroy_streams(struct iproto_connection *con)
+{
+	struct mh_i64ptr_t *streams = con->tx.streams;
+	mh_int_t k;
+	mh_foreach(streams, k) {
+		struct iproto_stream *stream = (struct iproto_stream *)
+			mh_i64ptr_node(streams, k)->val;
+		/*
+		 * All requests have been executed by now, so
+		 * the stream fiber waits with a transaction
+		 * open. Let it roll back and free the stream
+		 * while the session is still alive.
+		 */
+		assert(stailq_empty(&stream->pending));
+		struct fiber *f = stream->fiber;
+		stream->is_closed = true;
+		fiber_set_joinable(f, true);
+		fiber_cond_signal(&stream->pending_cond);
+		fiber_join(f);
+	}
+	mh_i64ptr_delete(streams);
+	con->tx.streams = NULL;
+}
+
+/**
+ * Queue a stream request to the stream fiber and wait until
+ * it has been executed, so that the request follows the usual
+ * route back to the network thread.
+ */
+static void
+tx_process_stream(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct iproto_connection *con = msg->connection;
+	tx_accept_wpos(con, &msg->wpos);
+	struct iproto_stream *stream = tx_stream_get(con,
+						     msg->header.stream_id);
+	if (stream == NULL) {
+		tx_reply_error(msg);
+		return;
+	}
+	if (stream->fiber == NULL) {
+		/*
+		 * A new stream. Start its fiber only when it has
+		 * a request, otherwise it would exit at once.
+		 */
+		stream->fiber = fiber_new("iproto.stream", tx_stream_f);
+		if (stream->fiber == NULL) {
+			tx_stream_delete(stream);
+			tx_reply_error(msg);
+			return;
+		}
+		msg->stream = stream;
+		stailq_add_tail_entry(&stream->pending, msg, in_stream);
+		fiber_start(stream->fiber, stream);
+	} else {
+		msg->stream = stream;
+		stailq_add_tail_entry(&stream->pending, msg, in_stream);
+		fiber_cond_signal(&stream->pending_cond);
+	}
+	while (msg->stream != NULL)
+		fiber_cond_wait(&stream->done_cond);
+}
+
+/* }}} iproto_stream */
+
 static void
 tx_process_join_subscribe(struct cmsg *m)
 {
@@ -1733,8 +2436,9 @@ net_end_join(struct cmsg *m)
 {
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct iproto_connection *con = msg->connection;
+	struct ibuf *ibuf = msg->p_ibuf;
 
-	msg->p_ibuf->rpos += msg->len;
+	ibuf->rpos += msg->len;
 	iproto_msg_delete(msg);
 
 	assert(! ev_is_active(&con->input));
@@ -1742,7 +2446,7 @@ net_end_join(struct cmsg *m)
 	 * Enqueue any messages if they are in the readahead
 	 * queue. Will simply start input otherwise.
 	 */
-	if (iproto_enqueue_batch(con, msg->p_ibuf) != 0)
+	if (iproto_enqueue_batch(con, ibuf) != 0)
 		iproto_connection_close(con);
 }
 
@@ -1811,7 +2515,8 @@ net_send_greeting(struct cmsg *m)
 
 		if (nwr > 0) {
 			/* Count statistics. */
-			rmean_collect(rmean_net, IPROTO_SENT, nwr);
+			rmean_collect(con->iproto_thread->rmean,
+				      IPROTO_SENT, nwr);
 		} else if (nwr < 0 && ! sio_wouldblock(errno)) {
 			diag_log();
 		}
@@ -1832,10 +2537,58 @@ net_send_greeting(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
-static const struct cmsg_hop connect_route[] = {
-	{ tx_process_connect, &net_pipe },
-	{ net_send_greeting, NULL },
-};
+/**
+ * Fill in message routes of a network thread. A route refers
+ * to the pipe to the thread, so routes can not be shared.
+ */
+static void
+iproto_thread_init_routes(struct iproto_thread *iproto_thread)
+{
+	struct cpipe *net_pipe = &iproto_thread->net_pipe;
+	iproto_thread->destroy_route[0] = { tx_process_destroy, net_pipe };
+	iproto_thread->destroy_route[1] = { net_finish_destroy, NULL };
+	iproto_thread->push_route[0] =
+		{ iproto_process_push, &iproto_thread->tx_pipe };
+	iproto_thread->push_route[1] = { tx_end_push, NULL };
+	iproto_thread->misc_route[0] = { tx_process_misc, net_pipe };
+	iproto_thread->misc_route[1] = { net_send_msg, NULL };
+	iproto_thread->call_route[0] = { tx_process_call, net_pipe };
+	iproto_thread->call_route[1] = { net_send_msg, NULL };
+	iproto_thread->select_route[0] = { tx_process_select, net_pipe };
+	iproto_thread->select_route[1] = { net_send_msg, NULL };
+	iproto_thread->process1_route[0] = { tx_process1, net_pipe };
+	iproto_thread->process1_route[1] = { net_send_msg, NULL };
+	iproto_thread->sql_route[0] = { tx_process_sql, net_pipe };
+	iproto_thread->sql_route[1] = { net_send_msg, NULL };
+	iproto_thread->join_route[0] =
+		{ tx_process_join_subscribe, net_pipe };
+	iproto_thread->join_route[1] = { net_end_join, NULL };
+	iproto_thread->subscribe_route[0] =
+		{ tx_process_join_subscribe, net_pipe };
+	iproto_thread->subscribe_route[1] = { net_end_subscribe, NULL };
+	iproto_thread->error_route[0] = { tx_reply_iproto_error, net_pipe };
+	iproto_thread->error_route[1] = { net_send_error, NULL };
+	iproto_thread->connect_route[0] = { tx_process_connect, net_pipe };
+	iproto_thread->connect_route[1] = { net_send_greeting, NULL };
+	iproto_thread->stream_route[0] = { tx_process_stream, net_pipe };
+	iproto_thread->stream_route[1] = { net_send_msg, NULL };
+
+	const struct cmsg_hop **dml_route = iproto_thread->dml_route;
+	dml_route[IPROTO_OK] = NULL;
+	dml_route[IPROTO_SELECT] = iproto_thread->select_route;
+	dml_route[IPROTO_INSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_REPLACE] = iproto_thread->process1_route;
+	dml_route[IPROTO_UPDATE] = iproto_thread->process1_route;
+	dml_route[IPROTO_DELETE] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL_16] = iproto_thread->call_route;
+	dml_route[IPROTO_AUTH] = iproto_thread->misc_route;
+	dml_route[IPROTO_EVAL] = iproto_thread->call_route;
+	dml_route[IPROTO_UPSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL] = iproto_thread->call_route;
+	dml_route[IPROTO_EXECUTE] = iproto_thread->sql_route;
+	dml_route[IPROTO_NOP] = NULL;
+	dml_route[IPROTO_PREPARE] = iproto_thread->sql_route;
+}
 
 /** }}} */
 
@@ -1843,13 +2596,16 @@ static const struct cmsg_hop connect_route[] = {
  * Create a connection and start input.
  */
 static int
-iproto_on_accept(struct evio_service * /* service */, int fd,
+iproto_on_accept(struct evio_service *service, int fd,
 		 struct sockaddr *addr, socklen_t addrlen)
 {
 	(void) addr;
 	(void) addrlen;
+	struct iproto_thread *iproto_thread =
+		(struct iproto_thread *) service->on_accept_param;
 	struct iproto_msg *msg;
-	struct iproto_connection *con = iproto_connection_new(fd);
+	struct iproto_connection *con =
+		iproto_connection_new(iproto_thread, fd);
 	if (con == NULL)
 		return -1;
 	/*
@@ -1859,62 +2615,91 @@ iproto_on_accept(struct evio_service * /* service */, int fd,
 	 */
 	msg = iproto_msg_new(con);
 	if (msg == NULL) {
-		mempool_free(&iproto_connection_pool, con);
+		mempool_free(&iproto_thread->iproto_connection_pool, con);
 		return -1;
 	}
-	cmsg_init(&msg->base, connect_route);
+	cmsg_init(&msg->base, iproto_thread->connect_route);
 	msg->p_ibuf = con->p_ibuf;
 	msg->wpos = con->wpos;
 	msg->close_connection = false;
-	cpipe_push(&tx_pipe, &msg->base);
+	cpipe_push(&iproto_thread->tx_pipe, &msg->base);
 	return 0;
 }
 
-static struct evio_service binary; /* iproto binary listener */
+/** Name of the cbus endpoint of a network thread. */
+static inline const char *
+iproto_thread_endpoint_name(struct iproto_thread *iproto_thread)
+{
+	return tt_sprintf("net%d", iproto_thread->id);
+}
+
+/** Name of the cbus endpoint of a reader thread. */
+static inline const char *
+iproto_reader_endpoint_name(struct iproto_reader *reader)
+{
+	return tt_sprintf("reader%d", reader->id);
+}
 
 /**
  * The network io thread main function:
  * begin serving the message bus.
  */
 static int
-net_cord_f(va_list /* ap */)
+net_cord_f(va_list ap)
 {
-	mempool_create(&iproto_msg_pool, &cord()->slabc,
+	struct iproto_thread *iproto_thread =
+		va_arg(ap, struct iproto_thread *);
+
+	mempool_create(&iproto_thread->iproto_msg_pool, &cord()->slabc,
 		       sizeof(struct iproto_msg));
-	mempool_create(&iproto_connection_pool, &cord()->slabc,
+	mempool_create(&iproto_thread->iproto_connection_pool, &cord()->slabc,
 		       sizeof(struct iproto_connection));
 
-	evio_service_init(loop(), &binary, "binary",
-			  iproto_on_accept, NULL);
+	evio_service_init(loop(), &iproto_thread->binary, "binary",
+			  iproto_on_accept, iproto_thread);
 
 
 	/* Init statistics counter */
-	rmean_net = rmean_new(rmean_net_strings, IPROTO_LAST);
+	iproto_thread->rmean = rmean_new(rmean_net_strings, IPROTO_LAST);
 
-	if (rmean_net == NULL) {
+	if (iproto_thread->rmean == NULL) {
 		tnt_raise(OutOfMemory, sizeof(struct rmean),
 			  "rmean", "struct rmean");
 	}
 
 	struct cbus_endpoint endpoint;
 	/* Create "net" endpoint. */
-	cbus_endpoint_create(&endpoint, "net", fiber_schedule_cb, fiber());
+	cbus_endpoint_create(&endpoint,
+			     iproto_thread_endpoint_name(iproto_thread),
+			     fiber_schedule_cb, fiber());
 	/* Create a pipe to "tx" thread. */
-	cpipe_create(&tx_pipe, "tx");
-	cpipe_set_max_input(&tx_pipe, iproto_msg_max / 2);
+	cpipe_create(&iproto_thread->tx_pipe, "tx");
+	cpipe_set_max_input(&iproto_thread->tx_pipe,
+			    iproto_thread->msg_max / 2);
+	/* Create pipes to reader threads. */
+	for (int i = 0; i < iproto_readers_count; i++) {
+		cpipe_create(&iproto_thread->reader_pipes[i],
+			     iproto_reader_endpoint_name(&iproto_readers[i]));
+	}
 	/* Process incomming messages. */
 	cbus_loop(&endpoint);
 
-	cpipe_destroy(&tx_pipe);
+	for (int i = 0; i < iproto_readers_count; i++)
+		cpipe_destroy(&iproto_thread->reader_pipes[i]);
+	cpipe_destroy(&iproto_thread->tx_pipe);
 	/*
 	 * Nothing to do in the fiber so far, the service
 	 * will take care of creating events for incoming
 	 * connections.
 	 */
-	if (evio_service_is_active(&binary))
-		evio_service_stop(&binary);
+	if (evio_service_is_active(&iproto_thread->binary)) {
+		if (iproto_thread->id == 0)
+			evio_service_stop(&iproto_thread->binary);
+		else
+			evio_service_detach(&iproto_thread->binary);
+	}
 
-	rmean_delete(rmean_net);
+	rmean_delete(iproto_thread->rmean);
 	return 0;
 }
 
@@ -1956,11 +2741,12 @@ static void
 tx_begin_push(struct iproto_connection *con)
 {
 	assert(! con->tx.is_push_sent);
-	cmsg_init(&con->kharon.base, push_route);
+	cmsg_init(&con->kharon.base, con->iproto_thread->push_route);
 	iproto_wpos_create(&con->kharon.wpos, con->tx.p_obuf);
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = true;
-	cpipe_push(&net_pipe, (struct cmsg *) &con->kharon);
+	cpipe_push(&con->iproto_thread->net_pipe,
+		   (struct cmsg *) &con->kharon);
 }
 
 static void
@@ -2008,18 +2794,277 @@ iproto_session_push(struct session *session, uint64_t sync, struct port *port)
 
 /** }}} */
 
-/** Initialize the iproto subsystem and start network io thread */
-void
-iproto_init()
+/* {{{ iproto_reader */
+
+static bool
+iproto_msg_offload(struct iproto_msg *msg)
+{
+	struct iproto_connection *con = msg->connection;
+	struct iproto_thread *iproto_thread = con->iproto_thread;
+	struct iproto_read_view *view = iproto_thread->read_view;
+	if (view == NULL || msg->base.hop != iproto_thread->select_route)
+		return false;
+	if (con->tx_barrier_count > 0 ||
+	    pm_atomic_load(&view->gen) < con->min_read_view_gen)
+		return false;
+	struct request *request = &msg->dml;
+	if (request->iterator != ITER_EQ || request->key == NULL)
+		return false;
+	if (msg->header.schema_version != 0 &&
+	    msg->header.schema_version != view->schema_version)
+		return false;
+	uint64_t id = (uint64_t) request->space_id << 32 | request->index_id;
+	mh_int_t k = mh_i64ptr_find(view->indexes, id, NULL);
+	if (k == mh_end(view->indexes))
+		return false;
+	struct iproto_read_view_index *index =
+		(struct iproto_read_view_index *)
+		mh_i64ptr_node(view->indexes, k)->val;
+	/*
+	 * Session credentials are only changed by requests
+	 * executed in tx, and none of them is in progress,
+	 * so the token is up to date.
+	 */
+	uint8_t auth_token = con->session->credentials.auth_token;
+	if ((index->readers & (1U << auth_token)) == 0)
+		return false;
+
+	pm_atomic_fetch_add(&view->refs, 1);
+	msg->read_view = view;
+	msg->read_view_index = index;
+	cmsg_init(&msg->base, read_route);
+	struct cpipe *pipe =
+		&iproto_thread->reader_pipes[iproto_thread->next_reader];
+	iproto_thread->next_reader = (iproto_thread->next_reader + 1) %
+				     iproto_readers_count;
+	cpipe_push(pipe, &msg->base);
+	return true;
+}
+
+/**
+ * Look up the key of a SELECT in a read view and encode the
+ * reply. Return NULL if the key is invalid, so that the error
+ * is reported by the tx thread, or on memory error.
+ */
+static struct iproto_read_reply *
+reader_select(struct iproto_msg *msg)
+{
+	struct request *request = &msg->dml;
+	struct memtx_hash_read_view *rv = msg->read_view_index->rv;
+	struct key_def *key_def = memtx_hash_read_view_key_def(rv);
+	const char *key = request->key;
+	uint32_t part_count = mp_decode_array(&key);
+	if (part_count != key_def->part_count)
+		return NULL;
+	const char *pos = key;
+	for (uint32_t i = 0; i < part_count; i++) {
+		uint32_t mask = key_mp_type[key_def->parts[i].type];
+		if ((mask & (1U << mp_typeof(*pos))) == 0)
+			return NULL;
+		mp_next(&pos);
+	}
+	struct tuple *tuple = NULL;
+	if (request->offset == 0 && request->limit > 0)
+		tuple = memtx_hash_read_view_get(rv, key);
+	uint32_t count = 0;
+	uint32_t data_len = 0;
+	const char *data = NULL;
+	if (tuple != NULL) {
+		count = 1;
+		data = tuple_data_range(tuple, &data_len);
+	}
+	size_t size = IPROTO_SELECT_HEADER_LEN + data_len;
+	struct iproto_read_reply *reply = (struct iproto_read_reply *)
+		malloc(sizeof(*reply) + size);
+	if (reply == NULL)
+		return NULL;
+	reply->size = size;
+	iproto_select_header_encode(reply->data, msg->header.sync,
+				    msg->read_view->schema_version,
+				    count, data_len);
+	if (data != NULL)
+		memcpy(reply->data + IPROTO_SELECT_HEADER_LEN, data, data_len);
+	return reply;
+}
+
+static void
+reader_process_select(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct iproto_reader *reader =
+		container_of(cord(), struct iproto_reader, cord);
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	msg->read_reply = reader_select(msg);
+	cmsg_init(&msg->base, read_reply_route);
+	cpipe_push(&reader->net_pipes[iproto_thread->id], &msg->base);
+}
+
+/** Drop a reference to a read view in a network thread. */
+static void
+net_unref_read_view(struct iproto_thread *iproto_thread,
+		    struct iproto_read_view *view)
+{
+	if (pm_atomic_fetch_sub(&view->refs, 1) > 1)
+		return;
+	cmsg_init(&view->release_msg, read_view_release_route);
+	cpipe_push(&iproto_thread->tx_pipe, &view->release_msg);
+}
+
+static void
+tx_release_read_view(struct cmsg *m)
+{
+	struct iproto_read_view *view =
+		container_of(m, struct iproto_read_view, release_msg);
+	view->is_released = true;
+	fiber_cond_signal(&view->release_cond);
+}
+
+static void
+net_end_read(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct iproto_connection *con = msg->connection;
+	struct iproto_thread *iproto_thread = con->iproto_thread;
+	struct iproto_read_reply *reply = msg->read_reply;
+	net_unref_read_view(iproto_thread, msg->read_view);
+	msg->read_view = NULL;
+	msg->read_view_index = NULL;
+	msg->read_reply = NULL;
+	if (reply == NULL) {
+		msg->wpos = con->wpos;
+		cmsg_init(&msg->base, iproto_thread->select_route);
+		cpipe_push(&iproto_thread->tx_pipe, &msg->base);
+		return;
+	}
+	rmean_collect(iproto_thread->rmean, IPROTO_OFFLOADED, 1);
+	/* Discard request (see iproto_enqueue_batch()). */
+	msg->p_ibuf->rpos += msg->len;
+
+	if (evio_has_fd(&con->output)) {
+		stailq_add_tail_entry(&con->read_replies, reply, in_queue);
+		if (! ev_is_active(&con->output))
+			ev_feed_event(con->loop, &con->output, EV_WRITE);
+	} else {
+		free(reply);
+		if (iproto_connection_is_idle(con))
+			iproto_connection_close(con);
+	}
+	iproto_msg_delete(msg);
+}
+
+/**
+ * The reader thread main function: serve requests sent by
+ * network threads.
+ */
+static int
+iproto_reader_f(va_list ap)
 {
-	slab_cache_create(&net_slabc, &runtime);
+	struct iproto_reader *reader = va_arg(ap, struct iproto_reader *);
+
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, iproto_reader_endpoint_name(reader),
+			     fiber_schedule_cb, fiber());
+	/* Create pipes to network threads. */
+	for (int i = 0; i < iproto_threads_count; i++) {
+		cpipe_create(&reader->net_pipes[i],
+			     iproto_thread_endpoint_name(&iproto_threads[i]));
+	}
+	cbus_loop(&endpoint);
+
+	for (int i = 0; i < iproto_threads_count; i++)
+		cpipe_destroy(&reader->net_pipes[i]);
+	return 0;
+}
+
+/**
+ * Recreate the read view periodically in the tx thread,
+ * see iproto_read_view.
+ */
+static int
+iproto_read_view_f(va_list ap);
+
+/* }}} iproto_reader */
+
+/** Initialize the iproto subsystem and start network io threads */
+void
+iproto_init(int threads_count, int readers_count)
+{
+	assert(threads_count > 0);
+	assert(readers_count >= 0);
+	iproto_threads = (struct iproto_thread *)
+		calloc(threads_count, sizeof(struct iproto_thread));
+	if (iproto_threads == NULL) {
+		tnt_raise(OutOfMemory, threads_count *
+			  sizeof(struct iproto_thread), "calloc",
+			  "struct iproto_thread");
+	}
+	iproto_threads_count = threads_count;
+	if (readers_count > 0) {
+		iproto_readers = (struct iproto_reader *)
+			calloc(readers_count, sizeof(struct iproto_reader));
+		if (iproto_readers == NULL) {
+			tnt_raise(OutOfMemory, readers_count *
+				  sizeof(struct iproto_reader), "calloc",
+				  "struct iproto_reader");
+		}
+	}
+	iproto_readers_count = readers_count;
+	/*
+	 * Network threads look up reader endpoints by name,
+	 * so readers must be set up before they are started.
+	 */
+	for (int i = 0; i < readers_count; i++) {
+		struct iproto_reader *reader = &iproto_readers[i];
+		reader->id = i;
+		reader->net_pipes = (struct cpipe *)
+			calloc(threads_count, sizeof(struct cpipe));
+		if (reader->net_pipes == NULL) {
+			tnt_raise(OutOfMemory, threads_count *
+				  sizeof(struct cpipe), "calloc",
+				  "struct cpipe");
+		}
+	}
 
-	if (cord_costart(&net_cord, "iproto", net_cord_f, NULL))
-		panic("failed to initialize iproto thread");
+	for (int i = 0; i < threads_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		iproto_thread->id = i;
+		iproto_thread->msg_max = iproto_msg_max;
+		rlist_create(&iproto_thread->stopped_connections);
+		iproto_thread_init_routes(iproto_thread);
+		slab_cache_create(&iproto_thread->net_slabc, &runtime);
+		if (readers_count > 0) {
+			iproto_thread->reader_pipes = (struct cpipe *)
+				calloc(readers_count, sizeof(struct cpipe));
+			if (iproto_thread->reader_pipes == NULL) {
+				tnt_raise(OutOfMemory, readers_count *
+					  sizeof(struct cpipe), "calloc",
+					  "struct cpipe");
+			}
+		}
 
-	/* Create a pipe to "net" thread. */
-	cpipe_create(&net_pipe, "net");
-	cpipe_set_max_input(&net_pipe, iproto_msg_max / 2);
+		if (cord_costart(&iproto_thread->net_cord,
+				 tt_sprintf("iproto%d", iproto_thread->id),
+				 net_cord_f, iproto_thread))
+			panic("failed to initialize iproto thread");
+
+		/* Create a pipe to "net" thread. */
+		cpipe_create(&iproto_thread->net_pipe,
+			     iproto_thread_endpoint_name(iproto_thread));
+		cpipe_set_max_input(&iproto_thread->net_pipe,
+				    iproto_msg_max / 2);
+	}
+	for (int i = 0; i < readers_count; i++) {
+		struct iproto_reader *reader = &iproto_readers[i];
+		if (cord_costart(&reader->cord,
+				 tt_sprintf("iproto_reader%d", reader->id),
+				 iproto_reader_f, reader))
+			panic("failed to initialize iproto reader thread");
+	}
+	if (readers_count > 0) {
+		struct fiber *f = fiber_new_xc("iproto_read_view",
+					       iproto_read_view_f);
+		fiber_start(f);
+	}
 	struct session_vtab iproto_session_vtab = {
 		/* .push = */ iproto_session_push,
 		/* .fd = */ iproto_session_fd,
@@ -2031,7 +3076,9 @@ iproto_init()
 /** Available iproto configuration changes. */
 enum iproto_cfg_op {
 	IPROTO_CFG_MSG_MAX,
-	IPROTO_CFG_LISTEN
+	IPROTO_CFG_LISTEN,
+	IPROTO_CFG_ATTACH,
+	IPROTO_CFG_READ_VIEW,
 };
 
 /**
@@ -2044,12 +3091,24 @@ struct iproto_cfg_msg: public cbus_call_msg
 {
 	/** Operation to execute in iproto thread. */
 	enum iproto_cfg_op op;
+	/** Thread to execute the operation in. */
+	struct iproto_thread *iproto_thread;
 	union {
 		/** New URI to bind to. */
 		const char *uri;
 
 		/** New iproto max message count. */
 		int iproto_msg_max;
+
+		/**
+		 * Listener of the first network thread to share
+		 * the listening socket with, NULL to only stop
+		 * accepting connections.
+		 */
+		const struct evio_service *binary;
+
+		/** Read view to install, NULL to remove. */
+		struct iproto_read_view *read_view;
 	};
 };
 
@@ -2064,25 +3123,39 @@ static int
 iproto_do_cfg_f(struct cbus_call_msg *m)
 {
 	struct iproto_cfg_msg *cfg_msg = (struct iproto_cfg_msg *) m;
-	int old;
+	struct iproto_thread *iproto_thread = cfg_msg->iproto_thread;
+	struct evio_service *binary = &iproto_thread->binary;
 	try {
 		switch (cfg_msg->op) {
 		case IPROTO_CFG_MSG_MAX:
-			cpipe_set_max_input(&tx_pipe,
+			cpipe_set_max_input(&iproto_thread->tx_pipe,
 					    cfg_msg->iproto_msg_max / 2);
-			old = iproto_msg_max;
-			iproto_msg_max = cfg_msg->iproto_msg_max;
-			if (old < iproto_msg_max)
-				iproto_resume();
+			iproto_thread->msg_max = cfg_msg->iproto_msg_max;
+			iproto_resume(iproto_thread);
 			break;
 		case IPROTO_CFG_LISTEN:
-			if (evio_service_is_active(&binary))
-				evio_service_stop(&binary);
+			assert(iproto_thread->id == 0);
+			if (evio_service_is_active(binary))
+				evio_service_stop(binary);
 			if (cfg_msg->uri != NULL &&
-			    (evio_service_bind(&binary, cfg_msg->uri) != 0 ||
-			     evio_service_listen(&binary) != 0))
+			    (evio_service_bind(binary, cfg_msg->uri) != 0 ||
+			     evio_service_listen(binary) != 0))
 				diag_raise();
 			break;
+		case IPROTO_CFG_ATTACH:
+			assert(iproto_thread->id != 0);
+			if (evio_service_is_active(binary))
+				evio_service_detach(binary);
+			if (cfg_msg->binary != NULL &&
+			    evio_service_is_active(cfg_msg->binary))
+				evio_service_attach(binary, cfg_msg->binary);
+			break;
+		case IPROTO_CFG_READ_VIEW:
+			if (iproto_thread->read_view != NULL)
+				net_unref_read_view(iproto_thread,
+						    iproto_thread->read_view);
+			iproto_thread->read_view = cfg_msg->read_view;
+			break;
 		default:
 			unreachable();
 		}
@@ -2093,32 +3166,77 @@ iproto_do_cfg_f(struct cbus_call_msg *m)
 }
 
 static inline void
-iproto_do_cfg(struct iproto_cfg_msg *msg)
+iproto_do_cfg(struct iproto_thread *iproto_thread, struct iproto_cfg_msg *msg)
 {
-	if (cbus_call(&net_pipe, &tx_pipe, msg, iproto_do_cfg_f,
-		      NULL, TIMEOUT_INFINITY) != 0)
+	msg->iproto_thread = iproto_thread;
+	if (cbus_call(&iproto_thread->net_pipe, &iproto_thread->tx_pipe, msg,
+		      iproto_do_cfg_f, NULL, TIMEOUT_INFINITY) != 0)
 		diag_raise();
 }
 
+/**
+ * Let all network threads but the first one accept connections
+ * on the listening socket of the first thread, or stop
+ * accepting if @a binary is NULL.
+ */
+static void
+iproto_attach_threads(const struct evio_service *binary)
+{
+	for (int i = 1; i < iproto_threads_count; i++) {
+		struct iproto_cfg_msg cfg_msg;
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_ATTACH);
+		cfg_msg.binary = binary;
+		iproto_do_cfg(&iproto_threads[i], &cfg_msg);
+	}
+}
+
 void
 iproto_listen(const char *uri)
 {
+	/*
+	 * The listening socket is bound by the first network
+	 * thread. Other threads only watch it in their own
+	 * event loops, so an incoming connection is accepted
+	 * by whichever thread wakes up first.
+	 */
+	iproto_attach_threads(NULL);
 	struct iproto_cfg_msg cfg_msg;
 	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_LISTEN);
 	cfg_msg.uri = uri;
-	iproto_do_cfg(&cfg_msg);
+	iproto_do_cfg(&iproto_threads[0], &cfg_msg);
+	iproto_attach_threads(&iproto_threads[0].binary);
 }
 
 size_t
 iproto_mem_used(void)
 {
-	return slab_cache_used(&net_cord.slabc) + slab_cache_used(&net_slabc);
+	size_t mem = 0;
+	for (int i = 0; i < iproto_threads_count; i++)
+		mem += iproto_thread_mem_used(i);
+	return mem;
+}
+
+size_t
+iproto_thread_mem_used(int thread_id)
+{
+	assert(thread_id >= 0 && thread_id < iproto_threads_count);
+	struct iproto_thread *iproto_thread = &iproto_threads[thread_id];
+	return slab_cache_used(&iproto_thread->net_cord.slabc) +
+	       slab_cache_used(&iproto_thread->net_slabc);
+}
+
+struct rmean *
+iproto_thread_rmean(int thread_id)
+{
+	assert(thread_id >= 0 && thread_id < iproto_threads_count);
+	return iproto_threads[thread_id].rmean;
 }
 
 void
 iproto_reset_stat(void)
 {
-	rmean_cleanup(rmean_net);
+	for (int i = 0; i < iproto_threads_count; i++)
+		rmean_cleanup(iproto_threads[i].rmean);
 }
 
 void
@@ -2129,9 +3247,206 @@ iproto_set_msg_max(int new_iproto_msg_max)
 			  tt_sprintf("minimal value is %d",
 				     IPROTO_MSG_MAX_MIN));
 	}
-	struct iproto_cfg_msg cfg_msg;
-	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_MSG_MAX);
-	cfg_msg.iproto_msg_max = new_iproto_msg_max;
-	iproto_do_cfg(&cfg_msg);
-	cpipe_set_max_input(&net_pipe, new_iproto_msg_max / 2);
+	iproto_msg_max = new_iproto_msg_max;
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_cfg_msg cfg_msg;
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_MSG_MAX);
+		cfg_msg.iproto_msg_max = new_iproto_msg_max;
+		iproto_do_cfg(&iproto_threads[i], &cfg_msg);
+		cpipe_set_max_input(&iproto_threads[i].net_pipe,
+				    new_iproto_msg_max / 2);
+	}
+}
+
+/* {{{ iproto_read_view */
+
+/**
+ * Return the auth tokens of the users that may read a space,
+ * following the rules of access_check_space().
+ */
+static uint32_t
+iproto_space_readers(struct space *space)
+{
+	struct user *owner = user_by_id(space->def->uid);
+	struct access *entity = entity_access_get(SC_SPACE);
+	uint32_t readers = 0;
+	for (int token = 0; token < BOX_USER_MAX; token++) {
+		user_access_t access = PRIV_R | PRIV_U;
+		access &= ~universe.access[token].effective;
+		access &= ~entity[token].effective;
+		if (access != 0 &&
+		    (access & PRIV_U ||
+		     ((owner == NULL || owner->auth_token != token) &&
+		      access & ~space->access[token].effective)))
+			continue;
+		readers |= 1U << token;
+	}
+	return readers;
 }
+
+static void
+iproto_read_view_delete(struct iproto_read_view *view)
+{
+	assert(view->refs == 0);
+	fiber_cond_destroy(&view->release_cond);
+	struct mh_i64ptr_t *indexes = view->indexes;
+	mh_int_t k;
+	mh_foreach(indexes, k) {
+		struct iproto_read_view_index *index =
+			(struct iproto_read_view_index *)
+			mh_i64ptr_node(indexes, k)->val;
+		memtx_hash_read_view_delete(index->rv);
+		free(index);
+	}
+	mh_i64ptr_delete(indexes);
+	free(view);
+	memtx_leave_delayed_free_mode(
+		(struct memtx_engine *) engine_by_name("memtx"));
+}
+
+static int
+iproto_read_view_add_space(struct space *space, void *arg)
+{
+	struct iproto_read_view *view = (struct iproto_read_view *) arg;
+	/*
+	 * Tuples of temporary spaces are freed at once even in
+	 * the delayed free mode, so a view can't keep them.
+	 */
+	if (!space_is_memtx(space) || space_is_temporary(space))
+		return 0;
+	uint32_t readers = iproto_space_readers(space);
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct index *base = space->index[i];
+		/*
+		 * A collation may be dropped while the view is
+		 * in use, so such keys are looked up in tx.
+		 */
+		if (base->def->type != HASH ||
+		    key_def_has_collation(base->def->key_def))
+			continue;
+		struct iproto_read_view_index *index =
+			(struct iproto_read_view_index *)
+			malloc(sizeof(*index));
+		if (index == NULL) {
+			diag_set(OutOfMemory, sizeof(*index), "malloc",
+				 "struct iproto_read_view_index");
+			return -1;
+		}
+		index->rv = memtx_hash_read_view_new(base);
+		if (index->rv == NULL) {
+			free(index);
+			return -1;
+		}
+		index->readers = readers;
+		uint64_t id = (uint64_t) space_id(space) << 32 | base->def->iid;
+		struct mh_i64ptr_node_t node = { id, index };
+		if (mh_i64ptr_put(view->indexes, &node, NULL,
+				  NULL) == mh_end(view->indexes)) {
+			memtx_hash_read_view_delete(index->rv);
+			free(index);
+			diag_set(OutOfMemory, 0, "mh_i64ptr_put",
+				 "read view");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/** Create a read view of all memtx HASH indexes. */
+static struct iproto_read_view *
+iproto_read_view_new(void)
+{
+	struct iproto_read_view *view =
+		(struct iproto_read_view *) malloc(sizeof(*view));
+	if (view == NULL) {
+		diag_set(OutOfMemory, sizeof(*view), "malloc",
+			 "struct iproto_read_view");
+		return NULL;
+	}
+	view->indexes = mh_i64ptr_new();
+	if (view->indexes == NULL) {
+		free(view);
+		diag_set(OutOfMemory, 0, "mh_i64ptr_new", "read view");
+		return NULL;
+	}
+	view->refs = 0;
+	view->is_released = false;
+	fiber_cond_create(&view->release_cond);
+	view->schema_version = ::schema_version;
+	view->txn_end_count = txn_end_count;
+	/*
+	 * Bump the generation before creating the index views,
+	 * see iproto_msg_delete().
+	 */
+	view->gen = iproto_read_view_gen + 1;
+	pm_atomic_store(&iproto_read_view_gen, view->gen);
+	/* Keep the tuples for all index views at once. */
+	memtx_enter_delayed_free_mode(
+		(struct memtx_engine *) engine_by_name("memtx"));
+	if (space_foreach(iproto_read_view_add_space, view) != 0) {
+		iproto_read_view_delete(view);
+		return NULL;
+	}
+	/* Released by the network threads, see net_unref_read_view(). */
+	view->refs = iproto_threads_count;
+	return view;
+}
+
+/** Install a read view in all network threads, NULL to remove. */
+static void
+iproto_install_read_view(struct iproto_read_view *view)
+{
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_cfg_msg cfg_msg;
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_READ_VIEW);
+		cfg_msg.read_view = view;
+		iproto_do_cfg(&iproto_threads[i], &cfg_msg);
+	}
+}
+
+static int
+iproto_read_view_f(va_list ap)
+{
+	(void) ap;
+	struct iproto_read_view *view = NULL;
+	while (!fiber_is_cancelled()) {
+		fiber_sleep(IPROTO_READ_VIEW_PERIOD);
+		if (!box_is_configured())
+			continue;
+		if (view != NULL && view->txn_end_count == txn_end_count) {
+			/*
+			 * Nothing has changed since the view was
+			 * created, so it has all the changes the
+			 * clients may wait for, see
+			 * iproto_msg_delete().
+			 */
+			uint64_t gen = iproto_read_view_gen + 1;
+			pm_atomic_store(&iproto_read_view_gen, gen);
+			pm_atomic_store(&view->gen, gen);
+			continue;
+		}
+		try {
+			if (view != NULL) {
+				iproto_install_read_view(NULL);
+				/*
+				 * Network threads don't start new
+				 * requests on the view anymore, wait
+				 * for the ones in progress.
+				 */
+				while (!view->is_released)
+					fiber_cond_wait(&view->release_cond);
+				iproto_read_view_delete(view);
+				view = NULL;
+			}
+			view = iproto_read_view_new();
+			if (view == NULL)
+				diag_raise();
+			iproto_install_read_view(view);
+		} catch (Exception *e) {
+			e->log();
+		}
+	}
+	return 0;
+}
+
+/* }}} iproto_read_view */
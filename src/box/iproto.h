@@ -52,16 +52,37 @@ enum {
 	 * processing stops until some new fibers are freed up.
 	 */
 	IPROTO_FIBER_POOL_SIZE_FACTOR = 5,
+	/** The maximal number of network threads. */
+	IPROTO_THREADS_MAX = 1000,
 };
 
 extern unsigned iproto_readahead;
 
+/** The number of network threads, box.cfg.iproto_threads. */
+extern int iproto_threads_count;
+
+struct rmean;
+
 /**
  * Return size of memory used for storing network buffers.
  */
 size_t
 iproto_mem_used(void);
 
+/**
+ * Return size of memory used for storing network buffers
+ * of a single network thread.
+ */
+size_t
+iproto_thread_mem_used(int thread_id);
+
+/**
+ * Return network statistics (SENT/RECEIVED) of a single
+ * network thread.
+ */
+struct rmean *
+iproto_thread_rmean(int thread_id);
+
 /**
  * Reset network statistics.
  */
@@ -71,8 +92,13 @@ iproto_reset_stat(void);
 #if defined(__cplusplus)
 } /* extern "C" */
 
+/**
+ * Initialize the iproto subsystem and start
+ * @a threads_count network threads and @a readers_count
+ * threads serving SELECTs from memtx read views.
+ */
 void
-iproto_init();
+iproto_init(int threads_count, int readers_count);
 
 void
 iproto_listen(const char *uri);
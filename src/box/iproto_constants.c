@@ -46,7 +46,7 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 	/* {{{ unused */
 		/* 0x08 */	MP_UINT,
 		/* 0x09 */	MP_UINT,
-		/* 0x0a */	MP_UINT,
+		/* 0x0a */	MP_UINT,   /* IPROTO_STREAM_ID */
 		/* 0x0b */	MP_UINT,
 		/* 0x0c */	MP_UINT,
 		/* 0x0d */	MP_UINT,
@@ -107,6 +107,10 @@ const char *iproto_type_strs[] =
 	"CALL",
 	"EXECUTE",
 	NULL, /* NOP */
+	NULL, /* PREPARE */
+	NULL, /* BEGIN */
+	NULL, /* COMMIT */
+	NULL, /* ROLLBACK */
 };
 
 #define bit(c) (1ULL<<IPROTO_##c)
@@ -124,6 +128,10 @@ const uint64_t iproto_body_key_map[IPROTO_TYPE_STAT_MAX] = {
 	0,                                                     /* CALL */
 	0,                                                     /* EXECUTE */
 	0,                                                     /* NOP */
+	0,                                                     /* PREPARE */
+	0,                                                     /* BEGIN */
+	0,                                                     /* COMMIT */
+	0,                                                     /* ROLLBACK */
 };
 #undef bit
 
@@ -138,7 +146,7 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"group id",         /* 0x07 */
 	NULL,               /* 0x08 */
 	NULL,               /* 0x09 */
-	NULL,               /* 0x0a */
+	"stream id",        /* 0x0a */
 	NULL,               /* 0x0b */
 	NULL,               /* 0x0c */
 	NULL,               /* 0x0d */
@@ -195,6 +203,7 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"SQL text",         /* 0x40 */
 	"SQL bind",         /* 0x41 */
 	"SQL info",         /* 0x42 */
+	"statement id",     /* 0x43 */
 };
 
 const char *vy_page_info_key_strs[VY_PAGE_INFO_KEY_MAX] = {
@@ -217,6 +226,7 @@ const char *vy_run_info_key_strs[VY_RUN_INFO_KEY_MAX] = {
 	"bloom filter legacy",
 	"bloom filter",
 	"stmt stat",
+	"sketch",
 };
 
 const char *vy_row_index_key_strs[VY_ROW_INDEX_KEY_MAX] = {
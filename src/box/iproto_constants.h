@@ -60,6 +60,8 @@ enum iproto_key {
 	IPROTO_SCHEMA_VERSION = 0x05,
 	IPROTO_SERVER_VERSION = 0x06,
 	IPROTO_GROUP_ID = 0x07,
+	/** Id of a stream the request belongs to, see IPROTO_BEGIN. */
+	IPROTO_STREAM_ID = 0x0a,
 	/* Leave a gap for other keys in the header. */
 	IPROTO_SPACE_ID = 0x10,
 	IPROTO_INDEX_ID = 0x11,
@@ -113,6 +115,8 @@ enum iproto_key {
 	 * }
 	 */
 	IPROTO_SQL_INFO = 0x42,
+	/** Id of a statement prepared with IPROTO_PREPARE. */
+	IPROTO_STMT_ID = 0x43,
 	IPROTO_KEY_MAX
 };
 
@@ -135,7 +139,7 @@ enum iproto_ballot_key {
 #define bit(c) (1ULL<<IPROTO_##c)
 
 #define IPROTO_HEAD_BMAP (bit(REQUEST_TYPE) | bit(SYNC) | bit(REPLICA_ID) |\
-			  bit(LSN) | bit(SCHEMA_VERSION))
+			  bit(LSN) | bit(SCHEMA_VERSION) | bit(STREAM_ID))
 #define IPROTO_DML_BODY_BMAP (bit(SPACE_ID) | bit(INDEX_ID) | bit(LIMIT) |\
 			      bit(OFFSET) | bit(ITERATOR) | bit(INDEX_BASE) |\
 			      bit(KEY) | bit(TUPLE) | bit(OPS) | bit(TUPLE_META))
@@ -195,6 +199,19 @@ enum iproto_type {
 	IPROTO_EXECUTE = 11,
 	/** No operation. Treated as DML, used to bump LSN. */
 	IPROTO_NOP = 12,
+	/** Compile an SQL statement and return its id. */
+	IPROTO_PREPARE = 13,
+	/**
+	 * Begin a transaction in a stream. Requests of a stream
+	 * are executed one by one in the order they were sent,
+	 * and the transaction spans all of them up to
+	 * IPROTO_COMMIT or IPROTO_ROLLBACK.
+	 */
+	IPROTO_BEGIN = 14,
+	/** Commit the transaction of a stream. */
+	IPROTO_COMMIT = 15,
+	/** Roll back the transaction of a stream. */
+	IPROTO_ROLLBACK = 16,
 	/** The maximum typecode used for box.stat() */
 	IPROTO_TYPE_STAT_MAX,
 
@@ -236,11 +253,25 @@ static inline const char *
 iproto_type_name(uint32_t type)
 {
 	/*
-	 * Sic: iptoto_type_strs[IPROTO_NOP] is NULL
-	 * to suppress box.stat() output.
+	 * Sic: iptoto_type_strs[IPROTO_NOP],
+	 * iproto_type_strs[IPROTO_PREPARE] and the stream
+	 * transaction control types are NULL to suppress
+	 * box.stat() output.
 	 */
-	if (type == IPROTO_NOP)
+	switch (type) {
+	case IPROTO_NOP:
 		return "NOP";
+	case IPROTO_PREPARE:
+		return "PREPARE";
+	case IPROTO_BEGIN:
+		return "BEGIN";
+	case IPROTO_COMMIT:
+		return "COMMIT";
+	case IPROTO_ROLLBACK:
+		return "ROLLBACK";
+	default:
+		break;
+	}
 
 	if (type < IPROTO_TYPE_STAT_MAX)
 		return iproto_type_strs[type];
@@ -309,6 +340,14 @@ iproto_type_is_request(uint32_t type)
 	return type > IPROTO_OK && type <= IPROTO_TYPE_STAT_MAX;
 }
 
+/** A transaction control request of a stream. */
+static inline bool
+iproto_type_is_txn_control(uint32_t type)
+{
+	return type == IPROTO_BEGIN || type == IPROTO_COMMIT ||
+	       type == IPROTO_ROLLBACK;
+}
+
 /**
  * The request is "synchronous": no other requests
  * on this connection should be taken before this one
@@ -357,6 +396,8 @@ enum vy_run_info_key {
 	VY_RUN_INFO_BLOOM = 7,
 	/** Number of statements of each type (map). */
 	VY_RUN_INFO_STMT_STAT = 8,
+	/** Distinct key estimates (tuple sketch). */
+	VY_RUN_INFO_SKETCH = 9,
 	/** The last key in this enum + 1 */
 	VY_RUN_INFO_KEY_MAX
 };
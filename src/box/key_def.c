@@ -136,6 +136,9 @@ key_def_set_cmp(struct key_def *def)
 {
 	def->tuple_compare = tuple_compare_create(def);
 	def->tuple_compare_with_key = tuple_compare_with_key_create(def);
+	def->has_exact_hint = def->part_count == 1 && !def->is_nullable &&
+			      (def->parts[0].type == FIELD_TYPE_UNSIGNED ||
+			       def->parts[0].type == FIELD_TYPE_INTEGER);
 	tuple_hash_func_set(def);
 	tuple_extract_key_set(def);
 }
@@ -157,6 +157,12 @@ struct key_def {
 	 * fields assumed to be MP_NIL.
 	 */
 	bool has_optional_parts;
+	/**
+	 * True, if the key is a single not nullable integer
+	 * part, so equal exact hints of tuples mean equal keys.
+	 * @sa hint_is_exact().
+	 */
+	bool has_exact_hint;
 	/** Key fields mask. @sa column_mask.h for details. */
 	uint64_t column_mask;
 	/** The size of the 'parts' array. */
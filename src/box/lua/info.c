@@ -90,6 +90,10 @@ lbox_pushapplier(lua_State *L, struct applier *applier)
 			       applier->last_row_time);
 		lua_settable(L, -3);
 
+		lua_pushstring(L, "queue");
+		lua_pushinteger(L, applier->queue_len);
+		lua_settable(L, -3);
+
 		char name[APPLIER_SOURCE_MAXLEN];
 		int total = uri_format(name, sizeof(name), &applier->uri, false);
 		/*
@@ -569,10 +569,16 @@ netbox_encode_execute(lua_State *L)
 
 	mpstream_encode_map(&stream, 3);
 
-	size_t len;
-	const char *query = lua_tolstring(L, 3, &len);
-	mpstream_encode_uint(&stream, IPROTO_SQL_TEXT);
-	mpstream_encode_strn(&stream, query, len);
+	if (lua_type(L, 3) == LUA_TNUMBER) {
+		uint32_t stmt_id = lua_tonumber(L, 3);
+		mpstream_encode_uint(&stream, IPROTO_STMT_ID);
+		mpstream_encode_uint(&stream, stmt_id);
+	} else {
+		size_t len;
+		const char *query = lua_tolstring(L, 3, &len);
+		mpstream_encode_uint(&stream, IPROTO_SQL_TEXT);
+		mpstream_encode_strn(&stream, query, len);
+	}
 
 	mpstream_encode_uint(&stream, IPROTO_SQL_BIND);
 	luamp_encode_tuple(L, cfg, &stream, 4);
@@ -584,6 +590,87 @@ netbox_encode_execute(lua_State *L)
 	return 0;
 }
 
+static int
+netbox_encode_prepare(lua_State *L)
+{
+	if (lua_gettop(L) < 3)
+		return luaL_error(L, "Usage: netbox.encode_prepare(ibuf, "\
+				  "sync, query)");
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_PREPARE);
+
+	mpstream_encode_map(&stream, 1);
+
+	size_t len;
+	const char *query = lua_tolstring(L, 3, &len);
+	mpstream_encode_uint(&stream, IPROTO_SQL_TEXT);
+	mpstream_encode_strn(&stream, query, len);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+/**
+ * Decode a response header into a table reused for all
+ * responses of a connection, so that no garbage is created
+ * per response. Only the keys used by the dispatcher are
+ * stored, other keys are skipped.
+ * @param Lua stack[1] Raw MessagePack pointer.
+ * @param Lua stack[2] Table to store the header in.
+ * @retval Position of the body start.
+ */
+static int
+netbox_decode_header(struct lua_State *L)
+{
+	uint32_t ctypeid;
+	const char *data = *(const char **)luaL_checkcdata(L, 1, &ctypeid);
+	luaL_checktype(L, 2, LUA_TTABLE);
+	static const uint32_t keys[] = {
+		IPROTO_REQUEST_TYPE, IPROTO_SYNC, IPROTO_SCHEMA_VERSION,
+	};
+	for (unsigned i = 0; i < lengthof(keys); i++) {
+		lua_pushnil(L);
+		lua_rawseti(L, 2, keys[i]);
+	}
+	assert(mp_typeof(*data) == MP_MAP);
+	uint32_t map_size = mp_decode_map(&data);
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*data) != MP_UINT) {
+			mp_next(&data);
+			mp_next(&data);
+			continue;
+		}
+		uint64_t key = mp_decode_uint(&data);
+		if ((key != IPROTO_REQUEST_TYPE && key != IPROTO_SYNC &&
+		     key != IPROTO_SCHEMA_VERSION) ||
+		    mp_typeof(*data) != MP_UINT) {
+			mp_next(&data);
+			continue;
+		}
+		luaL_pushuint64(L, mp_decode_uint(&data));
+		lua_rawseti(L, 2, key);
+	}
+	*(const char **)luaL_pushcdata(L, ctypeid) = data;
+	return 1;
+}
+
+/**
+ * Decode a tuple of IPROTO_DATA and push it onto the stack.
+ * @param L Lua stack to push result on.
+ * @param data MessagePack.
+ */
+static void
+netbox_decode_tuple_data(struct lua_State *L, const char **data)
+{
+	const char *begin = *data;
+	mp_next(data);
+	struct tuple *tuple =
+		box_tuple_new(box_tuple_format_default(), begin, *data);
+	if (tuple == NULL)
+		luaT_error(L);
+	luaT_pushtuple(L, tuple);
+}
+
 /**
  * Decode IPROTO_DATA into tuples array.
  * @param L Lua stack to push result on.
@@ -594,16 +681,8 @@ netbox_decode_data(struct lua_State *L, const char **data)
 {
 	uint32_t count = mp_decode_array(data);
 	lua_createtable(L, count, 0);
-	struct tuple_format *format =
-		box_tuple_format_default();
 	for (uint32_t j = 0; j < count; ++j) {
-		const char *begin = *data;
-		mp_next(data);
-		struct tuple *tuple =
-			box_tuple_new(format, begin, *data);
-		if (tuple == NULL)
-			luaT_error(L);
-		luaT_pushtuple(L, tuple);
+		netbox_decode_tuple_data(L, data);
 		lua_rawseti(L, -2, j + 1);
 	}
 }
@@ -632,6 +711,38 @@ netbox_decode_select(struct lua_State *L)
 	return 2;
 }
 
+/**
+ * Decode Tarantool response body consisting of single
+ * IPROTO_DATA key, which is expected to contain at most one
+ * tuple, without creating an intermediate array.
+ * @param Lua stack[1] Raw MessagePack pointer.
+ * @retval The first tuple or nil, position of the body end
+ *         and the number of tuples in the body.
+ */
+static int
+netbox_decode_tuple(struct lua_State *L)
+{
+	uint32_t ctypeid;
+	const char *data = *(const char **)luaL_checkcdata(L, 1, &ctypeid);
+	assert(mp_typeof(*data) == MP_MAP);
+	uint32_t map_size = mp_decode_map(&data);
+	assert(map_size == 1);
+	(void) map_size;
+	uint32_t key = mp_decode_uint(&data);
+	assert(key == IPROTO_DATA);
+	(void) key;
+	uint32_t count = mp_decode_array(&data);
+	if (count > 0)
+		netbox_decode_tuple_data(L, &data);
+	else
+		lua_pushnil(L);
+	for (uint32_t i = 1; i < count; i++)
+		mp_next(&data);
+	*(const char **)luaL_pushcdata(L, ctypeid) = data;
+	lua_pushinteger(L, count);
+	return 3;
+}
+
 /**
  * Decode IPROTO_METADATA into array of maps.
  * @param L Lua stack to push result on.
@@ -760,10 +871,13 @@ luaopen_net_box(struct lua_State *L)
 		{ "encode_update",  netbox_encode_update },
 		{ "encode_upsert",  netbox_encode_upsert },
 		{ "encode_execute", netbox_encode_execute},
+		{ "encode_prepare", netbox_encode_prepare},
 		{ "encode_auth",    netbox_encode_auth },
 		{ "decode_greeting",netbox_decode_greeting },
 		{ "communicate",    netbox_communicate },
+		{ "decode_header",  netbox_decode_header },
 		{ "decode_select",  netbox_decode_select },
+		{ "decode_tuple",   netbox_decode_tuple },
 		{ "decode_execute", netbox_decode_execute },
 		{ NULL, NULL}
 	};
@@ -26,6 +26,7 @@ local communicate     = internal.communicate
 local encode_auth     = internal.encode_auth
 local encode_select   = internal.encode_select
 local decode_greeting = internal.decode_greeting
+local decode_header   = internal.decode_header
 
 local TIMEOUT_INFINITY = 500 * 365 * 86400
 local VSPACE_ID        = 281
@@ -38,6 +39,7 @@ local IPROTO_SYNC_KEY      = 0x01
 local IPROTO_SCHEMA_VERSION_KEY = 0x05
 local IPROTO_METADATA_KEY = 0x32
 local IPROTO_SQL_INFO_KEY = 0x42
+local IPROTO_STMT_ID_KEY  = 0x43
 local SQL_INFO_ROW_COUNT_KEY = 0
 local IPROTO_FIELD_NAME_KEY = 0
 local IPROTO_DATA_KEY      = 0x30
@@ -63,20 +65,25 @@ local function decode_data(raw_data)
     return response[IPROTO_DATA_KEY], raw_end
 end
 local function decode_tuple(raw_data)
-    local response, raw_end = internal.decode_select(raw_data)
-    return response[1], raw_end
+    local tuple, raw_end = internal.decode_tuple(raw_data)
+    return tuple, raw_end
 end
 local function decode_get(raw_data)
-    local body, raw_end = internal.decode_select(raw_data)
-    if body[2] then
+    local tuple, raw_end, count = internal.decode_tuple(raw_data)
+    if count > 1 then
         return nil, raw_end, box.error.MORE_THAN_ONE_TUPLE
     end
-    return body[1], raw_end
+    return tuple, raw_end
 end
 local function decode_count(raw_data)
     local response, raw_end = decode(raw_data)
     return response[IPROTO_DATA_KEY][1], raw_end
 end
+local function decode_prepare(raw_data)
+    local response, raw_end = decode(raw_data)
+    return response[IPROTO_STMT_ID_KEY], raw_end
+end
+
 local function decode_push(raw_data)
     local response, raw_end = decode(raw_data)
     return response[IPROTO_DATA_KEY][1], raw_end
@@ -94,6 +101,7 @@ local method_encoder = {
     upsert  = internal.encode_upsert,
     select  = internal.encode_select,
     execute = internal.encode_execute,
+    prepare = internal.encode_prepare,
     get     = internal.encode_select,
     min     = internal.encode_select,
     max     = internal.encode_select,
@@ -118,6 +126,7 @@ local method_decoder = {
     upsert  = decode_nil,
     select  = internal.decode_select,
     execute = internal.decode_execute,
+    prepare = decode_prepare,
     get     = decode_get,
     min     = decode_get,
     max     = decode_get,
@@ -165,6 +174,102 @@ end
 --
 local function on_push_sync_default(...) end
 
+--
+-- A batch of requests to one or more connections whose
+-- responses are waited for collectively. Requests are added to
+-- a batch with {batch = batch} option of any request method.
+-- Such a request returns its position in the batch instead of
+-- a response. Batched requests don't have their own condition
+-- variables: a waiter is woken up only once all responses have
+-- arrived. Requests encoded without yields in between are sent
+-- with a single write, so a batch turns a fan-out of N requests
+-- into a handful of system calls.
+--
+-- A batch created with {discard = true} is fire-and-forget:
+-- requests are sent, but their responses are ignored.
+--
+local batch_methods = {}
+local batch_mt = { __index = batch_methods }
+
+local function new_batch(opts)
+    if opts ~= nil and type(opts) ~= 'table' then
+        error('Usage: net_box.new_batch([{size = n, discard = bool}])')
+    end
+    local size = opts and tonumber(opts.size) or 0
+    local batch = setmetatable(table_new(0, 4), batch_mt)
+    batch.requests = table_new(size, 0)
+    batch.pending = 0
+    batch.discard = opts and opts.discard or false
+    batch.cond = fiber.cond()
+    return batch
+end
+
+--
+-- Register a request sent as a part of a batch.
+-- @retval Position of the request in the batch.
+--
+function batch_methods:_add(request)
+    local pos = #self.requests + 1
+    self.requests[pos] = request
+    self.pending = self.pending + 1
+    return pos
+end
+
+--
+-- Called by a transport when a batched request is finished.
+--
+function batch_methods:_complete()
+    self.pending = self.pending - 1
+    if self.pending == 0 then
+        self.cond:broadcast()
+    end
+end
+
+--
+-- Wait until all requests of the batch are finished.
+-- @param timeout Max seconds to wait.
+-- @retval results, errors Responses in the order the requests
+--         were added, nil responses are replaced with box.NULL.
+--         Errors of failed requests are stored in errors table
+--         at their positions, errors is nil if all requests
+--         succeeded.
+-- @retval nil, error Timeout.
+--
+function batch_methods:wait(timeout)
+    if timeout then
+        if type(timeout) ~= 'number' or timeout < 0 then
+            error('Usage: batch:wait(timeout)')
+        end
+    else
+        timeout = TIMEOUT_INFINITY
+    end
+    while self.pending > 0 do
+        local ts = fiber_clock()
+        self.cond:wait(timeout)
+        timeout = timeout - (fiber_clock() - ts)
+        if self.pending > 0 and timeout <= 0 then
+            return nil, box.error.new(E_TIMEOUT)
+        end
+    end
+    local requests = self.requests
+    local count = #requests
+    local results = table_new(count, 0)
+    local errors
+    for i = 1, count do
+        local response, err = requests[i]:result()
+        if err then
+            errors = errors or {}
+            errors[i] = err
+            response = nil
+        end
+        if response == nil then
+            response = box.NULL
+        end
+        results[i] = response
+    end
+    return results, errors
+end
+
 --
 -- Basically, *transport* is a TCP connection speaking one of
 -- Tarantool network protocols. This is a low-level interface.
@@ -242,6 +347,9 @@ local function create_transport(host, port, user, password, callback,
     local worker_fiber
     local send_buf         = buffer.ibuf(buffer.READAHEAD)
     local recv_buf         = buffer.ibuf(buffer.READAHEAD)
+    -- Header of the last received response, reused to
+    -- avoid creating a table per response.
+    local hdr              = {}
 
     --
     -- Async request metamethods.
@@ -389,6 +497,19 @@ local function create_transport(host, port, user, password, callback,
 
     local request_mt = { __index = request_index }
 
+    --
+    -- Notify waiters that a request has received a push or
+    -- has been finished.
+    --
+    local function request_wakeup(request)
+        local batch = request.batch
+        if batch == nil then
+            request.cond:broadcast()
+        elseif request.id == nil then
+            batch:_complete()
+        end
+    end
+
     -- STATE SWITCHING --
     local function set_state(new_state, new_errno, new_error)
         state = new_state
@@ -402,7 +523,7 @@ local function create_transport(host, port, user, password, callback,
                 request.id = nil
                 request.errno = new_errno
                 request.response = new_error
-                request.cond:broadcast()
+                request_wakeup(request)
             end
             requests = {}
         end
@@ -479,12 +600,11 @@ local function create_transport(host, port, user, password, callback,
     end
 
     --
-    -- Send a request and do not wait for response.
+    -- Encode a request to the send buffer.
     -- @retval nil, error Error occured.
-    -- @retval not nil Future object.
+    -- @retval not nil Request id.
     --
-    local function perform_async_request(buffer, method, on_push, on_push_ctx,
-                                         ...)
+    local function encode_request(method, ...)
         if state ~= 'active' and state ~= 'fetch_schema' then
             return nil, box.error.new({code = last_errno or E_NO_CONNECTION,
                                        reason = last_error})
@@ -497,6 +617,20 @@ local function create_transport(host, port, user, password, callback,
         local id = next_request_id
         method_encoder[method](send_buf, id, ...)
         next_request_id = next_id(id)
+        return id
+    end
+
+    --
+    -- Send a request and do not wait for response.
+    -- @retval nil, error Error occured.
+    -- @retval not nil Future object.
+    --
+    local function perform_async_request(buffer, method, on_push, on_push_ctx,
+                                         ...)
+        local id, err = encode_request(method, ...)
+        if not id then
+            return nil, err
+        end
         -- Request in most cases has maximum 8 members:
         -- method, buffer, id, cond, errno, response, on_push,
         -- on_push_ctx.
@@ -511,6 +645,31 @@ local function create_transport(host, port, user, password, callback,
         return request
     end
 
+    --
+    -- Send a request as a part of a batch. The response is
+    -- stored in the request object referenced by the batch.
+    -- @retval nil, error Error occured.
+    -- @retval pos Position of the request in the batch, nil
+    --         if the batch discards responses.
+    --
+    local function perform_batch_request(batch, buffer, method, ...)
+        local id, err = encode_request(method, ...)
+        if not id then
+            return nil, err
+        end
+        if batch.discard then
+            return
+        end
+        local request = setmetatable(table_new(0, 8), request_mt)
+        request.method = method
+        request.buffer = buffer
+        request.id = id
+        request.batch = batch
+        request.on_push = on_push_sync_default
+        requests[id] = request
+        return batch:_add(request)
+    end
+
     --
     -- Send a request and wait for response.
     -- @retval nil, error Error occured.
@@ -543,7 +702,7 @@ local function create_transport(host, port, user, password, callback,
             assert(body_end == body_end_check, "invalid xrow length")
             request.errno = band(status, IPROTO_ERRNO_MASK)
             request.response = body[IPROTO_ERROR_KEY]
-            request.cond:broadcast()
+            request_wakeup(request)
             return
         end
 
@@ -561,7 +720,7 @@ local function create_transport(host, port, user, password, callback,
             else
                 request.on_push(request.on_push_ctx, body_len)
             end
-            request.cond:broadcast()
+            request_wakeup(request)
             return
         end
 
@@ -580,7 +739,7 @@ local function create_transport(host, port, user, password, callback,
             assert(real_end == body_end, "invalid body length")
             request.on_push(request.on_push_ctx, msg)
         end
-        request.cond:broadcast()
+        request_wakeup(request)
     end
 
     local function new_request_id()
@@ -607,7 +766,7 @@ local function create_transport(host, port, user, password, callback,
             required = (rpos - bufpos) + len
             if data_len >= required then
                 local body_end = rpos + len
-                local hdr, body_rpos = decode(rpos)
+                local body_rpos = decode_header(rpos, hdr)
                 recv_buf.rpos = body_end
                 return nil, hdr, body_rpos, body_end
             end
@@ -691,7 +850,7 @@ local function create_transport(host, port, user, password, callback,
             request.id = nil
             requests[rid] = nil
             request.response = response
-            request.cond:broadcast()
+            request_wakeup(request)
             return console_sm(next_id(rid))
         end
     end
@@ -798,6 +957,7 @@ local function create_transport(host, port, user, password, callback,
         wait_state      = wait_state,
         perform_request = perform_request,
         perform_async_request = perform_async_request,
+        perform_batch_request = perform_batch_request,
     }
 end
 
@@ -1052,6 +1212,15 @@ function remote_methods:_request(method, opts, ...)
     -- async.
     if opts then
         buffer = opts.buffer
+        if opts.batch then
+            local pos, err = transport.perform_batch_request(opts.batch,
+                                                             buffer, method,
+                                                             ...)
+            if err then
+                box.error(err)
+            end
+            return pos
+        end
         if opts.is_async then
             if opts.on_push or opts.on_push_ctx then
                 error('To handle pushes in an async request use future:pairs()')
@@ -1147,6 +1316,11 @@ function remote_methods:execute(query, parameters, sql_opts, netbox_opts)
                          sql_opts or {})
 end
 
+function remote_methods:prepare(query, netbox_opts)
+    check_remote_arg(self, "prepare")
+    return self:_request('prepare', netbox_opts, query)
+end
+
 function remote_methods:wait_state(state, timeout)
     check_remote_arg(self, 'wait_state')
     if timeout == nil then
@@ -1398,6 +1572,9 @@ index_metatable = function(remote)
         if opts and opts.buffer then
             error("index:count() doesn't support `buffer` argument")
         end
+        if opts and opts.batch then
+            error("index:count() doesn't support `batch` argument")
+        end
         local code = string.format('box.space.%s.index.%s:count',
                                    self.space.name, self.name)
         return remote:_request('count', opts, code, { key, opts })
@@ -1423,6 +1600,7 @@ local this_module = {
     connect = connect,
     new = connect, -- Tarantool < 1.7.1 compatibility,
     wrap = wrap,
+    new_batch = new_batch,
     establish_connection = establish_connection,
 }
 
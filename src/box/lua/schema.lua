@@ -699,6 +699,7 @@ local index_options = {
     range_size = 'number',
     page_size = 'number',
     bloom_fpr = 'number',
+    sketch = 'boolean',
 }
 
 --
@@ -804,6 +805,7 @@ box.schema.index.create = function(space_id, name, options)
             run_count_per_level = options.run_count_per_level,
             run_size_ratio = options.run_size_ratio,
             bloom_fpr = options.bloom_fpr,
+            sketch = options.sketch,
     }
     local field_type_aliases = {
         num = 'unsigned'; -- Deprecated since 1.7.2
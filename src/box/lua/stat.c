@@ -42,14 +42,14 @@
 #include "box/iproto.h"
 #include "box/engine.h"
 #include "box/vinyl.h"
+#include "box/wal.h"
+#include "box/sql_stmt_cache.h"
 #include <info.h>
 #include "lua/info.h"
 #include "lua/utils.h"
 
 extern struct rmean *rmean_box;
 extern struct rmean *rmean_error;
-/** network statistics (iproto & cbus) */
-extern struct rmean *rmean_net;
 extern struct rmean *rmean_tx_wal_bus;
 
 static void
@@ -127,6 +127,24 @@ lbox_stat_vinyl(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_stat_wal(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	wal_stat(&h);
+	return 1;
+}
+
+static int
+lbox_stat_sql(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	sql_stmt_cache_stat(&h);
+	return 1;
+}
+
 static int
 lbox_stat_reset(struct lua_State *L)
 {
@@ -136,18 +154,64 @@ lbox_stat_reset(struct lua_State *L)
 	return 0;
 }
 
+/**
+ * A stat_foreach() callback used to sum up statistics of
+ * all network threads in a table on top of the stack.
+ */
 static int
-lbox_stat_net_index(struct lua_State *L)
+sum_stat_item(const char *name, int rps, int64_t total, void *cb_ctx)
 {
-	luaL_checkstring(L, -1);
-	return rmean_foreach(rmean_net, seek_stat_item, L);
+	struct lua_State *L = (struct lua_State *) cb_ctx;
+
+	lua_getfield(L, -1, name);
+	if (lua_isnil(L, -1)) {
+		lua_pop(L, 1);
+		lua_newtable(L);
+		fill_stat_item(L, rps, total);
+		lua_setfield(L, -2, name);
+		return 0;
+	}
+	lua_getfield(L, -1, "rps");
+	rps += (int) lua_tonumber(L, -1);
+	lua_getfield(L, -2, "total");
+	total += (int64_t) lua_tonumber(L, -1);
+	lua_pop(L, 2);
+	fill_stat_item(L, rps, total);
+	lua_pop(L, 1);
+	return 0;
 }
 
 static int
 lbox_stat_net_call(struct lua_State *L)
 {
 	lua_newtable(L);
-	rmean_foreach(rmean_net, set_stat_item, L);
+	for (int i = 0; i < iproto_threads_count; i++)
+		rmean_foreach(iproto_thread_rmean(i), sum_stat_item, L);
+	return 1;
+}
+
+static int
+lbox_stat_net_index(struct lua_State *L)
+{
+	const char *name = luaL_checkstring(L, -1);
+	lbox_stat_net_call(L);
+	lua_getfield(L, -1, name);
+	return 1;
+}
+
+/**
+ * Return network statistics of each network thread,
+ * box.stat.net.thread().
+ */
+static int
+lbox_stat_net_thread(struct lua_State *L)
+{
+	lua_createtable(L, iproto_threads_count, 0);
+	for (int i = 0; i < iproto_threads_count; i++) {
+		lua_newtable(L);
+		rmean_foreach(iproto_thread_rmean(i), set_stat_item, L);
+		lua_rawseti(L, -2, i + 1);
+	}
 	return 1;
 }
 
@@ -169,6 +233,8 @@ box_lua_stat_init(struct lua_State *L)
 {
 	static const struct luaL_Reg statlib [] = {
 		{"vinyl", lbox_stat_vinyl},
+		{"wal", lbox_stat_wal},
+		{"sql", lbox_stat_sql},
 		{"reset", lbox_stat_reset},
 		{NULL, NULL}
 	};
@@ -181,6 +247,7 @@ box_lua_stat_init(struct lua_State *L)
 	lua_pop(L, 1); /* stat module */
 
 	static const struct luaL_Reg netstatlib [] = {
+		{"thread", lbox_stat_net_thread},
 		{NULL, NULL}
 	};
 
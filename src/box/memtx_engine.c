@@ -41,9 +41,11 @@
 #include "tuple.h"
 #include "txn.h"
 #include "memtx_tree.h"
+#include "memtx_tx.h"
 #include "iproto_constants.h"
 #include "xrow.h"
 #include "xstream.h"
+#include "xlog_reader.h"
 #include "bootstrap.h"
 #include "replication.h"
 #include "schema.h"
@@ -88,17 +90,14 @@ memtx_init_txn(struct txn *txn)
 
 	trigger_create(&txn->fiber_on_yield, txn_on_yield,
 		       NULL, NULL);
-	trigger_create(&txn->fiber_on_stop, txn_on_stop,
-		       NULL, NULL);
 	/*
 	 * Memtx doesn't allow yields between statements of
 	 * a transaction. Set a trigger which would roll
 	 * back the transaction if there is a yield.
 	 */
 	trigger_add(&fiber->on_yield, &txn->fiber_on_yield);
-	trigger_add(&fiber->on_stop, &txn->fiber_on_stop);
 	/*
-	 * This serves as a marker that the triggers are
+	 * This serves as a marker that the trigger is
 	 * initialized.
 	 */
 	txn->engine_tx = txn;
@@ -190,6 +189,7 @@ memtx_engine_shutdown(struct engine *engine)
 	slab_cache_destroy(&memtx->slab_cache);
 	tuple_arena_destroy(&memtx->arena);
 	xdir_destroy(&memtx->snap_dir);
+	memtx_tx_manager_free();
 	free(memtx);
 }
 
@@ -208,15 +208,19 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 						    signature, NONE);
 
 	say_info("recovering from `%s'", filename);
-	struct xlog_cursor cursor;
-	if (xlog_cursor_open(&cursor, filename) < 0)
+	/*
+	 * Read and decompress the snapshot in a separate
+	 * thread, while rows are applied here.
+	 */
+	struct xlog_reader *reader = xlog_reader_new(filename,
+						     memtx->force_recovery);
+	if (reader == NULL)
 		return -1;
 
 	int rc;
 	struct xrow_header row;
 	uint64_t row_count = 0;
-	while ((rc = xlog_cursor_next(&cursor, &row,
-				      memtx->force_recovery)) == 0) {
+	while ((rc = xlog_reader_next(reader, &row)) == 0) {
 		row.lsn = signature;
 		rc = memtx_engine_recover_snapshot_row(memtx, &row);
 		if (rc < 0) {
@@ -232,7 +236,8 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 			fiber_yield_timeout(0);
 		}
 	}
-	xlog_cursor_close(&cursor, false);
+	bool is_eof = xlog_reader_is_eof(reader);
+	xlog_reader_delete(reader);
 	if (rc < 0)
 		return -1;
 
@@ -241,7 +246,7 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 	 * marker - such snapshots are very likely corrupted and
 	 * should not be trusted.
 	 */
-	if (!xlog_cursor_is_eof(&cursor))
+	if (!is_eof)
 		panic("snapshot `%s' has no EOF marker", filename);
 
 	return 0;
@@ -368,20 +373,21 @@ static int
 memtx_engine_prepare(struct engine *engine, struct txn *txn)
 {
 	(void)engine;
-	if (txn->engine_tx == 0)
-		return 0;
-	/*
-	 * These triggers are only used for memtx and only
-	 * when autocommit == false, so we are saving
-	 * on calls to trigger_create/trigger_clear.
-	 */
-	trigger_clear(&txn->fiber_on_yield);
-	trigger_clear(&txn->fiber_on_stop);
-	if (txn->is_aborted) {
-		diag_set(ClientError, ER_TRANSACTION_YIELD);
-		diag_log();
-		return -1;
+	if (txn->engine_tx != NULL) {
+		/*
+		 * This trigger is only used for memtx and only
+		 * when autocommit == false, so we are saving
+		 * on calls to trigger_create/trigger_clear.
+		 */
+		trigger_clear(&txn->fiber_on_yield);
+		if (txn->is_aborted) {
+			diag_set(ClientError, ER_TRANSACTION_YIELD);
+			diag_log();
+			return -1;
+		}
 	}
+	if (memtx_tx_manager_use_mvcc_engine)
+		return memtx_tx_prepare(txn);
 	return 0;
 }
 
@@ -394,8 +400,12 @@ memtx_engine_begin(struct engine *engine, struct txn *txn)
 	 * This must be done in begin(), since it's
 	 * the first thing txn invokes after txn->n_stmts++,
 	 * to match with trigger_clear() in rollbackStatement().
+	 * With MVCC, yields are allowed unless the transaction
+	 * touches a space that isn't multi-versioned, see
+	 * memtx_engine_begin_statement().
 	 */
-	if (txn->is_autocommit == false) {
+	if (txn->is_autocommit == false &&
+	    !memtx_tx_manager_use_mvcc_engine) {
 		memtx_init_txn(txn);
 	}
 	return 0;
@@ -409,6 +419,17 @@ memtx_engine_begin_statement(struct engine *engine, struct txn *txn)
 	if (txn->engine_tx == NULL) {
 		struct space *space = txn_last_stmt(txn)->space;
 
+		if (((struct memtx_space *)space)->is_mvcc)
+			return 0;
+		if (!txn->is_autocommit) {
+			/*
+			 * A multi-version transaction has come
+			 * to a space that doesn't support it,
+			 * so it can't yield anymore.
+			 */
+			memtx_init_txn(txn);
+			return 0;
+		}
 		if (space->def->id > BOX_SYSTEM_ID_MAX &&
 		    ! rlist_empty(&space->on_replace)) {
 			/**
@@ -422,6 +443,14 @@ memtx_engine_begin_statement(struct engine *engine, struct txn *txn)
 	return 0;
 }
 
+static void
+memtx_engine_commit(struct engine *engine, struct txn *txn)
+{
+	(void)engine;
+	if (memtx_tx_manager_use_mvcc_engine)
+		memtx_tx_commit(txn);
+}
+
 static void
 memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 				struct txn_stmt *stmt)
@@ -438,6 +467,10 @@ memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 	if (stmt->engine_savepoint == NULL)
 		return;
 
+	if (memtx_space->is_mvcc &&
+	    memtx_space->replace == memtx_space_replace_all_keys)
+		return memtx_tx_history_rollback_stmt(stmt);
+
 	if (memtx_space->replace == memtx_space_replace_all_keys)
 		index_count = space->index_count;
 	else if (memtx_space->replace == memtx_space_replace_primary_key)
@@ -467,10 +500,8 @@ memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 static void
 memtx_engine_rollback(struct engine *engine, struct txn *txn)
 {
-	if (txn->engine_tx != NULL) {
+	if (txn->engine_tx != NULL)
 		trigger_clear(&txn->fiber_on_yield);
-		trigger_clear(&txn->fiber_on_stop);
-	}
 	struct txn_stmt *stmt;
 	stailq_reverse(&txn->stmts);
 	stailq_foreach_entry(stmt, &txn->stmts, next)
@@ -709,9 +740,7 @@ memtx_engine_begin_checkpoint(struct engine *engine)
 		return -1;
 	}
 
-	/* increment snapshot version; set tuple deletion to delayed mode */
-	memtx->snapshot_version++;
-	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, true);
+	memtx_enter_delayed_free_mode(memtx);
 	return 0;
 }
 
@@ -759,7 +788,7 @@ memtx_engine_commit_checkpoint(struct engine *engine,
 	/* waitCheckpoint() must have been done. */
 	assert(!memtx->checkpoint->waiting_for_snap_thread);
 
-	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
+	memtx_leave_delayed_free_mode(memtx);
 
 	if (!memtx->checkpoint->touch) {
 		int64_t lsn = vclock_sum(&memtx->checkpoint->vclock);
@@ -808,7 +837,7 @@ memtx_engine_abort_checkpoint(struct engine *engine)
 		memtx->checkpoint->waiting_for_snap_thread = false;
 	}
 
-	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
+	memtx_leave_delayed_free_mode(memtx);
 
 	/** Remove garbage .inprogress file. */
 	char *filename =
@@ -949,7 +978,7 @@ static const struct engine_vtab memtx_engine_vtab = {
 	/* .begin = */ memtx_engine_begin,
 	/* .begin_statement = */ memtx_engine_begin_statement,
 	/* .prepare = */ memtx_engine_prepare,
-	/* .commit = */ generic_engine_commit,
+	/* .commit = */ memtx_engine_commit,
 	/* .rollback_statement = */ memtx_engine_rollback_statement,
 	/* .rollback = */ memtx_engine_rollback,
 	/* .bootstrap = */ memtx_engine_bootstrap,
@@ -1022,6 +1051,7 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 
 	xdir_create(&memtx->snap_dir, snap_dirname, SNAP, &INSTANCE_UUID);
 	memtx->snap_dir.force_recovery = force_recovery;
+	memtx_tx_manager_init();
 
 	if (xdir_scan(&memtx->snap_dir) != 0)
 		goto fail;
@@ -1079,10 +1109,12 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 
 	memtx->state = MEMTX_INITIALIZED;
 	memtx->max_tuple_size = MAX_TUPLE_SIZE;
+	memtx->sort_threads = 0;
 	memtx->force_recovery = force_recovery;
 
 	memtx->base.vtab = &memtx_engine_vtab;
 	memtx->base.name = "memtx";
+	memtx->base.flags = ENGINE_READ_NO_YIELD;
 
 	fiber_start(memtx->gc_fiber, memtx);
 	return memtx;
@@ -1092,6 +1124,46 @@ fail:
 	return NULL;
 }
 
+/**
+ * Free the tuples left by the previous users of the delayed
+ * free mode. After the mode is left, the allocator frees them
+ * a batch per allocation, so if the mode is entered again soon,
+ * e.g. by the next read view, they would pile up.
+ */
+static void
+memtx_collect_delayed_garbage(struct memtx_engine *memtx)
+{
+	size_t size = sizeof(struct memtx_tuple);
+	while (memtx->alloc.free_mode == SMALL_COLLECT_GARBAGE) {
+		void *ptr = smalloc(&memtx->alloc, size);
+		if (ptr == NULL)
+			break;
+		smfree(&memtx->alloc, ptr, size);
+	}
+}
+
+void
+memtx_enter_delayed_free_mode(struct memtx_engine *memtx)
+{
+	/*
+	 * Tuples allocated after this point have a newer
+	 * version and are freed immediately as before.
+	 */
+	memtx->snapshot_version++;
+	if (memtx->delayed_free_mode++ == 0) {
+		memtx_collect_delayed_garbage(memtx);
+		small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, true);
+	}
+}
+
+void
+memtx_leave_delayed_free_mode(struct memtx_engine *memtx)
+{
+	assert(memtx->delayed_free_mode > 0);
+	if (--memtx->delayed_free_mode == 0)
+		small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
+}
+
 void
 memtx_engine_schedule_gc(struct memtx_engine *memtx,
 			 struct memtx_gc_task *task)
@@ -1124,6 +1196,12 @@ memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size)
 	memtx->max_tuple_size = max_size;
 }
 
+void
+memtx_engine_set_sort_threads(struct memtx_engine *memtx, int threads)
+{
+	memtx->sort_threads = threads;
+}
+
 struct tuple *
 memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 {
@@ -1292,6 +1370,9 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 		return true;
 	if (!old_def->opts.is_unique && new_def->opts.is_unique)
 		return true;
+	/* Distinct key estimates are collected on build. */
+	if (old_def->opts.sketch != new_def->opts.sketch)
+		return true;
 
 	const struct key_def *old_cmp_def, *new_cmp_def;
 	if (index_depends_on_pk(index)) {
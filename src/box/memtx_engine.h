@@ -127,8 +127,20 @@ struct memtx_engine {
 	void *reserved_extents;
 	/** Maximal allowed tuple size, box.cfg.memtx_max_tuple_size. */
 	size_t max_tuple_size;
+	/**
+	 * Number of threads used for sorting tuples when tree
+	 * indexes are built in bulk, box.cfg.memtx_sort_threads.
+	 * 0 means the number of CPUs.
+	 */
+	int sort_threads;
 	/** Incremented with each next snapshot. */
 	uint32_t snapshot_version;
+	/**
+	 * Number of users of the delayed free mode: a checkpoint
+	 * in progress and read views of indexes.
+	 * @sa memtx_enter_delayed_free_mode().
+	 */
+	uint32_t delayed_free_mode;
 	/** Memory pool for tree index iterator. */
 	struct mempool tree_iterator_pool;
 	/** Memory pool for rtree index iterator. */
@@ -171,6 +183,22 @@ struct memtx_gc_task {
 	const struct memtx_gc_task_vtab *vtab;
 };
 
+/**
+ * Switch the tuple allocator to the delayed free mode: tuples
+ * that exist now are not freed until the mode is left, so they
+ * can be read from other threads, e.g. by a checkpoint. Calls
+ * may be nested, the mode is left on the last leave call.
+ * Each call starts a new 32-bit tuple version, so users that
+ * need it at the same time, like a group of read views, should
+ * share one call.
+ */
+void
+memtx_enter_delayed_free_mode(struct memtx_engine *memtx);
+
+/** Leave the delayed free mode entered before. */
+void
+memtx_leave_delayed_free_mode(struct memtx_engine *memtx);
+
 /**
  * Schedule a garbage collection task for execution.
  */
@@ -196,6 +224,9 @@ memtx_engine_set_memory(struct memtx_engine *memtx, size_t size);
 void
 memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size);
 
+void
+memtx_engine_set_sort_threads(struct memtx_engine *memtx, int threads);
+
 /** Allocate a memtx tuple. @sa tuple_new(). */
 struct tuple *
 memtx_tuple_new(struct tuple_format *format, const char *data, const char *end);
@@ -209,7 +240,9 @@ extern struct tuple_format_vtab memtx_tuple_format_vtab;
 
 enum {
 	MEMTX_EXTENT_SIZE = 16 * 1024,
-	MEMTX_SLAB_SIZE = 4 * 1024 * 1024
+	MEMTX_SLAB_SIZE = 4 * 1024 * 1024,
+	/** The maximal value of box.cfg.memtx_sort_threads. */
+	MEMTX_SORT_THREADS_MAX = 256,
 };
 
 /**
@@ -33,7 +33,10 @@
 #include "fiber.h"
 #include "tuple.h"
 #include "tuple_hash.h"
+#include "tuple_sketch.h"
+#include "txn.h"
 #include "memtx_engine.h"
+#include "memtx_tx.h"
 #include "space.h"
 #include "schema.h" /* space_cache_find() */
 #include "errinj.h"
@@ -59,7 +62,7 @@ hash_iterator_free(struct iterator *iterator)
 }
 
 static int
-hash_iterator_ge(struct iterator *ptr, struct tuple **ret)
+hash_iterator_ge_base(struct iterator *ptr, struct tuple **ret)
 {
 	assert(ptr->free == hash_iterator_free);
 	struct hash_iterator *it = (struct hash_iterator *) ptr;
@@ -70,7 +73,10 @@ hash_iterator_ge(struct iterator *ptr, struct tuple **ret)
 }
 
 static int
-hash_iterator_gt(struct iterator *ptr, struct tuple **ret)
+hash_iterator_ge(struct iterator *ptr, struct tuple **ret);
+
+static int
+hash_iterator_gt_base(struct iterator *ptr, struct tuple **ret)
 {
 	assert(ptr->free == hash_iterator_free);
 	ptr->next = hash_iterator_ge;
@@ -84,6 +90,30 @@ hash_iterator_gt(struct iterator *ptr, struct tuple **ret)
 	return 0;
 }
 
+/**
+ * Wrap a method that returns the next tuple stored in the hash
+ * so that it skips tuples invisible to the current transaction
+ * and returns the visible versions of the rest.
+ */
+#define WRAP_ITERATOR_METHOD(name)						\
+static int									\
+name(struct iterator *iterator, struct tuple **ret)				\
+{										\
+	struct txn *txn = in_txn();						\
+	uint32_t iid = iterator->index->def->iid;				\
+	do {									\
+		int rc = name##_base(iterator, ret);				\
+		if (rc != 0 || *ret == NULL)					\
+			return rc;						\
+		*ret = memtx_tx_tuple_clarify(txn, *ret, iid);			\
+	} while (*ret == NULL);							\
+	return 0;								\
+}										\
+struct forgot_to_add_semicolon
+
+WRAP_ITERATOR_METHOD(hash_iterator_ge);
+WRAP_ITERATOR_METHOD(hash_iterator_gt);
+
 static int
 hash_iterator_eq_next(MAYBE_UNUSED struct iterator *it, struct tuple **ret)
 {
@@ -92,10 +122,102 @@ hash_iterator_eq_next(MAYBE_UNUSED struct iterator *it, struct tuple **ret)
 }
 
 static int
-hash_iterator_eq(struct iterator *it, struct tuple **ret)
+hash_iterator_eq_base(struct iterator *it, struct tuple **ret)
 {
 	it->next = hash_iterator_eq_next;
-	return hash_iterator_ge(it, ret);
+	return hash_iterator_ge_base(it, ret);
+}
+
+WRAP_ITERATOR_METHOD(hash_iterator_eq);
+
+#undef WRAP_ITERATOR_METHOD
+
+/* }}} */
+
+/* {{{ MemtxHash read views ****************************************/
+
+struct memtx_hash_read_view {
+	struct memtx_hash_index *index;
+	struct light_index_view view;
+	/**
+	 * Copy of the index key definition, which may be changed
+	 * or freed by ALTER while the view is in use.
+	 */
+	struct key_def *key_def;
+	/** Resolves the versions visible in multi-versioned spaces. */
+	struct memtx_tx_snapshot_cleaner cleaner;
+};
+
+static void
+memtx_hash_index_free(struct memtx_hash_index *index);
+
+struct memtx_hash_read_view *
+memtx_hash_read_view_new(struct index *base)
+{
+	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
+	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+	/* Tuples must outlive the view, see the header. */
+	assert(memtx->delayed_free_mode > 0);
+	(void)memtx;
+	struct space *space = space_by_id(base->def->space_id);
+	if (space == NULL || space_is_temporary(space)) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Temporary space",
+			 "read views");
+		return NULL;
+	}
+	struct memtx_hash_read_view *rv =
+		(struct memtx_hash_read_view *)malloc(sizeof(*rv));
+	if (rv == NULL) {
+		diag_set(OutOfMemory, sizeof(*rv),
+			 "malloc", "struct memtx_hash_read_view");
+		return NULL;
+	}
+	rv->key_def = key_def_dup(base->def->key_def);
+	if (rv->key_def == NULL) {
+		free(rv);
+		return NULL;
+	}
+	if (memtx_tx_snapshot_cleaner_create(&rv->cleaner, base) != 0) {
+		key_def_delete(rv->key_def);
+		free(rv);
+		return NULL;
+	}
+	rv->index = index;
+	index->read_view_count++;
+	light_index_view_create(&index->hash_table, &rv->view);
+	rv->view.arg = rv->key_def;
+	return rv;
+}
+
+void
+memtx_hash_read_view_delete(struct memtx_hash_read_view *rv)
+{
+	struct memtx_hash_index *index = rv->index;
+	light_index_view_destroy(&index->hash_table, &rv->view);
+	memtx_tx_snapshot_cleaner_destroy(&rv->cleaner);
+	key_def_delete(rv->key_def);
+	free(rv);
+	assert(index->read_view_count > 0);
+	if (--index->read_view_count == 0 && index->is_dropped)
+		memtx_hash_index_free(index);
+}
+
+struct tuple *
+memtx_hash_read_view_get(struct memtx_hash_read_view *rv, const char *key)
+{
+	struct light_index_core *hash_table = &rv->index->hash_table;
+	uint32_t h = key_hash(key, rv->key_def);
+	uint32_t k = light_index_view_find_key(hash_table, &rv->view, h, key);
+	if (k == light_index_end)
+		return NULL;
+	struct tuple *tuple = light_index_view_get(hash_table, &rv->view, k);
+	return memtx_tx_snapshot_clarify(&rv->cleaner, tuple);
+}
+
+struct key_def *
+memtx_hash_read_view_key_def(struct memtx_hash_read_view *rv)
+{
+	return rv->key_def;
 }
 
 /* }}} */
@@ -105,7 +227,14 @@ hash_iterator_eq(struct iterator *it, struct tuple **ret)
 static void
 memtx_hash_index_free(struct memtx_hash_index *index)
 {
+	if (index->read_view_count > 0) {
+		/* Freed by the last read view. */
+		index->is_dropped = true;
+		return;
+	}
 	light_index_destroy(&index->hash_table);
+	if (index->base.sketch != NULL)
+		tuple_sketch_delete(index->base.sketch);
 	free(index);
 }
 
@@ -187,7 +316,8 @@ static ssize_t
 memtx_hash_index_size(struct index *base)
 {
 	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
-	return index->hash_table.count;
+	return index->hash_table.count -
+	       memtx_tx_index_invisible_count(in_txn(), base);
 }
 
 static ssize_t
@@ -212,7 +342,9 @@ memtx_hash_index_random(struct index *base, uint32_t rnd, struct tuple **result)
 		rnd++;
 		rnd %= (hash_table->table_size);
 	}
-	*result = light_index_get(hash_table, rnd);
+	*result = memtx_tx_tuple_clarify(in_txn(),
+					 light_index_get(hash_table, rnd),
+					 base->def->iid);
 	return 0;
 }
 
@@ -238,8 +370,11 @@ memtx_hash_index_get(struct index *base, const char *key,
 	*result = NULL;
 	uint32_t h = key_hash(key, base->def->key_def);
 	uint32_t k = light_index_find_key(&index->hash_table, h, key);
-	if (k != light_index_end)
-		*result = light_index_get(&index->hash_table, k);
+	if (k != light_index_end) {
+		struct tuple *tuple = light_index_get(&index->hash_table, k);
+		*result = memtx_tx_tuple_clarify(in_txn(), tuple,
+						 base->def->iid);
+	}
 	return 0;
 }
 
@@ -287,6 +422,9 @@ memtx_hash_index_replace(struct index *base, struct tuple *old_tuple,
 					 space_name(sp));
 			return -1;
 		}
+		if (base->sketch != NULL)
+			tuple_sketch_add(base->sketch, new_tuple,
+					 base->def->key_def);
 
 		if (dup_tuple) {
 			*result = dup_tuple;
@@ -358,6 +496,8 @@ struct hash_snapshot_iterator {
 	struct snapshot_iterator base;
 	struct light_index_core *hash_table;
 	struct light_index_iterator iterator;
+	/** Resolves the versions to write for multi-versioned spaces. */
+	struct memtx_tx_snapshot_cleaner cleaner;
 };
 
 /**
@@ -372,6 +512,7 @@ hash_snapshot_iterator_free(struct snapshot_iterator *iterator)
 	struct hash_snapshot_iterator *it =
 		(struct hash_snapshot_iterator *) iterator;
 	light_index_iterator_destroy(it->hash_table, &it->iterator);
+	memtx_tx_snapshot_cleaner_destroy(&it->cleaner);
 	free(iterator);
 }
 
@@ -386,11 +527,17 @@ hash_snapshot_iterator_next(struct snapshot_iterator *iterator, uint32_t *size)
 	assert(iterator->free == hash_snapshot_iterator_free);
 	struct hash_snapshot_iterator *it =
 		(struct hash_snapshot_iterator *) iterator;
-	struct tuple **res = light_index_iterator_get_and_next(it->hash_table,
-							       &it->iterator);
-	if (res == NULL)
-		return NULL;
-	return tuple_data_range(*res, size);
+	while (true) {
+		struct tuple **res =
+			light_index_iterator_get_and_next(it->hash_table,
+							  &it->iterator);
+		if (res == NULL)
+			return NULL;
+		struct tuple *tuple =
+			memtx_tx_snapshot_clarify(&it->cleaner, *res);
+		if (tuple != NULL)
+			return tuple_data_range(tuple, size);
+	}
 }
 
 /**
@@ -409,6 +556,10 @@ memtx_hash_index_create_snapshot_iterator(struct index *base)
 			 "memtx_hash_index", "iterator");
 		return NULL;
 	}
+	if (memtx_tx_snapshot_cleaner_create(&it->cleaner, base) != 0) {
+		free(it);
+		return NULL;
+	}
 
 	it->base.next = hash_snapshot_iterator_next;
 	it->base.free = hash_snapshot_iterator_free;
@@ -468,6 +619,16 @@ memtx_hash_index_new(struct memtx_engine *memtx, struct index_def *def)
 		free(index);
 		return NULL;
 	}
+	/* Collect distinct key estimates for the SQL planner. */
+	if (def->space_id != 0 && def->opts.sketch) {
+		index->base.sketch =
+			tuple_sketch_new(def->key_def->part_count);
+		if (index->base.sketch == NULL) {
+			index_def_delete(index->base.def);
+			free(index);
+			return NULL;
+		}
+	}
 
 	light_index_create(&index->hash_table, MEMTX_EXTENT_SIZE,
 			   memtx_index_extent_alloc, memtx_index_extent_free,
@@ -32,6 +32,7 @@
  */
 #include "index.h"
 #include "memtx_engine.h"
+#include "tuple_compare.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -52,12 +53,25 @@ memtx_hash_equal_key(struct tuple *tuple, const char *key,
 				      key_def) == 0;
 }
 
+/**
+ * Used by lookups in read views, which may run in other threads
+ * and so must not look at tuple formats.
+ */
+static inline bool
+memtx_hash_view_equal_key(struct tuple *tuple, const char *key,
+			  struct key_def *key_def)
+{
+	return tuple_compare_with_key_raw(tuple_data(tuple), key,
+					  key_def->part_count, key_def) == 0;
+}
+
 #define LIGHT_NAME _index
 #define LIGHT_DATA_TYPE struct tuple *
 #define LIGHT_KEY_TYPE const char *
 #define LIGHT_CMP_ARG_TYPE struct key_def *
 #define LIGHT_EQUAL(a, b, c) memtx_hash_equal(a, b, c)
 #define LIGHT_EQUAL_KEY(a, b, c) memtx_hash_equal_key(a, b, c)
+#define LIGHT_VIEW_EQUAL_KEY(a, b, c) memtx_hash_view_equal_key(a, b, c)
 
 #include "salad/light.h"
 
@@ -67,17 +81,71 @@ memtx_hash_equal_key(struct tuple *tuple, const char *key,
 #undef LIGHT_CMP_ARG_TYPE
 #undef LIGHT_EQUAL
 #undef LIGHT_EQUAL_KEY
+#undef LIGHT_VIEW_EQUAL_KEY
 
 struct memtx_hash_index {
 	struct index base;
 	struct light_index_core hash_table;
 	struct memtx_gc_task gc_task;
 	struct light_index_iterator gc_iterator;
+	/** Number of read views of the index. */
+	uint32_t read_view_count;
+	/**
+	 * Set if the index was destroyed while it had read
+	 * views. Freed when the last view is deleted.
+	 */
+	bool is_dropped;
 };
 
 struct memtx_hash_index *
 memtx_hash_index_new(struct memtx_engine *memtx, struct index_def *def);
 
+/**
+ * Read view of a hash index. It is created and deleted in tx,
+ * but can be searched from any thread in between without locks
+ * while the index is being changed: the hash table memory of
+ * the view is copied on write.
+ *
+ * The tuples a view refers to are kept by the delayed free mode
+ * of the memtx allocator, which the caller must enter with
+ * memtx_enter_delayed_free_mode() before creating views and
+ * leave after deleting them. Each enter starts a new tuple
+ * version, so views created at once should share one enter.
+ * Tuples of temporary spaces are freed at once even in this
+ * mode, so their indexes can't have read views.
+ */
+struct memtx_hash_read_view;
+
+/**
+ * Create a read view of a hash index. Must be called in tx,
+ * in the delayed free mode. Fails for temporary spaces.
+ */
+struct memtx_hash_read_view *
+memtx_hash_read_view_new(struct index *index);
+
+/** Delete a read view of a hash index. Must be called in tx. */
+void
+memtx_hash_read_view_delete(struct memtx_hash_read_view *rv);
+
+/**
+ * Look up a tuple by a full key in a read view. Can be called
+ * from any thread. The key must be validated by the caller.
+ * The returned tuple must not be referenced, but its data can
+ * be read until the view is deleted.
+ * @param rv read view
+ * @param key key parts without MessagePack array header
+ * @return the tuple or NULL if not found
+ */
+struct tuple *
+memtx_hash_read_view_get(struct memtx_hash_read_view *rv, const char *key);
+
+/**
+ * Key definition of the index a read view was created for.
+ * Can be called from any thread, lives as long as the view.
+ */
+struct key_def *
+memtx_hash_read_view_key_def(struct memtx_hash_read_view *rv);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -40,12 +40,14 @@
 #include "memtx_rtree.h"
 #include "memtx_bitset.h"
 #include "memtx_engine.h"
+#include "memtx_tx.h"
 #include "column_mask.h"
 #include "sequence.h"
 
 static void
 memtx_space_destroy(struct space *space)
 {
+	memtx_tx_on_space_delete(space);
 	free(space);
 }
 
@@ -251,6 +253,10 @@ memtx_space_replace_all_keys(struct space *space, struct tuple *old_tuple,
 				       RESERVE_EXTENTS_BEFORE_DELETE) != 0)
 		return -1;
 
+	if (((struct memtx_space *)space)->is_mvcc && in_txn() != NULL)
+		return memtx_tx_history_add_stmt(space, old_tuple, new_tuple,
+						 mode, result);
+
 	uint32_t i = 0;
 
 	/* Update the primary key */
@@ -852,6 +858,55 @@ memtx_init_ephemeral_space(struct space *space)
 	memtx_space_add_primary_key(space);
 }
 
+/**
+ * Build a new secondary index in bulk: collect all tuples and
+ * load them into the index at once. A tree index sorts them in
+ * box.cfg.memtx_sort_threads threads and checks uniqueness, an
+ * rtree index packs them with Sort-Tile-Recursive algorithm.
+ * This is much faster than inserting tuples one by one.
+ */
+static int
+memtx_space_build_index_in_bulk(struct index *pk, struct index *new_index,
+				struct tuple_format *new_format)
+{
+	ssize_t n_tuples = index_size(pk);
+	if (n_tuples < 0)
+		return -1;
+	index_begin_build(new_index);
+	if (n_tuples > 0 && index_reserve(new_index, n_tuples) != 0)
+		return -1;
+
+	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
+	if (it == NULL)
+		return -1;
+	int rc;
+	struct tuple *tuple;
+	while ((rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
+		/*
+		 * Check that the tuple is OK according to the
+		 * new format.
+		 */
+		rc = tuple_validate(new_format, tuple);
+		if (rc != 0)
+			break;
+		rc = index_build_next(new_index, tuple);
+		if (rc != 0)
+			break;
+	}
+	iterator_delete(it);
+	/*
+	 * On error the build array is freed along with the
+	 * index, which is dropped by the caller.
+	 */
+	if (rc != 0)
+		return -1;
+	index_end_build(new_index);
+	if (new_index->def->type != TREE)
+		return 0;
+	return memtx_tree_index_check_unique(
+			(struct memtx_tree_index *)new_index);
+}
+
 static int
 memtx_space_build_index(struct space *src_space, struct index *new_index,
 			struct tuple_format *new_format)
@@ -876,6 +931,11 @@ memtx_space_build_index(struct space *src_space, struct index *new_index,
 		return -1;
 	}
 
+	if (new_index->def->iid != 0 &&
+	    (new_index->def->type == TREE || new_index->def->type == RTREE))
+		return memtx_space_build_index_in_bulk(pk, new_index,
+						       new_format);
+
 	/* Now deal with any kind of add index during normal operation. */
 	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
 	if (it == NULL)
@@ -933,6 +993,9 @@ memtx_space_prepare_alter(struct space *old_space, struct space *new_space)
 		return -1;
 	}
 
+	if (memtx_tx_prepare_alter(old_space) != 0)
+		return -1;
+
 	new_memtx_space->replace = old_memtx_space->replace;
 	new_memtx_space->bsize = old_memtx_space->bsize;
 	return 0;
@@ -1014,5 +1077,17 @@ memtx_space_new(struct memtx_engine *memtx,
 	memtx_space->bsize = 0;
 	memtx_space->rowid = 0;
 	memtx_space->replace = memtx_space_replace_no_keys;
+	/*
+	 * Version chains are only maintained by TREE and HASH
+	 * indexes. System spaces aren't multi-versioned, since
+	 * DDL isn't.
+	 */
+	memtx_space->is_mvcc = memtx_tx_manager_use_mvcc_engine &&
+			       def->id > BOX_SYSTEM_ID_MAX;
+	rlist_foreach_entry(index_def, key_list, link) {
+		if (index_def->type != TREE && index_def->type != HASH)
+			memtx_space->is_mvcc = false;
+	}
+	rlist_create(&memtx_space->tx_stories);
 	return (struct space *)memtx_space;
 }
@@ -55,6 +55,13 @@ struct memtx_space {
 	 */
 	int (*replace)(struct space *, struct tuple *, struct tuple *,
 		       enum dup_replace_mode, struct tuple **);
+	/**
+	 * True if changes of the space are multi-versioned,
+	 * see memtx_tx.h.
+	 */
+	bool is_mvcc;
+	/** Stories of tuples of the space, see memtx_tx.c. */
+	struct rlist tx_stories;
 };
 
 /**
@@ -35,6 +35,7 @@
 
 #include "index.h"
 #include "memtx_engine.h"
+#include "tuple_compare.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -51,12 +52,63 @@ struct memtx_tree_key_data
 	const char *key;
 	/** Number of msgpacked search fields */
 	uint32_t part_count;
+	/** Comparison hint of the key, @sa key_hint(). */
+	hint_t hint;
 };
 
+/**
+ * Struct that is used as an element in BPS tree definition.
+ * The comparison hint is stored next to the tuple pointer so
+ * that most comparisons don't need to access the tuple.
+ */
+struct memtx_tree_data {
+	/** Tuple this element refers to. */
+	struct tuple *tuple;
+	/** Comparison hint of the tuple, @sa tuple_hint(). */
+	hint_t hint;
+};
+
+/**
+ * Fill a BPS tree element for the given tuple.
+ */
+static inline struct memtx_tree_data
+memtx_tree_data_new(struct tuple *tuple, struct key_def *def)
+{
+	struct memtx_tree_data data;
+	data.tuple = tuple;
+	data.hint = tuple_hint(tuple, def);
+	return data;
+}
+
+/**
+ * BPS tree element comparator.
+ * Defined in header in order to allow compiler to inline it.
+ * @param a - first element to compare.
+ * @param b - second element to compare.
+ * @param def - key definition.
+ * @retval 0  if a == b in terms of def.
+ * @retval <0 if a < b in terms of def.
+ * @retval >0 if a > b in terms of def.
+ */
+static inline int
+memtx_tree_compare(const struct memtx_tree_data *a,
+		   const struct memtx_tree_data *b,
+		   struct key_def *def)
+{
+	int rc = hint_cmp(a->hint, b->hint);
+	if (rc != 0)
+		return rc;
+	/* An integer key is stored in the hint in full. */
+	if (def->has_exact_hint && a->hint == b->hint &&
+	    hint_is_exact(a->hint))
+		return 0;
+	return tuple_compare(a->tuple, b->tuple, def);
+}
+
 /**
  * BPS tree element vs key comparator.
  * Defined in header in order to allow compiler to inline it.
- * @param tuple - tuple to compare.
+ * @param data - element to compare.
  * @param key_data - key to compare with.
  * @param def - key definition.
  * @retval 0  if tuple == key in terms of def.
@@ -64,20 +116,32 @@ struct memtx_tree_key_data
  * @retval >0 if tuple > key in terms of def.
  */
 static inline int
-memtx_tree_compare_key(const struct tuple *tuple,
+memtx_tree_compare_key(const struct memtx_tree_data *data,
 		       const struct memtx_tree_key_data *key_data,
 		       struct key_def *def)
 {
-	return tuple_compare_with_key(tuple, key_data->key,
+	int rc = hint_cmp(data->hint, key_data->hint);
+	if (rc != 0)
+		return rc;
+	/*
+	 * A floating point key shares the hint with its floor,
+	 * so the shortcut is only taken for an integer key.
+	 */
+	if (def->has_exact_hint && data->hint == key_data->hint &&
+	    hint_is_exact(data->hint) &&
+	    (mp_typeof(*key_data->key) == MP_UINT ||
+	     mp_typeof(*key_data->key) == MP_INT))
+		return 0;
+	return tuple_compare_with_key(data->tuple, key_data->key,
 				      key_data->part_count, def);
 }
 
 #define BPS_TREE_NAME memtx_tree
 #define BPS_TREE_BLOCK_SIZE (512)
 #define BPS_TREE_EXTENT_SIZE MEMTX_EXTENT_SIZE
-#define BPS_TREE_COMPARE(a, b, arg) tuple_compare(a, b, arg)
-#define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_tree_compare_key(a, b, arg)
-#define bps_tree_elem_t struct tuple *
+#define BPS_TREE_COMPARE(a, b, arg) memtx_tree_compare(&(a), &(b), arg)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_tree_compare_key(&(a), b, arg)
+#define bps_tree_elem_t struct memtx_tree_data
 #define bps_tree_key_t struct memtx_tree_key_data *
 #define bps_tree_arg_t struct key_def *
 
@@ -95,7 +159,7 @@ memtx_tree_compare_key(const struct tuple *tuple,
 struct memtx_tree_index {
 	struct index base;
 	struct memtx_tree tree;
-	struct tuple **build_array;
+	struct memtx_tree_data *build_array;
 	size_t build_array_size, build_array_alloc_size;
 	struct memtx_gc_task gc_task;
 	struct memtx_tree_iterator gc_iterator;
@@ -104,6 +168,16 @@ struct memtx_tree_index {
 struct memtx_tree_index *
 memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def);
 
+/**
+ * Check that a unique tree index built in bulk has no
+ * duplicate keys. The bulk build trusts its input, which
+ * is only true during recovery, so the check is needed
+ * when a new index is created on a non-empty space.
+ * Return -1 and set diag if a duplicate is found.
+ */
+int
+memtx_tree_index_check_unique(struct memtx_tree_index *index);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
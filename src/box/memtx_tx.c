@@ -0,0 +1,848 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "memtx_tx.h"
+
+#include <assert.h>
+#include <string.h>
+#include <small/mempool.h>
+#include <small/rlist.h>
+
+#include "assoc.h"
+#include "diag.h"
+#include "errcode.h"
+#include "fiber.h"
+#include "memtx_engine.h"
+#include "memtx_space.h"
+#include "schema.h"
+#include "space.h"
+#include "trivia/util.h"
+#include "tuple.h"
+#include "txn.h"
+
+bool memtx_tx_manager_use_mvcc_engine = false;
+size_t memtx_tx_story_count = 0;
+
+enum {
+	/**
+	 * Number of garbage collection steps paid for by
+	 * every new story: enough to eventually free both
+	 * the story itself and the one it replaced.
+	 */
+	MEMTX_TX_GC_STEPS_PER_STORY = 2,
+	/**
+	 * Max number of index extents that may be needed to
+	 * remove a tuple from a version chain of every index,
+	 * @sa RESERVE_EXTENTS_BEFORE_REPLACE.
+	 */
+	MEMTX_TX_RESERVE_EXTENTS = 16,
+};
+
+/** A link of a story in the version chain of an index slot. */
+struct memtx_story_link {
+	/** Version that replaced this one in the index or NULL. */
+	struct memtx_story *newer;
+	/** Version replaced by this one in the index or NULL. */
+	struct memtx_story *older;
+};
+
+/**
+ * The history of a tuple: who created and deleted it and where
+ * it is in the version chains of indexes. A tuple without a
+ * story was committed before any of the running transactions
+ * started and hasn't been deleted since.
+ *
+ * A tuple is stored in an index only if it is the newest version
+ * of its slot, i.e. it doesn't have a newer link in the index.
+ */
+struct memtx_story {
+	/** The tuple this story is about. */
+	struct tuple *tuple;
+	/** Space the tuple belongs to. */
+	struct space *space;
+	/**
+	 * Transaction that created the tuple or NULL if it
+	 * has been committed.
+	 */
+	struct txn *add_txn;
+	/**
+	 * Prepare sequence number of the transaction that
+	 * created the tuple or 0 if it hasn't been prepared
+	 * yet or the tuple existed before the story.
+	 */
+	int64_t add_psn;
+	/**
+	 * Transaction that deleted the tuple or NULL if the
+	 * deletion has been committed or there wasn't any.
+	 */
+	struct txn *del_txn;
+	/**
+	 * Prepare sequence number of the transaction that
+	 * deleted the tuple or 0.
+	 */
+	int64_t del_psn;
+	/** Link in memtx_tx_manager::all_stories. */
+	struct rlist in_all_stories;
+	/** Link in memtx_space::tx_stories. */
+	struct rlist in_space_stories;
+	/** Number of elements in the link array. */
+	uint32_t index_count;
+	/** Version chain links, indexed by index id. */
+	struct memtx_story_link link[0];
+};
+
+static struct memtx_tx_manager {
+	/** Map: tuple -> story. */
+	struct mh_i64ptr_t *history;
+	/** Story pools, by the number of links in a story. */
+	struct mempool story_pool[BOX_INDEX_MAX];
+	/** All stories, in the order of garbage collection. */
+	struct rlist all_stories;
+	/** All running transactions, oldest read view first. */
+	struct rlist all_txs;
+	/** The last assigned prepare sequence number. */
+	int64_t psn;
+	/** Number of garbage collection steps to do. */
+	size_t gc_steps;
+} txm;
+
+void
+memtx_tx_manager_init(void)
+{
+	txm.history = mh_i64ptr_new();
+	if (txm.history == NULL)
+		panic("failed to allocate memtx transaction manager");
+	rlist_create(&txm.all_stories);
+	rlist_create(&txm.all_txs);
+	txm.psn = 0;
+	txm.gc_steps = 0;
+}
+
+void
+memtx_tx_manager_free(void)
+{
+	for (int i = 0; i < BOX_INDEX_MAX; i++) {
+		if (mempool_is_initialized(&txm.story_pool[i]))
+			mempool_destroy(&txm.story_pool[i]);
+	}
+	mh_i64ptr_delete(txm.history);
+}
+
+/* {{{ Stories */
+
+static inline struct memtx_story *
+memtx_tx_story_find(struct tuple *tuple)
+{
+	mh_int_t k = mh_i64ptr_find(txm.history, (uintptr_t)tuple, NULL);
+	if (k == mh_end(txm.history))
+		return NULL;
+	return mh_i64ptr_node(txm.history, k)->val;
+}
+
+static struct memtx_story *
+memtx_tx_story_new(struct space *space, struct tuple *tuple)
+{
+	assert(memtx_tx_story_find(tuple) == NULL);
+	uint32_t index_count = space->index_id_max + 1;
+	assert(index_count <= BOX_INDEX_MAX);
+	size_t size = sizeof(struct memtx_story) +
+		      index_count * sizeof(struct memtx_story_link);
+	struct mempool *pool = &txm.story_pool[index_count - 1];
+	if (!mempool_is_initialized(pool))
+		mempool_create(pool, cord_slab_cache(), size);
+	struct memtx_story *story = mempool_alloc(pool);
+	if (story == NULL) {
+		diag_set(OutOfMemory, size, "mempool_alloc",
+			 "struct memtx_story");
+		return NULL;
+	}
+	struct mh_i64ptr_node_t node = { (uintptr_t)tuple, story };
+	if (mh_i64ptr_put(txm.history, &node, NULL,
+			  NULL) == mh_end(txm.history)) {
+		mempool_free(pool, story);
+		diag_set(OutOfMemory, 0, "mh_i64ptr_put", "story");
+		return NULL;
+	}
+	story->tuple = tuple;
+	story->space = space;
+	story->add_txn = NULL;
+	story->add_psn = 0;
+	story->del_txn = NULL;
+	story->del_psn = 0;
+	story->index_count = index_count;
+	memset(story->link, 0, index_count * sizeof(story->link[0]));
+	rlist_add_tail_entry(&txm.all_stories, story, in_all_stories);
+	rlist_add_tail_entry(&((struct memtx_space *)space)->tx_stories,
+			     story, in_space_stories);
+	memtx_tx_story_count++;
+	txm.gc_steps += MEMTX_TX_GC_STEPS_PER_STORY;
+	return story;
+}
+
+/** Find the story of a tuple or create one for a clean tuple. */
+static struct memtx_story *
+memtx_tx_story_get(struct space *space, struct tuple *tuple)
+{
+	struct memtx_story *story = memtx_tx_story_find(tuple);
+	if (story != NULL)
+		return story;
+	return memtx_tx_story_new(space, tuple);
+}
+
+static void
+memtx_tx_story_delete(struct memtx_story *story)
+{
+	struct mh_i64ptr_node_t node = { (uintptr_t)story->tuple, NULL };
+	mh_i64ptr_remove(txm.history, &node, NULL);
+	rlist_del_entry(story, in_all_stories);
+	rlist_del_entry(story, in_space_stories);
+	assert(memtx_tx_story_count > 0);
+	memtx_tx_story_count--;
+	mempool_free(&txm.story_pool[story->index_count - 1], story);
+}
+
+/**
+ * Check if a transaction can see a version. A version is
+ * visible once it has been prepared, it doesn't need to
+ * be written to WAL (read-prepared).
+ */
+static bool
+memtx_tx_story_is_visible(struct memtx_story *story, struct txn *txn)
+{
+	int64_t rv = txn != NULL ? txn->rv_psn : INT64_MAX;
+	if (txn == NULL || story->add_txn != txn) {
+		if (story->add_psn == 0 ? story->add_txn != NULL :
+		    story->add_psn > rv)
+			return false;
+	}
+	if (story->del_txn != NULL && story->del_txn == txn)
+		return false;
+	if (story->del_psn != 0 && story->del_psn <= rv)
+		return false;
+	return true;
+}
+
+/**
+ * Check if a version has been changed by another transaction
+ * after the read view of @a txn was taken or is being changed
+ * by another transaction right now.
+ */
+static bool
+memtx_tx_story_is_changed(struct memtx_story *story, struct txn *txn)
+{
+	if (story->add_txn != txn &&
+	    (story->add_psn == 0 ? story->add_txn != NULL :
+	     story->add_psn > txn->rv_psn))
+		return true;
+	if (story->del_txn != txn &&
+	    (story->del_psn == 0 ? story->del_txn != NULL :
+	     story->del_psn > txn->rv_psn))
+		return true;
+	return false;
+}
+
+/** Walk down a version chain looking for a visible version. */
+static struct tuple *
+memtx_tx_story_clarify(struct memtx_story *story, struct txn *txn,
+		       uint32_t index_id)
+{
+	for (; story != NULL; story = story->link[index_id].older) {
+		assert(index_id < story->index_count);
+		if (memtx_tx_story_is_visible(story, txn))
+			return story->tuple;
+	}
+	return NULL;
+}
+
+struct tuple *
+memtx_tx_tuple_clarify_slow(struct txn *txn, struct tuple *tuple,
+			    uint32_t index_id)
+{
+	struct memtx_story *story = memtx_tx_story_find(tuple);
+	if (story == NULL)
+		return tuple;
+	return memtx_tx_story_clarify(story, txn, index_id);
+}
+
+/**
+ * Remove a tuple from the version chains of all indexes. If the
+ * tuple is stored in an index, it is replaced with the older
+ * version or deleted. Must not fail, the caller is supposed to
+ * reserve index extents.
+ */
+static void
+memtx_tx_story_unlink(struct memtx_story *story)
+{
+	for (uint32_t i = 0; i < story->index_count; i++) {
+		struct memtx_story_link *link = &story->link[i];
+		struct memtx_story *older = link->older;
+		struct memtx_story *newer = link->newer;
+		if (newer != NULL) {
+			newer->link[i].older = older;
+			if (older != NULL)
+				older->link[i].newer = newer;
+		} else {
+			struct index *index = space_index(story->space, i);
+			if (index == NULL)
+				continue;
+			struct tuple *unused;
+			if (index_replace(index, story->tuple,
+					  older != NULL ? older->tuple : NULL,
+					  DUP_INSERT, &unused) != 0) {
+				diag_log();
+				unreachable();
+				panic("failed to rollback change");
+			}
+			if (older != NULL)
+				older->link[i].newer = NULL;
+		}
+		link->older = NULL;
+		link->newer = NULL;
+	}
+}
+
+/* }}} */
+
+/* {{{ Garbage collection */
+
+/** The oldest read view of the running transactions. */
+static int64_t
+memtx_tx_min_rv(void)
+{
+	if (rlist_empty(&txm.all_txs))
+		return txm.psn;
+	return rlist_first_entry(&txm.all_txs, struct txn,
+				 in_all_txs)->rv_psn;
+}
+
+/**
+ * Free a story if it isn't needed by anyone whose read view is
+ * not older than @a min_rv. A tuple deleted before that is also
+ * removed from indexes.
+ *
+ * @retval true The story was freed.
+ */
+static bool
+memtx_tx_story_gc(struct memtx_story *story, int64_t min_rv)
+{
+	if (story->add_txn != NULL || story->del_txn != NULL)
+		return false;
+	if (story->del_psn != 0) {
+		if (story->del_psn > min_rv)
+			return false;
+		struct memtx_engine *memtx =
+			(struct memtx_engine *)story->space->engine;
+		if (memtx_index_extent_reserve(memtx,
+					MEMTX_TX_RESERVE_EXTENTS) != 0)
+			return false;
+		memtx_tx_story_unlink(story);
+		struct tuple *tuple = story->tuple;
+		memtx_tx_story_delete(story);
+		/* Release the reference of the primary index. */
+		tuple_unref(tuple);
+		return true;
+	}
+	if (story->add_psn > min_rv)
+		return false;
+	for (uint32_t i = 0; i < story->index_count; i++) {
+		if (story->link[i].older != NULL ||
+		    story->link[i].newer != NULL)
+			return false;
+	}
+	memtx_tx_story_delete(story);
+	return true;
+}
+
+/** Look at up to @a steps least recently checked stories. */
+static void
+memtx_tx_gc(size_t steps)
+{
+	if (steps == 0)
+		return;
+	int64_t min_rv = memtx_tx_min_rv();
+	/* Don't let a failure to reserve memory clobber diag. */
+	struct diag diag;
+	diag_create(&diag);
+	diag_move(diag_get(), &diag);
+	while (steps-- > 0 && !rlist_empty(&txm.all_stories)) {
+		struct memtx_story *story = rlist_first_entry(
+			&txm.all_stories, struct memtx_story, in_all_stories);
+		if (!memtx_tx_story_gc(story, min_rv)) {
+			rlist_move_tail_entry(&txm.all_stories, story,
+					      in_all_stories);
+		}
+	}
+	diag_move(&diag, diag_get());
+	diag_destroy(&diag);
+}
+
+/* }}} */
+
+/* {{{ Transactions */
+
+void
+memtx_tx_register_txn(struct txn *txn)
+{
+	txn->psn = 0;
+	txn->rv_psn = txm.psn;
+	if (memtx_tx_manager_use_mvcc_engine)
+		rlist_add_tail_entry(&txm.all_txs, txn, in_all_txs);
+	else
+		rlist_create(&txn->in_all_txs);
+}
+
+void
+memtx_tx_unregister_txn(struct txn *txn)
+{
+	rlist_del_entry(txn, in_all_txs);
+	if (!memtx_tx_manager_use_mvcc_engine)
+		return;
+	/*
+	 * Every story pays for a few steps when created, so
+	 * the cost of collection is amortized over changes.
+	 */
+	size_t steps = MIN(txm.gc_steps, memtx_tx_story_count);
+	txm.gc_steps -= steps;
+	memtx_tx_gc(steps);
+}
+
+/** Check if a statement was added to the version history. */
+static inline bool
+memtx_tx_stmt_is_mvcc(struct txn_stmt *stmt)
+{
+	return stmt->space != NULL && stmt->engine_savepoint != NULL &&
+	       ((struct memtx_space *)stmt->space)->is_mvcc;
+}
+
+int
+memtx_tx_prepare(struct txn *txn)
+{
+	if (txn->is_aborted) {
+		diag_set(ClientError, ER_TRANSACTION_CONFLICT);
+		return -1;
+	}
+	txn->psn = ++txm.psn;
+	struct txn_stmt *stmt;
+	stailq_foreach_entry(stmt, &txn->stmts, next) {
+		if (!memtx_tx_stmt_is_mvcc(stmt))
+			continue;
+		struct memtx_story *story;
+		if (stmt->new_tuple != NULL &&
+		    (story = memtx_tx_story_find(stmt->new_tuple)) != NULL)
+			story->add_psn = txn->psn;
+		if (stmt->old_tuple != NULL &&
+		    (story = memtx_tx_story_find(stmt->old_tuple)) != NULL)
+			story->del_psn = txn->psn;
+	}
+	return 0;
+}
+
+void
+memtx_tx_commit(struct txn *txn)
+{
+	struct txn_stmt *stmt;
+	stailq_foreach_entry(stmt, &txn->stmts, next) {
+		if (!memtx_tx_stmt_is_mvcc(stmt))
+			continue;
+		struct memtx_story *story;
+		if (stmt->new_tuple != NULL &&
+		    (story = memtx_tx_story_find(stmt->new_tuple)) != NULL)
+			story->add_txn = NULL;
+		if (stmt->old_tuple != NULL &&
+		    (story = memtx_tx_story_find(stmt->old_tuple)) != NULL)
+			story->del_txn = NULL;
+	}
+}
+
+/* }}} */
+
+/* {{{ History */
+
+static int
+memtx_tx_conflict(struct txn *txn)
+{
+	txn->is_aborted = true;
+	diag_set(ClientError, ER_TRANSACTION_CONFLICT);
+	return -1;
+}
+
+static int
+memtx_tx_history_add_delete(struct space *space, struct txn *txn,
+			    struct tuple *old_tuple, struct tuple **result)
+{
+	struct memtx_story *story = memtx_tx_story_find(old_tuple);
+	/*
+	 * The tuple is visible to the transaction, so if it's
+	 * deleted, it was done by someone else after the read
+	 * view was taken or is being done right now.
+	 */
+	if (story != NULL && (story->del_txn != NULL || story->del_psn != 0))
+		return memtx_tx_conflict(txn);
+	if (story == NULL) {
+		story = memtx_tx_story_new(space, old_tuple);
+		if (story == NULL)
+			return -1;
+	}
+	story->del_txn = txn;
+	/*
+	 * The tuple stays in indexes, so the statement gets
+	 * a reference of its own.
+	 */
+	tuple_ref(old_tuple);
+	memtx_space_update_bsize(space, old_tuple, NULL);
+	*result = old_tuple;
+	return 0;
+}
+
+int
+memtx_tx_history_add_stmt(struct space *space, struct tuple *old_tuple,
+			  struct tuple *new_tuple, enum dup_replace_mode mode,
+			  struct tuple **result)
+{
+	struct txn *txn = in_txn();
+	assert(txn != NULL);
+	if (txn->is_aborted) {
+		diag_set(ClientError, ER_TRANSACTION_CONFLICT);
+		return -1;
+	}
+	if (new_tuple == NULL)
+		return memtx_tx_history_add_delete(space, txn, old_tuple,
+						   result);
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t index_count = space->index_count;
+	struct tuple *visible_old = NULL;
+	struct memtx_story *story, *new_story;
+	uint32_t i;
+	/* Tuples that were on top of version chains. */
+	struct tuple **replaced = region_alloc(region, sizeof(*replaced) *
+					       index_count);
+	if (replaced == NULL) {
+		diag_set(OutOfMemory, sizeof(*replaced) * index_count,
+			 "region_alloc", "replaced");
+		return -1;
+	}
+	/*
+	 * Put the new tuple on top of the chains. Duplicates are
+	 * checked below against the versions the transaction sees
+	 * rather than against what is stored in indexes.
+	 */
+	for (i = 0; i < index_count; i++) {
+		if (index_replace(space->index[i], NULL, new_tuple,
+				  DUP_REPLACE_OR_INSERT, &replaced[i]) != 0)
+			goto rollback;
+	}
+	for (i = 0; i < index_count; i++) {
+		struct index *index = space->index[i];
+		struct tuple *visible = replaced[i];
+		if (visible != NULL) {
+			story = memtx_tx_story_find(visible);
+			if (story != NULL) {
+				if (memtx_tx_story_is_changed(story, txn)) {
+					memtx_tx_conflict(txn);
+					goto rollback_all;
+				}
+				visible = memtx_tx_story_clarify(story, txn,
+							index->def->iid);
+			}
+		}
+		/*
+		 * Same as in memtx_space_replace_all_keys(): the
+		 * mode only matters for the primary key.
+		 */
+		uint32_t errcode;
+		if (i == 0) {
+			errcode = replace_check_dup(old_tuple, visible, mode);
+			visible_old = visible;
+		} else {
+			errcode = replace_check_dup(visible_old, visible,
+						    DUP_INSERT);
+		}
+		if (errcode != 0) {
+			diag_set(ClientError, errcode, index->def->name,
+				 space_name(space));
+			goto rollback_all;
+		}
+	}
+	if (visible_old != NULL) {
+		story = memtx_tx_story_find(visible_old);
+		if (story != NULL &&
+		    (story->del_txn != NULL || story->del_psn != 0)) {
+			memtx_tx_conflict(txn);
+			goto rollback_all;
+		}
+	}
+	/* Allocate all stories before changing any of them. */
+	new_story = memtx_tx_story_new(space, new_tuple);
+	if (new_story == NULL)
+		goto rollback_all;
+	for (i = 0; i < index_count; i++) {
+		if (replaced[i] != NULL &&
+		    memtx_tx_story_get(space, replaced[i]) == NULL) {
+			memtx_tx_story_delete(new_story);
+			goto rollback_all;
+		}
+	}
+	new_story->add_txn = txn;
+	for (i = 0; i < index_count; i++) {
+		if (replaced[i] == NULL)
+			continue;
+		uint32_t iid = space->index[i]->def->iid;
+		story = memtx_tx_story_find(replaced[i]);
+		new_story->link[iid].older = story;
+		story->link[iid].newer = new_story;
+	}
+	if (visible_old != NULL) {
+		story = memtx_tx_story_find(visible_old);
+		story->del_txn = txn;
+		/* See memtx_tx_history_add_delete(). */
+		tuple_ref(visible_old);
+	}
+	memtx_space_update_bsize(space, visible_old, new_tuple);
+	/* The new tuple is referenced by the primary key. */
+	tuple_ref(new_tuple);
+	region_truncate(region, region_svp);
+	*result = visible_old;
+	return 0;
+
+rollback_all:
+	i = index_count;
+rollback:
+	for (; i > 0; i--) {
+		struct tuple *unused;
+		/* Rollback must not fail. */
+		if (index_replace(space->index[i - 1], new_tuple,
+				  replaced[i - 1], DUP_INSERT, &unused) != 0) {
+			diag_log();
+			unreachable();
+			panic("failed to rollback change");
+		}
+	}
+	region_truncate(region, region_svp);
+	return -1;
+}
+
+void
+memtx_tx_history_rollback_stmt(struct txn_stmt *stmt)
+{
+	struct txn *txn = in_txn();
+	struct memtx_story *story;
+	if (stmt->new_tuple != NULL) {
+		story = memtx_tx_story_find(stmt->new_tuple);
+		/*
+		 * The story may be gone only if the space was
+		 * dropped by a DDL that failed to write to WAL.
+		 * Leak the tuple rather than risk touching it.
+		 */
+		if (story == NULL)
+			return;
+		/*
+		 * Transactions that built on top of the version
+		 * can't be committed anymore.
+		 */
+		if (story->del_txn != NULL && story->del_txn != txn)
+			story->del_txn->is_aborted = true;
+		for (uint32_t i = 0; i < story->index_count; i++) {
+			struct memtx_story *newer = story->link[i].newer;
+			if (newer != NULL && newer->add_txn != NULL &&
+			    newer->add_txn != txn)
+				newer->add_txn->is_aborted = true;
+		}
+		memtx_tx_story_unlink(story);
+		memtx_tx_story_delete(story);
+	}
+	if (stmt->old_tuple != NULL) {
+		story = memtx_tx_story_find(stmt->old_tuple);
+		if (story != NULL) {
+			story->del_txn = NULL;
+			story->del_psn = 0;
+		}
+	}
+	memtx_space_update_bsize(stmt->space, stmt->new_tuple,
+				 stmt->old_tuple);
+	if (stmt->new_tuple != NULL)
+		tuple_unref(stmt->new_tuple);
+}
+
+/* }}} */
+
+/* {{{ DDL */
+
+int
+memtx_tx_prepare_alter(struct space *space)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	struct memtx_story *story, *tmp;
+	rlist_foreach_entry(story, &memtx_space->tx_stories,
+			    in_space_stories) {
+		if (story->add_txn != NULL || story->del_txn != NULL) {
+			diag_set(ClientError, ER_ALTER_SPACE,
+				 space_name(space),
+				 "the space has uncommitted changes");
+			return -1;
+		}
+	}
+	/*
+	 * DDL isn't multi-versioned, so drop all old versions
+	 * as if nobody could see them. Deleted tuples go first
+	 * so that the remaining stories lose their links.
+	 */
+	rlist_foreach_entry_safe(story, &memtx_space->tx_stories,
+				 in_space_stories, tmp) {
+		/* Fails only if there's no memory for indexes. */
+		if (story->del_psn != 0 &&
+		    !memtx_tx_story_gc(story, INT64_MAX))
+			return -1;
+	}
+	rlist_foreach_entry_safe(story, &memtx_space->tx_stories,
+				 in_space_stories, tmp) {
+		memtx_tx_story_gc(story, INT64_MAX);
+	}
+	assert(rlist_empty(&memtx_space->tx_stories));
+	return 0;
+}
+
+void
+memtx_tx_on_space_delete(struct space *space)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	while (!rlist_empty(&memtx_space->tx_stories)) {
+		struct memtx_story *story = rlist_first_entry(
+			&memtx_space->tx_stories, struct memtx_story,
+			in_space_stories);
+		if (story->add_txn != NULL)
+			story->add_txn->is_aborted = true;
+		if (story->del_txn != NULL)
+			story->del_txn->is_aborted = true;
+		memtx_tx_story_delete(story);
+	}
+}
+
+/* }}} */
+
+/* {{{ Index helpers */
+
+/**
+ * Return the multi-versioned space an index belongs to or NULL
+ * if the index isn't in the space cache, e.g. it's ephemeral.
+ */
+static struct memtx_space *
+memtx_tx_index_space(struct index *index)
+{
+	struct space *space = space_by_id(index->def->space_id);
+	if (space == NULL || space_index(space, index->def->iid) != index)
+		return NULL;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	return memtx_space->is_mvcc ? memtx_space : NULL;
+}
+
+size_t
+memtx_tx_index_invisible_count(struct txn *txn, struct index *index)
+{
+	if (memtx_tx_story_count == 0)
+		return 0;
+	struct memtx_space *memtx_space = memtx_tx_index_space(index);
+	if (memtx_space == NULL)
+		return 0;
+	uint32_t iid = index->def->iid;
+	size_t count = 0;
+	struct memtx_story *story;
+	rlist_foreach_entry(story, &memtx_space->tx_stories,
+			    in_space_stories) {
+		/* Only the top of a chain is stored in the index. */
+		if (story->link[iid].newer != NULL)
+			continue;
+		if (memtx_tx_story_clarify(story, txn, iid) == NULL)
+			count++;
+	}
+	return count;
+}
+
+int
+memtx_tx_snapshot_cleaner_create(struct memtx_tx_snapshot_cleaner *cleaner,
+				 struct index *index)
+{
+	cleaner->ht = NULL;
+	if (memtx_tx_story_count == 0)
+		return 0;
+	struct memtx_space *memtx_space = memtx_tx_index_space(index);
+	if (memtx_space == NULL || rlist_empty(&memtx_space->tx_stories))
+		return 0;
+	struct mh_i64ptr_t *ht = mh_i64ptr_new();
+	if (ht == NULL) {
+		diag_set(OutOfMemory, sizeof(*ht), "mh_i64ptr_new",
+			 "snapshot cleaner");
+		return -1;
+	}
+	uint32_t iid = index->def->iid;
+	struct memtx_story *story;
+	rlist_foreach_entry(story, &memtx_space->tx_stories,
+			    in_space_stories) {
+		if (story->link[iid].newer != NULL)
+			continue;
+		/*
+		 * A snapshot contains everything that has been
+		 * prepared, i.e. sent to WAL, by now.
+		 */
+		struct tuple *clean = memtx_tx_story_clarify(story, NULL, iid);
+		if (clean == story->tuple)
+			continue;
+		struct mh_i64ptr_node_t node = { (uintptr_t)story->tuple,
+						 clean };
+		if (mh_i64ptr_put(ht, &node, NULL, NULL) == mh_end(ht)) {
+			mh_i64ptr_delete(ht);
+			diag_set(OutOfMemory, 0, "mh_i64ptr_put",
+				 "snapshot cleaner");
+			return -1;
+		}
+	}
+	cleaner->ht = ht;
+	return 0;
+}
+
+struct tuple *
+memtx_tx_snapshot_clarify_slow(struct memtx_tx_snapshot_cleaner *cleaner,
+			       struct tuple *tuple)
+{
+	mh_int_t k = mh_i64ptr_find(cleaner->ht, (uintptr_t)tuple, NULL);
+	if (k == mh_end(cleaner->ht))
+		return tuple;
+	return mh_i64ptr_node(cleaner->ht, k)->val;
+}
+
+void
+memtx_tx_snapshot_cleaner_destroy(struct memtx_tx_snapshot_cleaner *cleaner)
+{
+	if (cleaner->ht != NULL)
+		mh_i64ptr_delete(cleaner->ht);
+}
+
+/* }}} */
@@ -0,0 +1,217 @@
+#ifndef TARANTOOL_BOX_MEMTX_TX_H_INCLUDED
+#define TARANTOOL_BOX_MEMTX_TX_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "index.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Multi-version concurrency control for memtx.
+ *
+ * When enabled, a change made by a transaction doesn't replace
+ * the old version of a tuple in indexes right away. Instead, the
+ * new tuple is put on top of a version chain kept per index
+ * slot: the tuple physically stored in the index is the newest
+ * version, older versions are reachable from it. Each version
+ * is described by a story which remembers the transactions that
+ * created and deleted it and their prepare sequence numbers
+ * (psn).
+ *
+ * A transaction sees the versions prepared before it started
+ * (its read view) and its own changes, so it may yield between
+ * statements without being aborted. Readers outside transactions
+ * see the latest prepared state. A write to a slot that has been
+ * changed by another transaction after the read view was taken
+ * or is being changed by another transaction right now aborts
+ * the writer with ER_TRANSACTION_CONFLICT (first writer wins),
+ * which gives snapshot isolation.
+ *
+ * Note, versions become visible when they are prepared, i.e.
+ * submitted to WAL, not when they are written, so the snapshot
+ * is taken of the prepared state (read-prepared). A reader may
+ * see a change that will be rolled back on WAL failure, just
+ * like without MVCC. Hiding versions until commit would make a
+ * write to a slot conflict with the previous change of the slot
+ * for as long as the latter is waiting for WAL.
+ *
+ * Versions that can't be seen by anyone are collected
+ * incrementally when transactions end. Tuples that don't have
+ * a story are visible to everyone, so the cost of MVCC is only
+ * paid for recently changed data.
+ *
+ * Only user spaces whose indexes are all TREE or HASH are
+ * multi-versioned, transactions touching other spaces are still
+ * aborted on yield.
+ */
+
+struct space;
+struct tuple;
+struct txn;
+struct txn_stmt;
+struct memtx_story;
+struct mh_i64ptr_t;
+
+/** Set from box.cfg.memtx_use_mvcc_engine before recovery. */
+extern bool memtx_tx_manager_use_mvcc_engine;
+
+/** Number of stories in existence, used for a fast path. */
+extern size_t memtx_tx_story_count;
+
+/** Initialize the transaction manager. */
+void
+memtx_tx_manager_init(void);
+
+/** Free the transaction manager. */
+void
+memtx_tx_manager_free(void);
+
+/**
+ * Register a new transaction: take its read view.
+ * Called by txn_begin().
+ */
+void
+memtx_tx_register_txn(struct txn *txn);
+
+/**
+ * Unregister a committed or rolled back transaction and collect
+ * garbage versions that nobody can see anymore.
+ */
+void
+memtx_tx_unregister_txn(struct txn *txn);
+
+/**
+ * Add a change to the version history of a multi-versioned
+ * space. Follows the contract of memtx_space_replace_all_keys():
+ * @a old_tuple and @a mode are checked against the versions
+ * visible to the current transaction, *@a result is set to the
+ * visible version replaced or deleted by the change.
+ */
+int
+memtx_tx_history_add_stmt(struct space *space, struct tuple *old_tuple,
+			  struct tuple *new_tuple, enum dup_replace_mode mode,
+			  struct tuple **result);
+
+/** Undo a statement added with memtx_tx_history_add_stmt(). */
+void
+memtx_tx_history_rollback_stmt(struct txn_stmt *stmt);
+
+/** Assign a psn to the versions created by the transaction. */
+int
+memtx_tx_prepare(struct txn *txn);
+
+/** Mark the versions created by the transaction committed. */
+void
+memtx_tx_commit(struct txn *txn);
+
+/**
+ * Collapse the version history of a space before it is altered,
+ * since DDL isn't multi-versioned. Fails if the space has changes
+ * of transactions that haven't been committed yet.
+ */
+int
+memtx_tx_prepare_alter(struct space *space);
+
+/** Forget the stories of a space being deleted. */
+void
+memtx_tx_on_space_delete(struct space *space);
+
+/**
+ * Number of tuples stored in an index of a multi-versioned space
+ * that are invisible to the given transaction.
+ */
+size_t
+memtx_tx_index_invisible_count(struct txn *txn, struct index *index);
+
+struct tuple *
+memtx_tx_tuple_clarify_slow(struct txn *txn, struct tuple *tuple,
+			    uint32_t index_id);
+
+/**
+ * Return the version of a tuple stored in an index that the
+ * transaction can see, or NULL if there is no such version.
+ * @a txn is NULL for reads outside transactions.
+ */
+static inline struct tuple *
+memtx_tx_tuple_clarify(struct txn *txn, struct tuple *tuple,
+		       uint32_t index_id)
+{
+	if (memtx_tx_story_count == 0)
+		return tuple;
+	return memtx_tx_tuple_clarify_slow(txn, tuple, index_id);
+}
+
+/**
+ * Snapshot iterators run in a separate thread, so they can't
+ * look at the version history. Instead, the versions they must
+ * write are resolved when the read view is created.
+ */
+struct memtx_tx_snapshot_cleaner {
+	/** Map: tuple stored in the index -> version to write. */
+	struct mh_i64ptr_t *ht;
+};
+
+/** Create a snapshot cleaner for an index. */
+int
+memtx_tx_snapshot_cleaner_create(struct memtx_tx_snapshot_cleaner *cleaner,
+				 struct index *index);
+
+struct tuple *
+memtx_tx_snapshot_clarify_slow(struct memtx_tx_snapshot_cleaner *cleaner,
+			       struct tuple *tuple);
+
+/**
+ * Return the version of a tuple found by a snapshot iterator
+ * that must be written to the snapshot or NULL to skip it.
+ */
+static inline struct tuple *
+memtx_tx_snapshot_clarify(struct memtx_tx_snapshot_cleaner *cleaner,
+			  struct tuple *tuple)
+{
+	if (cleaner->ht == NULL)
+		return tuple;
+	return memtx_tx_snapshot_clarify_slow(cleaner, tuple);
+}
+
+void
+memtx_tx_snapshot_cleaner_destroy(struct memtx_tx_snapshot_cleaner *cleaner);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_MEMTX_TX_H_INCLUDED */
@@ -360,6 +360,16 @@ recovery_finalize(struct recovery *r)
 	recovery_close_log(r);
 }
 
+void
+recovery_reset_log(struct recovery *r)
+{
+	if (xlog_cursor_is_open(&r->cursor))
+		xlog_cursor_close(&r->cursor, false);
+	/* Make recovery_open_log() treat the next WAL as the first. */
+	memset(&r->cursor, 0, sizeof(r->cursor));
+	assert(r->cursor.state == XLOG_CURSOR_NEW);
+}
+
 
 /* }}} */
 
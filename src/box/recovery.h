@@ -89,6 +89,16 @@ recovery_stop_local(struct recovery *r);
 void
 recovery_finalize(struct recovery *r);
 
+/**
+ * Close the current WAL without running on_close_log triggers
+ * and forget the position in it, so that the next call to
+ * recover_remaining_wals() looks up the WAL to read by the
+ * recovery vclock as if it was the first call. Used by relays
+ * which fetch rows from the WAL cache while they can.
+ */
+void
+recovery_reset_log(struct recovery *r);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
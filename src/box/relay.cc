@@ -53,6 +53,7 @@
 #include "xrow_io.h"
 #include "xstream.h"
 #include "wal.h"
+#include "wal_mem.h"
 
 /**
  * Cbus message to send status updates from relay to tx thread.
@@ -101,6 +102,13 @@ struct relay {
 	struct replica *replica;
 	/** WAL event watcher. */
 	struct wal_watcher wal_watcher;
+	/**
+	 * Set if rows are fetched from the WAL cache rather
+	 * than read from xlog files, see relay_send_from_wal_mem().
+	 */
+	bool is_reading_wal_mem;
+	/** Position in the WAL cache if is_reading_wal_mem is set. */
+	struct wal_mem_cursor wal_mem_cursor;
 	/** Relay reader cond. */
 	struct fiber_cond reader_cond;
 	/** Relay diagnostics. */
@@ -359,13 +367,17 @@ tx_gc_advance(struct cmsg *msg)
 	free(m);
 }
 
+/**
+ * Schedule garbage collection of xlog files containing rows
+ * sent to the replica so far. The files are collected as soon
+ * as the replica confirms it has received the rows.
+ */
 static void
-relay_on_close_log_f(struct trigger *trigger, void * /* event */)
+relay_add_pending_gc(struct relay *relay)
 {
 	static const struct cmsg_hop route[] = {
 		{tx_gc_advance, NULL}
 	};
-	struct relay *relay = (struct relay *)trigger->data;
 	struct relay_gc_msg *m = (struct relay_gc_msg *)malloc(sizeof(*m));
 	if (m == NULL) {
 		say_warn("failed to allocate relay gc message");
@@ -382,6 +394,12 @@ relay_on_close_log_f(struct trigger *trigger, void * /* event */)
 	stailq_add_tail_entry(&relay->pending_gc, m, in_pending);
 }
 
+static void
+relay_on_close_log_f(struct trigger *trigger, void * /* event */)
+{
+	relay_add_pending_gc((struct relay *)trigger->data);
+}
+
 /**
  * Invoke pending garbage collection requests.
  *
@@ -405,6 +423,56 @@ relay_schedule_pending_gc(struct relay *relay, const struct vclock *vclock)
 		cpipe_push(&relay->tx_pipe, &gc_msg->msg);
 }
 
+/**
+ * Send new rows to the replica from the WAL cache, which is
+ * shared by all relays and filled by the WAL thread, so as
+ * not to read and decode the same xlog files in each relay.
+ *
+ * Returns false if the cache doesn't have all rows the replica
+ * needs, in which case they must be read from xlog files.
+ */
+static bool
+relay_send_from_wal_mem(struct relay *relay, unsigned events)
+{
+	struct wal_mem *mem = wal_get_mem();
+	struct recovery *r = relay->r;
+	if (mem == NULL)
+		return false;
+	if (!relay->is_reading_wal_mem) {
+		if (wal_mem_cursor_create(mem, &relay->wal_mem_cursor,
+					  &r->vclock) != 0)
+			return false;
+		relay->is_reading_wal_mem = true;
+		/*
+		 * Stop reading xlog files. Since the current file
+		 * won't be closed by recovery now, advance garbage
+		 * collection explicitly.
+		 */
+		recovery_reset_log(r);
+		relay_add_pending_gc(relay);
+	}
+	int rc;
+	struct xrow_header row;
+	while ((rc = wal_mem_cursor_next(mem, &relay->wal_mem_cursor,
+					 &row)) == 0) {
+		/* Skip rows the replica already has, like recovery does. */
+		if (row.lsn <= vclock_get(&r->vclock, row.replica_id))
+			continue;
+		vclock_follow_xrow(&r->vclock, &row);
+		relay_send_row(&relay->stream, &row);
+	}
+	if (rc < 0) {
+		/* The replica lags behind the cache. */
+		wal_mem_cursor_destroy(mem, &relay->wal_mem_cursor);
+		relay->is_reading_wal_mem = false;
+		return false;
+	}
+	/* All rows of the previous xlog file have been sent. */
+	if ((events & WAL_EVENT_ROTATE) != 0)
+		relay_add_pending_gc(relay);
+	return true;
+}
+
 static void
 relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 {
@@ -417,8 +485,16 @@ relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 		return;
 	}
 	try {
+		bool was_reading_wal_mem = relay->is_reading_wal_mem;
+		if (relay_send_from_wal_mem(relay, events))
+			return;
+		/*
+		 * The WAL directory index is stale if we have
+		 * just fallen back on reading files.
+		 */
 		recover_remaining_wals(relay->r, &relay->stream, NULL,
-				       (events & WAL_EVENT_ROTATE) != 0);
+				       (events & WAL_EVENT_ROTATE) != 0 ||
+				       was_reading_wal_mem);
 	} catch (Exception *e) {
 		e->log();
 		diag_move(diag_get(), &relay->diag);
@@ -503,6 +579,10 @@ relay_subscribe_f(va_list ap)
 		RLIST_LINK_INITIALIZER, relay_on_close_log_f, relay, NULL
 	};
 	trigger_add(&r->on_close_log, &on_close_log);
+	relay->is_reading_wal_mem = false;
+	struct wal_mem *mem = wal_get_mem();
+	if (mem != NULL)
+		wal_mem_attach(mem);
 	wal_set_watcher(&relay->wal_watcher, cord_name(cord()),
 			relay_process_wal_event, cbus_process);
 
@@ -569,6 +649,12 @@ relay_subscribe_f(va_list ap)
 	say_crit("exiting the relay loop");
 	trigger_clear(&on_close_log);
 	wal_clear_watcher(&relay->wal_watcher, cbus_process);
+	if (relay->is_reading_wal_mem) {
+		wal_mem_cursor_destroy(mem, &relay->wal_mem_cursor);
+		relay->is_reading_wal_mem = false;
+	}
+	if (mem != NULL)
+		wal_mem_detach(mem);
 	if (!fiber_is_dead(reader))
 		fiber_cancel(reader);
 	fiber_join(reader);
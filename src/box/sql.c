@@ -31,6 +31,7 @@
 #include <assert.h>
 #include "field_def.h"
 #include "sql.h"
+#include "sql_stmt_cache.h"
 #include "sql/sqliteInt.h"
 #include "sql/tarantoolInt.h"
 #include "sql/vdbeInt.h"
@@ -57,9 +58,12 @@ static sqlite3 *db = NULL;
 
 static const char nil_key[] = { 0x90 }; /* Empty MsgPack array. */
 
+/*
+ * Automatic indexes are off by default so as not to change
+ * plans of existing queries, see PRAGMA automatic_index.
+ */
 static const uint32_t default_sql_flags = SQLITE_ShortColNames
 					  | SQLITE_EnableTrigger
-					  | SQLITE_AutoIndex
 					  | SQLITE_RecTriggers;
 
 void
@@ -73,6 +77,7 @@ sql_init()
 		panic("failed to initialize SQL subsystem");
 
 	assert(db != NULL);
+	sql_stmt_cache_init();
 }
 
 void
@@ -102,9 +107,18 @@ sql_load_schema()
 void
 sql_free()
 {
+	sql_stmt_cache_destroy();
 	sqlite3_close(db); db = NULL;
 }
 
+void
+sql_set_sort_threads(int count)
+{
+	assert(count >= 0 && count <= SQL_SORT_THREADS_MAX);
+	assert(SQL_SORT_THREADS_MAX == SQLITE_MAX_WORKER_THREADS);
+	sqlite3_limit(db, SQLITE_LIMIT_WORKER_THREADS, count);
+}
+
 sqlite3 *
 sql_get()
 {
@@ -1054,6 +1068,7 @@ static int
 cursor_seek(BtCursor *pCur, int *pRes)
 {
 	/* Close existing iterator, if any */
+	sql_cursor_release_batch(pCur);
 	if (pCur->iter) {
 		box_iterator_free(pCur->iter);
 		pCur->iter = NULL;
@@ -1086,6 +1101,56 @@ cursor_seek(BtCursor *pCur, int *pRes)
 	return cursor_advance(pCur, pRes);
 }
 
+/**
+ * Fetch the next tuple of a cursor opened with BTCF_TBatch.
+ *
+ * Tuples are fetched from the iterator in batches of up to
+ * SQL_CURSOR_BATCH_MAX, which amortizes the cost of iterator
+ * calls over the batch. Data of fetched tuples is prefetched
+ * so that it is likely to be in cache by the time OP_Column
+ * decodes it.
+ *
+ * @param pCur Cursor.
+ * @param[out] ret Referenced tuple or NULL if the iterator
+ *             is exhausted.
+ *
+ * @retval 0 Success.
+ * @retval -1 Iterator or memory error.
+ */
+static int
+cursor_batch_next(BtCursor *pCur, struct tuple **ret)
+{
+	if (pCur->batch_pos < pCur->batch_size) {
+		*ret = pCur->batch[pCur->batch_pos++];
+		return 0;
+	}
+	if (pCur->batch == NULL) {
+		size_t size = SQL_CURSOR_BATCH_MAX * sizeof(struct tuple *);
+		pCur->batch = malloc(size);
+		if (pCur->batch == NULL) {
+			diag_set(OutOfMemory, size, "malloc", "cur->batch");
+			return -1;
+		}
+	}
+	pCur->batch_pos = pCur->batch_size = 0;
+	struct tuple *tuple;
+	while (pCur->batch_size < SQL_CURSOR_BATCH_MAX) {
+		if (iterator_next(pCur->iter, &tuple) != 0) {
+			sql_cursor_release_batch(pCur);
+			return -1;
+		}
+		if (tuple == NULL)
+			break;
+		box_tuple_ref(tuple);
+		__builtin_prefetch(tuple_data(tuple));
+		pCur->batch[pCur->batch_size++] = tuple;
+	}
+	*ret = NULL;
+	if (pCur->batch_size > 0)
+		*ret = pCur->batch[pCur->batch_pos++];
+	return 0;
+}
+
 /*
  * Move cursor to the next entry in space.
  * New tuple is refed and saved in cursor.
@@ -1102,12 +1167,18 @@ cursor_advance(BtCursor *pCur, int *pRes)
 	assert(pCur->iter != NULL);
 
 	struct tuple *tuple;
-	if (iterator_next(pCur->iter, &tuple) != 0)
-		return SQL_TARANTOOL_ITERATOR_FAIL;
+	if ((pCur->curFlags & BTCF_TBatch) != 0) {
+		if (cursor_batch_next(pCur, &tuple) != 0)
+			return SQL_TARANTOOL_ITERATOR_FAIL;
+	} else {
+		if (iterator_next(pCur->iter, &tuple) != 0)
+			return SQL_TARANTOOL_ITERATOR_FAIL;
+		if (tuple != NULL)
+			box_tuple_ref(tuple);
+	}
 	if (pCur->last_tuple)
 		box_tuple_unref(pCur->last_tuple);
 	if (tuple) {
-		box_tuple_ref(tuple);
 		*pRes = 0;
 	} else {
 		pCur->eState = CURSOR_INVALID;
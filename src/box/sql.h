@@ -47,6 +47,19 @@ sql_load_schema();
 void
 sql_free();
 
+enum {
+	/** Max number of SQL sorter worker threads. */
+	SQL_SORT_THREADS_MAX = 8,
+};
+
+/**
+ * Set the number of worker threads an SQL sorter may use to
+ * sort and merge intermediate results that don't fit in memory.
+ * Zero means that all sorting is done in the tx thread.
+ */
+void
+sql_set_sort_threads(int count);
+
 /**
  * struct sqlite3 *
  * sql_get();
@@ -109,6 +109,7 @@
 #include "box/index.h"
 #include "box/key_def.h"
 #include "box/tuple_compare.h"
+#include "box/tuple_sketch.h"
 #include "box/schema.h"
 #include "third_party/qsort_arg.h"
 
@@ -1601,6 +1602,48 @@ sql_space_tuple_log_count(struct Table *tab)
 	return sqlite3LogEst(pk->vtab->size(pk));
 }
 
+/**
+ * Estimate the average number of tuples matching a partial key
+ * using distinct key estimates maintained by the engine on write.
+ *
+ * @param index Index.
+ * @param field Number of key parts, 0 means the whole index.
+ * @param[out] est Estimated number of tuples (LogEst).
+ * @retval true The estimate is available.
+ * @retval false The index has no estimates or they are empty.
+ */
+static bool
+index_sketch_tuple_est(struct index *index, uint32_t field, log_est_t *est)
+{
+	const struct tuple_sketch *sketch = index->sketch;
+	if (sketch == NULL || field > sketch->part_count)
+		return false;
+	ssize_t size = index_size(index);
+	if (size <= 0)
+		return false;
+	if (field == 0) {
+		*est = sqlite3LogEst(size);
+		return true;
+	}
+	if (field == index->def->key_def->part_count &&
+	    index->def->opts.is_unique) {
+		*est = 0;
+		return true;
+	}
+	/*
+	 * Distinct estimates of longer prefixes may be lower
+	 * due to estimation error while actually they can't be.
+	 */
+	uint64_t distinct = 0;
+	for (uint32_t i = 1; i <= field; i++)
+		distinct = MAX(distinct, tuple_sketch_distinct(sketch, i));
+	if (distinct == 0)
+		return false;
+	distinct = MIN(distinct, (uint64_t)size);
+	*est = sqlite3LogEst(size) - sqlite3LogEst(distinct);
+	return true;
+}
+
 log_est_t
 index_field_tuple_est(const struct index_def *idx_def, uint32_t field)
 {
@@ -1613,6 +1656,10 @@ index_field_tuple_est(const struct index_def *idx_def, uint32_t field)
 	/* Statistics is held only in real indexes. */
 	struct index *tnt_idx = space_index(space, idx_def->iid);
 	assert(tnt_idx != NULL);
+	/* Prefer live estimates to those collected by ANALYZE. */
+	log_est_t est;
+	if (index_sketch_tuple_est(tnt_idx, field, &est))
+		return est;
 	if (tnt_idx->def->opts.stat == NULL) {
 		/*
 		 * Last number for unique index is always 0:
@@ -144,6 +144,7 @@ sqlite3InsertBuiltinFuncs(FuncDef * aDef,	/* List of global functions to be inse
 	for (i = 0; i < nDef; i++) {
 		FuncDef *pOther;
 		const char *zName = aDef[i].zName;
+		aDef[i].funcFlags |= SQLITE_FUNC_BUILTIN;
 		int nName = sqlite3Strlen30(zName);
 		int h =
 		    (sqlite3UpperToLower[(u8) zName[0]] +
@@ -33,9 +33,20 @@
 #include "tarantoolInt.h"
 #include "box/tuple.h"
 
+void
+sql_cursor_release_batch(struct BtCursor *cursor)
+{
+	for (u32 i = cursor->batch_pos; i < cursor->batch_size; i++)
+		tuple_unref(cursor->batch[i]);
+	cursor->batch_pos = cursor->batch_size = 0;
+}
+
 void
 sql_cursor_cleanup(struct BtCursor *cursor)
 {
+	sql_cursor_release_batch(cursor);
+	free(cursor->batch);
+	cursor->batch = NULL;
 	if (cursor->iter)
 		iterator_delete(cursor->iter);
 	if (cursor->last_tuple)
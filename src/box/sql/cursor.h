@@ -50,6 +50,20 @@ struct BtCursor {
 	enum iterator_type iter_type;
 	struct tuple *last_tuple;
 	char *key;		/* Saved key that was cursor last known position */
+	/**
+	 * Referenced tuples fetched from the iterator ahead of
+	 * the cursor position, see BTCF_TBatch.
+	 */
+	struct tuple **batch;
+	/** Number of tuples in the batch. */
+	u32 batch_size;
+	/** Position of the next tuple in the batch. */
+	u32 batch_pos;
+};
+
+enum {
+	/** Max number of tuples fetched by a batch cursor at once. */
+	SQL_CURSOR_BATCH_MAX = 32,
 };
 
 void sqlite3CursorZero(BtCursor *);
@@ -75,6 +89,13 @@ int sqlite3CursorPayload(BtCursor *, u32 offset, u32 amt, void *);
 void
 sql_cursor_cleanup(struct BtCursor *cursor);
 
+/**
+ * Unreference tuples fetched by a batch cursor ahead of its
+ * position, e.g. because the cursor is repositioned.
+ */
+void
+sql_cursor_release_batch(struct BtCursor *cursor);
+
 #ifndef NDEBUG
 int sqlite3CursorIsValid(BtCursor *);
 #endif
@@ -85,6 +106,7 @@ int sqlite3CursorIsValidNN(BtCursor *);
  */
 #define BTCF_TaCursor     0x80	/* Tarantool cursor, pTaCursor valid */
 #define BTCF_TEphemCursor 0x40	/* Tarantool cursor to ephemeral table  */
+#define BTCF_TBatch       0x20	/* Fetch tuples from iterator in batches */
 
 /*
  * Potential values for BtCursor.eState.
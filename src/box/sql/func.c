@@ -1651,6 +1651,11 @@ sqlite3RegisterLikeFunctions(sqlite3 *db, int is_case_insensitive)
 			  is_like_ci, likeFunc, 0, 0, 0);
 	sqlite3CreateFunc(db, "LIKE", AFFINITY_INTEGER, 3, 0,
 			  is_like_ci, likeFunc, 0, 0, 0);
+	for (int n_arg = 2; n_arg <= 3; n_arg++) {
+		FuncDef *def = sqlite3FindFunction(db, "LIKE", n_arg, 0);
+		if (ALWAYS(def != NULL))
+			def->funcFlags |= SQLITE_FUNC_BUILTIN;
+	}
 	setLikeOptFlag(db, "LIKE",
 		       !(is_case_insensitive) ? (SQLITE_FUNC_LIKE |
 		       SQLITE_FUNC_CASE) : SQLITE_FUNC_LIKE);
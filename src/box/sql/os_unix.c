@@ -38,6 +38,7 @@
 #include <sys/time.h>
 #include <errno.h>
 #include <sys/mman.h>
+#include <pthread.h>
 
 
 /*
@@ -320,6 +321,13 @@ struct unixInodeInfo {
  */
 static unixInodeInfo *inodeList = 0;
 
+/*
+ * Protects inodeList and the objects linked in it: sorter
+ * worker threads open and close temporary files concurrently
+ * with the main thread.
+ */
+static pthread_mutex_t inodeMutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  *
  * This function - unixLogErrorAtLine(), is only ever called via the macro
@@ -781,8 +789,10 @@ unixClose(sqlite3_file * id)
 		 */
 		setPendingFd(pFile);
 	}
+	pthread_mutex_lock(&inodeMutex);
 	releaseInodeInfo(pFile);
 	rc = closeUnixFile(id);
+	pthread_mutex_unlock(&inodeMutex);
 	return rc;
 }
 
@@ -1498,7 +1508,9 @@ fillInUnixFile(sqlite3_vfs * pVfs,	/* Pointer to vfs object */
 	}
 
 	if (pLockingStyle == &posixIoMethods) {
+		pthread_mutex_lock(&inodeMutex);
 		rc = findInodeInfo(pNew, &pNew->pInode);
+		pthread_mutex_unlock(&inodeMutex);
 		if (rc != SQLITE_OK) {
 			/* If an error occurred in findInodeInfo(), close the file descriptor
 			 * immediately. findInodeInfo() may fail
@@ -1636,6 +1648,7 @@ findReusableFd(const char *zPath, int flags)
 	if (0 == stat(zPath, &sStat)) {
 		unixInodeInfo *pInode;
 
+		pthread_mutex_lock(&inodeMutex);
 		pInode = inodeList;
 		while (pInode && (pInode->fileId.dev != sStat.st_dev
 				  || pInode->fileId.ino !=
@@ -1652,6 +1665,7 @@ findReusableFd(const char *zPath, int flags)
 				*pp = pUnused->pNext;
 			}
 		}
+		pthread_mutex_unlock(&inodeMutex);
 	}
 	return pUnused;
 }
@@ -37,6 +37,7 @@
  * to generate random integer keys for tables or random filenames.
  */
 #include "sqliteInt.h"
+#include <pthread.h>
 
 /* All threads share a single random number generator.
  * This structure is the current state of the generator.
@@ -47,6 +48,12 @@ static SQLITE_WSD struct sqlite3PrngType {
 	unsigned char s[256];	/* State variables */
 } sqlite3Prng;
 
+/*
+ * Protects the generator state: temporary file names are
+ * generated by sorter worker threads, too.
+ */
+static pthread_mutex_t sqlite3PrngMutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * Return N random bytes.
  */
@@ -75,8 +82,10 @@ sqlite3_randomness(int N, void *pBuf)
 		return;
 #endif
 
+	pthread_mutex_lock(&sqlite3PrngMutex);
 	if (N <= 0 || pBuf == 0) {
 		wsdPrng.isInit = 0;
+		pthread_mutex_unlock(&sqlite3PrngMutex);
 		return;
 	}
 
@@ -117,6 +126,7 @@ sqlite3_randomness(int N, void *pBuf)
 		t += wsdPrng.s[wsdPrng.i];
 		*(zBuf++) = wsdPrng.s[t];
 	} while (--N);
+	pthread_mutex_unlock(&sqlite3PrngMutex);
 }
 
 #ifndef SQLITE_UNTESTABLE
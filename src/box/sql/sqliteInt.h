@@ -1709,6 +1709,7 @@ struct FuncDestructor {
 #define SQLITE_FUNC_SLOCHNG  0x2000	/* "Slow Change". Value constant during a
 					 * single query - might change over time
 					 */
+#define SQLITE_FUNC_BUILTIN  0x4000	/* Built-in, doesn't modify spaces */
 
 /*
  * The following three macros, FUNCTION(), LIKEFUNC() and AGGREGATE() are
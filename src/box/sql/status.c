@@ -95,9 +95,14 @@ sqlite3StatusUp(int op, int N)
 	wsdStatInit;
 	assert(op >= 0 && op < ArraySize(wsdStat.nowValue));
 
-	wsdStat.nowValue[op] += N;
-	if (wsdStat.nowValue[op] > wsdStat.mxValue[op]) {
-		wsdStat.mxValue[op] = wsdStat.nowValue[op];
+	/*
+	 * Memory is allocated by sorter worker threads, too.
+	 * The high-water mark is approximate.
+	 */
+	sqlite3StatValueType value =
+		__atomic_add_fetch(&wsdStat.nowValue[op], N, __ATOMIC_RELAXED);
+	if (value > wsdStat.mxValue[op]) {
+		wsdStat.mxValue[op] = value;
 	}
 }
 
@@ -108,7 +113,7 @@ sqlite3StatusDown(int op, int N)
 	assert(N >= 0);
 
 	assert(op >= 0 && op < ArraySize(wsdStat.nowValue));
-	wsdStat.nowValue[op] -= N;
+	__atomic_sub_fetch(&wsdStat.nowValue[op], N, __ATOMIC_RELAXED);
 }
 
 /*
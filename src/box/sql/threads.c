@@ -0,0 +1,108 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * This file implements the threading interface used by the
+ * sorter (vdbesort.c) to sort and merge large intermediate
+ * results in background threads.
+ *
+ * A background thread never touches fibers, the diagnostics
+ * area or Tarantool spaces: it only sorts records kept in
+ * its own memory and reads and writes its own temporary files.
+ */
+#include "sqliteInt.h"
+#include <pthread.h>
+#include <signal.h>
+
+#if SQLITE_MAX_WORKER_THREADS>0
+
+struct SQLiteThread {
+	/** Thread id. */
+	pthread_t tid;
+	/** Set if the task was run synchronously. */
+	bool done;
+	/** Result of the task if it was run synchronously. */
+	void *pOut;
+};
+
+/*
+ * Create a new thread running xTask(pIn). If the thread can't
+ * be started, run the task synchronously in the calling thread,
+ * so a caller never has to care whether it got a thread or not.
+ */
+int
+sqlite3ThreadCreate(SQLiteThread **ppThread, void *(*xTask) (void *),
+		    void *pIn)
+{
+	assert(ppThread != NULL);
+	assert(xTask != NULL);
+	*ppThread = NULL;
+	SQLiteThread *p = sqlite3MallocZero(sizeof(*p));
+	if (p == NULL)
+		return SQLITE_NOMEM_BKPT;
+	/*
+	 * Signals are handled by the main thread, so block them
+	 * in the new thread.
+	 */
+	sigset_t set, oldset;
+	sigfillset(&set);
+	pthread_sigmask(SIG_BLOCK, &set, &oldset);
+	int rc = sqlite3FaultSim(200);
+	if (rc == SQLITE_OK)
+		rc = pthread_create(&p->tid, NULL, xTask, pIn);
+	pthread_sigmask(SIG_SETMASK, &oldset, NULL);
+	if (rc != 0) {
+		p->done = true;
+		p->pOut = xTask(pIn);
+	}
+	*ppThread = p;
+	return SQLITE_OK;
+}
+
+/*
+ * Wait for a thread to finish, store the task result in
+ * *ppOut and free the thread object.
+ */
+int
+sqlite3ThreadJoin(SQLiteThread *p, void **ppOut)
+{
+	int rc = 0;
+	if (p == NULL)
+		return SQLITE_NOMEM_BKPT;
+	if (p->done)
+		*ppOut = p->pOut;
+	else
+		rc = pthread_join(p->tid, ppOut);
+	sqlite3_free(p);
+	return rc != 0 ? SQLITE_ERROR : SQLITE_OK;
+}
+
+#endif /* SQLITE_MAX_WORKER_THREADS>0 */
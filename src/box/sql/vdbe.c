@@ -3234,6 +3234,15 @@ case OP_IteratorOpen:
 	struct BtCursor *bt_cur = cur->uc.pCursor;
 	bt_cur->curFlags |= space->def->id == 0 ? BTCF_TEphemCursor :
 				BTCF_TaCursor;
+	/*
+	 * Scans of memtx spaces by read-only statements fetch
+	 * tuples in batches. Point lookups need one tuple only,
+	 * while a statement modifying a space must see its own
+	 * changes.
+	 */
+	if (p->is_read_only && space->def->id != 0 &&
+	    space_is_memtx(space) && (pOp->p5 & OPFLAG_SEEKEQ) == 0)
+		bt_cur->curFlags |= BTCF_TBatch;
 	bt_cur->space = space;
 	bt_cur->index = index;
 	bt_cur->eState = CURSOR_INVALID;
@@ -640,6 +640,10 @@ sqlite3VdbeAssertMayAbort(Vdbe * v, int mayAbort)
  *
  * (4) Reclaim the memory allocated for storing labels.
  *
+ * (5) Set p->is_read_only if no opcode modifies a space other
+ *     than an ephemeral one and no function that may modify
+ *     spaces, i.e. one defined by the user, is called.
+ *
  * This routine will only function correctly if the mkopcodeh.sh generator
  * script numbers the opcodes correctly.  Changes to this routine must be
  * coordinated with changes to mkopcodeh.sh.
@@ -652,7 +656,32 @@ resolveP2Values(Vdbe * p, int *pMaxFuncArgs)
 	Parse *pParse = p->pParse;
 	int *aLabel = pParse->aLabel;
 	pOp = &p->aOp[p->nOp - 1];
+	p->is_read_only = 1;
 	while (1) {
+		switch (pOp->opcode) {
+		case OP_IdxInsert:
+		case OP_IdxReplace:
+			/* Ephemeral spaces are passed in registers. */
+			if (pOp->p4type == P4_SPACEPTR)
+				p->is_read_only = 0;
+			break;
+		case OP_SInsert:
+		case OP_SDelete:
+		case OP_Delete:
+		case OP_IdxDelete:
+		case OP_Clear:
+		case OP_RenameTable:
+		case OP_Program:
+			p->is_read_only = 0;
+			break;
+		case OP_Function0:
+		case OP_AggStep0:
+			assert(pOp->p4type == P4_FUNCDEF);
+			if ((pOp->p4.pFunc->funcFlags &
+			     SQLITE_FUNC_BUILTIN) == 0)
+				p->is_read_only = 0;
+			break;
+		}
 
 		/* Only JUMP opcodes and the short list of special opcodes in the switch
 		 * below need to be considered.  The mkopcodeh.sh generator script groups
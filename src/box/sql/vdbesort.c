@@ -1269,8 +1269,12 @@ static int
 vdbeSortAllocUnpacked(SortSubtask * pTask)
 {
 	if (pTask->pUnpacked == 0) {
+		/*
+		 * Don't use the connection allocator: this may
+		 * run in a worker thread.
+		 */
 		pTask->pUnpacked =
-			sqlite3VdbeAllocUnpackedRecord(pTask->pSorter->db,
+			sqlite3VdbeAllocUnpackedRecord(NULL,
 						       pTask->pSorter->key_def);
 		if (pTask->pUnpacked == 0)
 			return SQLITE_NOMEM_BKPT;
@@ -701,7 +701,7 @@ termCanDriveIndex(WhereTerm * pTerm,	/* WHERE clause term to check */
 		return 0;
 	if (pTerm->u.leftColumn < 0)
 		return 0;
-	aff = pSrc->pTab->aCol[pTerm->u.leftColumn].affinity;
+	aff = pSrc->pTab->def->fields[pTerm->u.leftColumn].affinity;
 	if (!sqlite3IndexAffinityOk(pTerm->pExpr, aff))
 		return 0;
 	return 1;
@@ -709,193 +709,150 @@ termCanDriveIndex(WhereTerm * pTerm,	/* WHERE clause term to check */
 #endif
 
 #ifndef SQLITE_OMIT_AUTOMATIC_INDEX
-/*
- * Generate code to construct the Index object for an automatic index
- * and to set up the WhereLevel object pLevel so that the code generator
- * makes use of the automatic index.
+/**
+ * Generate code to build an automatic index for a loop over a
+ * table that has no index usable for a join and set up the
+ * WhereLevel object so that the code generator makes use of it.
+ *
+ * The index is an ephemeral space filled once, on the first
+ * iteration of the outer loops, with all rows of the table.
+ * Then each iteration of the outer loops looks up matching rows
+ * in it instead of scanning the whole table, which makes a join
+ * cost N * log(M) rather than N * M. Tuples of the ephemeral
+ * space are laid out as follows: values of the columns used
+ * in the join constraints, all columns of the table, unique
+ * rowid. Since the index covers all columns, the original
+ * table is never read in the loop body. sqlite3WhereEnd()
+ * shifts references to the table columns accordingly.
+ *
+ * @param parse Parsing context.
+ * @param wc The WHERE clause.
+ * @param src The FROM clause term to build the index for.
+ * @param not_ready Mask of cursors that are not available.
+ * @param level Level to set up.
  */
 static void
-constructAutomaticIndex(Parse * pParse,			/* The parsing context */
-			WhereClause * pWC,		/* The WHERE clause */
-			struct SrcList_item *pSrc,	/* The FROM clause term to get the next index */
-			Bitmask notReady,		/* Mask of cursors that are not available */
-			WhereLevel * pLevel)		/* Write new index here */
+constructAutomaticIndex(struct Parse *parse, struct WhereClause *wc,
+			struct SrcList_item *src, Bitmask not_ready,
+			struct WhereLevel *level)
 {
-	int nKeyCol;		/* Number of columns in the constructed index */
-	WhereTerm *pTerm;	/* A single term of the WHERE clause */
-	WhereTerm *pWCEnd;	/* End of pWC->a[] */
-	Index *pIdx;		/* Object describing the transient index */
-	Vdbe *v;		/* Prepared statement under construction */
-	int addrInit;		/* Address of the initialization bypass jump */
-	Table *pTable;		/* The table being indexed */
-	int addrTop;		/* Top of the index fill loop */
-	int regRecord;		/* Register holding an index record */
-	int n;			/* Column counter */
-	int i;			/* Loop counter */
-	int mxBitCol;		/* Maximum column in pSrc->colUsed */
-	struct coll *pColl;		/* Collating sequence to on a column */
-	WhereLoop *pLoop;	/* The Loop object */
-	char *zNotUsed;		/* Extra space on the end of pIdx */
-	Bitmask idxCols;	/* Bitmap of columns used for indexing */
-	Bitmask extraCols;	/* Bitmap of additional columns */
-	u8 sentWarning = 0;	/* True if a warnning has been issued */
-	int iContinue = 0;	/* Jump here to skip excluded rows */
-	struct SrcList_item *pTabItem;	/* FROM clause term being indexed */
-	int addrCounter = 0;	/* Address where integer counter is initialized */
-	int regBase;		/* Array of registers where record is assembled */
-
-	/* Generate code to skip over the creation and initialization of the
-	 * transient index on 2nd and subsequent iterations of the loop.
+	struct Vdbe *v = parse->pVdbe;
+	assert(v != NULL);
+	struct space_def *space_def = src->pTab->def;
+	struct WhereLoop *loop = level->pWLoop;
+	struct WhereTerm *wc_end = &wc->a[wc->nTerm];
+	/*
+	 * Skip creation and initialization of the index on 2nd
+	 * and subsequent iterations of the outer loops.
 	 */
-	v = pParse->pVdbe;
-	assert(v != 0);
-	addrInit = sqlite3VdbeAddOp0(v, OP_Once);
+	int addr_init = sqlite3VdbeAddOp0(v, OP_Once);
 	VdbeCoverage(v);
 
-	/* Count the number of columns that will be added to the index
-	 * and used to match WHERE clause constraints
-	 */
-	nKeyCol = 0;
-	pTable = pSrc->pTab;
-	pWCEnd = &pWC->a[pWC->nTerm];
-	pLoop = pLevel->pWLoop;
-	idxCols = 0;
-	for (pTerm = pWC->a; pTerm < pWCEnd; pTerm++) {
-		if (termCanDriveIndex(pTerm, pSrc, notReady)) {
-			int iCol = pTerm->u.leftColumn;
-			Bitmask cMask =
-			    iCol >= BMS ? MASKBIT(BMS - 1) : MASKBIT(iCol);
-			testcase(iCol == BMS);
-			testcase(iCol == BMS - 1);
-			if (!sentWarning) {
-				sqlite3_log(SQLITE_WARNING_AUTOINDEX,
-					    "automatic index on %s(%s)",
-					    pTable->def->name,
-					    pTable->aCol[iCol].zName);
-				sentWarning = 1;
-			}
-			if ((idxCols & cMask) == 0) {
-				if (whereLoopResize
-				    (pParse->db, pLoop, nKeyCol + 1)) {
-					goto end_auto_index_create;
-				}
-				pLoop->aLTerm[nKeyCol++] = pTerm;
-				idxCols |= cMask;
-			}
-		}
-	}
-	assert(nKeyCol > 0);
-	pLoop->nEq = pLoop->nLTerm = nKeyCol;
-	pLoop->wsFlags = WHERE_COLUMN_EQ | WHERE_IDX_ONLY | WHERE_INDEXED
-	    | WHERE_AUTO_INDEX;
-
-	/* Count the number of additional columns needed to create a
-	 * covering index.  A "covering index" is an index that contains all
-	 * columns that are needed by the query.  With a covering index, the
-	 * original table never needs to be accessed.  Automatic indices must
-	 * be a covering index because the index will not be updated if the
-	 * original table changes and the index and table cannot both be used
-	 * if they go out of sync.
-	 */
-	extraCols = pSrc->colUsed & (~idxCols | MASKBIT(BMS - 1));
-	mxBitCol = MIN(BMS - 1, pTable->def->field_count);
-	testcase(pTable->def->field_count == BMS - 1);
-	testcase(pTable->def->field_count == BMS - 2);
-	for (i = 0; i < mxBitCol; i++) {
-		if (extraCols & MASKBIT(i))
-			nKeyCol++;
-	}
-	if (pSrc->colUsed & MASKBIT(BMS - 1)) {
-		nKeyCol += pTable->def->field_count - BMS + 1;
-	}
-
-	/* Construct the Index object to describe this index */
-	pIdx = sqlite3DbMallocZero(pParse->db, sizeof(*pIdx));
-	if (pIdx == 0)
-		goto end_auto_index_create;
-	pLoop->pIndex = pIdx;
-	pIdx->zName = "auto-index";
-	pIdx->pTable = pTable;
-	n = 0;
-	idxCols = 0;
-	for (pTerm = pWC->a; pTerm < pWCEnd; pTerm++) {
-		if (termCanDriveIndex(pTerm, pSrc, notReady)) {
-			int iCol = pTerm->u.leftColumn;
-			Bitmask cMask =
-			    iCol >= BMS ? MASKBIT(BMS - 1) : MASKBIT(iCol);
-			testcase(iCol == BMS - 1);
-			testcase(iCol == BMS);
-			if ((idxCols & cMask) == 0) {
-				Expr *pX = pTerm->pExpr;
-				idxCols |= cMask;
-				pIdx->aiColumn[n] = pTerm->u.leftColumn;
-				n++;
-			}
-		}
+	/* Collect the terms that will be used for lookups. */
+	uint32_t key_count = 0;
+	Bitmask idx_cols = 0;
+	for (struct WhereTerm *term = wc->a; term < wc_end; term++) {
+		if (!termCanDriveIndex(term, src, not_ready))
+			continue;
+		int col = term->u.leftColumn;
+		Bitmask mask = col >= BMS ? MASKBIT(BMS - 1) : MASKBIT(col);
+		if ((idx_cols & mask) != 0)
+			continue;
+		if (whereLoopResize(parse->db, loop, key_count + 1) != 0)
+			return;
+		loop->aLTerm[key_count++] = term;
+		idx_cols |= mask;
 	}
-	assert((u32) n == pLoop->nEq);
+	assert(key_count > 0);
+	loop->nEq = loop->nLTerm = key_count;
+	loop->wsFlags = WHERE_COLUMN_EQ | WHERE_IDX_ONLY | WHERE_INDEXED |
+			WHERE_AUTO_INDEX;
 
-	/* Add additional columns needed to make the automatic index into
-	 * a covering index
+	/*
+	 * Key parts of the ephemeral space are compared using
+	 * the collations of the join constraints. The index
+	 * definition passed to the code generator refers to the
+	 * columns of the original table.
 	 */
-	for (i = 0; i < mxBitCol; i++) {
-		if (extraCols & MASKBIT(i)) {
-			pIdx->aiColumn[n] = i;
-			n++;
-		}
+	struct sql_key_info *key_info = sql_key_info_new(parse->db, key_count);
+	if (key_info == NULL)
+		return;
+	for (uint32_t i = 0; i < key_count; i++) {
+		struct WhereTerm *term = loop->aLTerm[i];
+		struct key_part_def *part = &key_info->parts[i];
+		sql_binary_compare_coll_seq(parse, term->pExpr->pLeft,
+					    term->pExpr->pRight,
+					    &part->coll_id);
+		part->fieldno = term->u.leftColumn;
+		part->type = space_def->fields[part->fieldno].type;
+		part->is_nullable = true;
+		part->nullable_action = ON_CONFLICT_ACTION_NONE;
 	}
-	if (pSrc->colUsed & MASKBIT(BMS - 1)) {
-		for (i = BMS - 1; i < (int)pTable->def->field_count; i++) {
-			pIdx->aiColumn[n] = i;
-			n++;
-		}
+	struct key_def *key_def = key_def_new(key_info->parts, key_count);
+	if (key_def == NULL)
+		goto tnt_error;
+	struct index_opts opts;
+	index_opts_create(&opts);
+	opts.is_unique = false;
+	loop->index_def = index_def_new(space_def->id, 0, "auto-index",
+					sizeof("auto-index") - 1, TREE, &opts,
+					key_def, NULL);
+	key_def_delete(key_def);
+	if (loop->index_def == NULL)
+		goto tnt_error;
+	/* Special marker for an index that doesn't exist in the space. */
+	loop->index_def->iid = UINT32_MAX - 1;
+	for (uint32_t i = 0; i < key_count; i++) {
+		key_info->parts[i].fieldno = i;
+		key_info->parts[i].type = FIELD_TYPE_SCALAR;
 	}
-	assert(n == nKeyCol);
-	pIdx->aiColumn[n] = XN_ROWID;
-
-	/* Create the automatic index */
-	assert(pLevel->iIdxCur >= 0);
-	pLevel->iIdxCur = pParse->nTab++;
-	sqlite3VdbeAddOp2(v, OP_OpenAutoindex, pLevel->iIdxCur, nKeyCol + 1);
-	sql_vdbe_set_p4_key_def(pParse, pIdx->key_def);
-	VdbeComment((v, "for %s", pTable->def->name));
-
-	/* Fill the automatic index with content */
-	sqlite3ExprCachePush(pParse);
-	pTabItem = &pWC->pWInfo->pTabList->a[pLevel->iFrom];
-	if (pTabItem->fg.viaCoroutine) {
-		int regYield = pTabItem->regReturn;
-		addrCounter = sqlite3VdbeAddOp2(v, OP_Integer, 0, 0);
-		sqlite3VdbeAddOp3(v, OP_InitCoroutine, regYield, 0,
-				  pTabItem->addrFillSub);
-		addrTop = sqlite3VdbeAddOp1(v, OP_Yield, regYield);
-		VdbeCoverage(v);
-		VdbeComment((v, "next row of \"%s\"", pTabItem->pTab->zName));
-	} else {
-		addrTop = sqlite3VdbeAddOp1(v, OP_Rewind, pLevel->iTabCur);
-		VdbeCoverage(v);
+
+	/* Create the automatic index. */
+	uint32_t field_count = space_def->field_count;
+	int reg_eph = ++parse->nMem;
+	level->iIdxCur = parse->nTab++;
+	sqlite3VdbeAddOp4(v, OP_OpenTEphemeral, reg_eph,
+			  key_count + field_count + 1, 0, (char *)key_info,
+			  P4_KEYINFO);
+	sqlite3VdbeAddOp3(v, OP_IteratorOpen, level->iIdxCur, 0, reg_eph);
+	VdbeComment((v, "auto-index for %s", space_def->name));
+
+	/* Fill the automatic index with content. */
+	sqlite3ExprCachePush(parse);
+	int addr_top = sqlite3VdbeAddOp1(v, OP_Rewind, level->iTabCur);
+	VdbeCoverage(v);
+	int reg_base = sqlite3GetTempRange(parse, key_count + field_count + 1);
+	for (uint32_t i = 0; i < key_count; i++) {
+		sqlite3ExprCodeGetColumnOfTable(v, space_def, level->iTabCur,
+						loop->aLTerm[i]->u.leftColumn,
+						reg_base + i);
 	}
-	regRecord = sqlite3GetTempReg(pParse);
-	regBase = sql_generate_index_key(pParse, pIdx, pLevel->iTabCur,
-					 regRecord, NULL, 0);
-	sqlite3VdbeAddOp2(v, OP_IdxInsert, pLevel->iIdxCur, regRecord);
-	if (pTabItem->fg.viaCoroutine) {
-		sqlite3VdbeChangeP2(v, addrCounter, regBase + n);
-		translateColumnToCopy(v, addrTop, pLevel->iTabCur,
-				      pTabItem->regResult, 1);
-		sqlite3VdbeGoto(v, addrTop);
-		pTabItem->fg.viaCoroutine = 0;
-	} else {
-		sqlite3VdbeAddOp2(v, OP_Next, pLevel->iTabCur, addrTop + 1);
-		VdbeCoverage(v);
+	for (uint32_t i = 0; i < field_count; i++) {
+		sqlite3ExprCodeGetColumnOfTable(v, space_def, level->iTabCur, i,
+						reg_base + key_count + i);
 	}
-	sqlite3VdbeChangeP5(v, SQLITE_STMTSTATUS_AUTOINDEX);
-	sqlite3VdbeJumpHere(v, addrTop);
-	sqlite3ReleaseTempReg(pParse, regRecord);
-	sqlite3ExprCachePop(pParse);
+	int reg_rowid = reg_base + key_count + field_count;
+	sqlite3VdbeAddOp2(v, OP_NextIdEphemeral, reg_eph, reg_rowid);
+	int reg_record = sqlite3GetTempReg(parse);
+	sqlite3VdbeAddOp3(v, OP_MakeRecord, reg_base,
+			  key_count + field_count + 1, reg_record);
+	/* Set flag to save memory allocating one by malloc. */
+	sqlite3VdbeChangeP5(v, 1);
+	sqlite3VdbeAddOp2(v, OP_IdxInsert, reg_record, reg_eph);
+	sqlite3VdbeAddOp2(v, OP_Next, level->iTabCur, addr_top + 1);
+	VdbeCoverage(v);
+	sqlite3VdbeJumpHere(v, addr_top);
+	sqlite3ReleaseTempReg(parse, reg_record);
+	sqlite3ReleaseTempRange(parse, reg_base, key_count + field_count + 1);
+	sqlite3ExprCachePop(parse);
 
-	/* Jump here when skipping the initialization */
-	sqlite3VdbeJumpHere(v, addrInit);
+	/* Jump here when skipping the initialization. */
+	sqlite3VdbeJumpHere(v, addr_init);
+	return;
+tnt_error:
+	sql_key_info_unref(key_info);
+	parse->nErr++;
+	parse->rc = SQL_TARANTOOL_ERROR;
 }
 #endif				/* SQLITE_OMIT_AUTOMATIC_INDEX */
 
@@ -2843,15 +2800,29 @@ tnt_error:
 	}
 
 #ifndef SQLITE_OMIT_AUTOMATIC_INDEX
-	/* Automatic indexes */
-	LogEst rSize = pTab->nRowLogEst;
+	/*
+	 * Automatic indexes. The table size is estimated the
+	 * same way as for the loops over real indexes below,
+	 * so that the index isn't considered cheap just because
+	 * the table is empty at the moment.
+	 */
+	rSize = index_field_tuple_est(probe, 0);
 	LogEst rLogSize = estLog(rSize);
 	struct session *user_session = current_session();
+	/*
+	 * Automatic indexes are built only for real tables:
+	 * the fill loop reads the table with an iterator over
+	 * its primary key.
+	 */
 	if (!pBuilder->pOrSet	/* Not part of an OR optimization */
-	    && (pWInfo->wctrlFlags & WHERE_OR_SUBCLAUSE) == 0 && (user_session->sql_flags & SQLITE_AutoIndex) != 0 && pSrc->pIBIndex == 0	/* Has no INDEXED BY clause */
+	    && (pWInfo->wctrlFlags & WHERE_OR_SUBCLAUSE) == 0
+	    && (pWInfo->wctrlFlags & WHERE_ONEPASS_DESIRED) == 0
+	    && (user_session->sql_flags & SQLITE_AutoIndex) != 0
+	    && pSrc->pIBIndex == 0	/* Has no INDEXED BY clause */
 	    && !pSrc->fg.notIndexed	/* Has no NOT INDEXED clause */
-	    && HasRowid(pTab)	/* Not WITHOUT ROWID table. (FIXME: Why not?) */
-	    &&!pSrc->fg.isCorrelated	/* Not a correlated subquery */
+	    && pTab->def->id != 0 && !pTab->def->opts.is_view
+	    && pTab->def->field_count != 0
+	    && !pSrc->fg.isCorrelated	/* Not a correlated subquery */
 	    && !pSrc->fg.isRecursive	/* Not a recursive common table expression. */
 	    ) {
 		/* Generate auto-index WhereLoops */
@@ -2863,22 +2834,17 @@ tnt_error:
 			if (termCanDriveIndex(pTerm, pSrc, 0)) {
 				pNew->nEq = 1;
 				pNew->nSkip = 0;
-				pNew->pIndex = 0;
+				pNew->index_def = NULL;
 				pNew->nLTerm = 1;
 				pNew->aLTerm[0] = pTerm;
 				/* TUNING: One-time cost for computing the automatic index is
 				 * estimated to be X*N*log2(N) where N is the number of rows in
-				 * the table being indexed and where X is 7 (LogEst=28) for normal
-				 * tables or 1.375 (LogEst=4) for views and subqueries.  The value
-				 * of X is smaller for views and subqueries so that the query planner
-				 * will be more aggressive about generating automatic indexes for
-				 * those objects, since there is no opportunity to add schema
-				 * indexes on subqueries and views.
+				 * the table being indexed and where X is 7 (LogEst=28): the
+				 * whole table is copied to an ephemeral space. So the index
+				 * is chosen only when the outer loops are expected to do
+				 * many lookups, i.e. instead of a nested scan of a big table.
 				 */
-				pNew->rSetup = rLogSize + rSize + 4;
-				if (!pTab->def->opts.is_view &&
-				    pTab->def->id == 0)
-					pNew->rSetup += 24;
+				pNew->rSetup = rLogSize + rSize + 4 + 24;
 				if (pNew->rSetup < 0)
 					pNew->rSetup = 0;
 				/* TUNING: Each index lookup yields 20 rows in the table.  This
@@ -2886,8 +2852,8 @@ tnt_error:
 				 * of knowing how selective the index will ultimately be.  It would
 				 * not be unreasonable to make this value much larger.
 				 */
-				pNew->nOut = 43;
 				assert(43 == sqlite3LogEst(20));
+				pNew->nOut = MIN(43, rSize);
 				pNew->rRun =
 				    sqlite3LogEstAdd(rLogSize, pNew->nOut);
 				pNew->wsFlags = WHERE_AUTO_INDEX;
@@ -4704,7 +4670,7 @@ sqlite3WhereBegin(Parse * pParse,	/* The parser context */
 			constructAutomaticIndex(pParse, &pWInfo->sWC,
 						&pTabList->a[pLevel->iFrom],
 						notReady, pLevel);
-			if (db->mallocFailed)
+			if (db->mallocFailed || pParse->nErr != 0)
 				goto whereBeginError;
 		}
 #endif
@@ -4883,6 +4849,14 @@ sqlite3WhereEnd(WhereInfo * pWInfo)
 					assert(def == NULL ||
 					       def->space_id == pTab->def->id);
 					if (x >= 0) {
+						/*
+						 * Table columns follow the
+						 * key columns in automatic
+						 * indexes.
+						 */
+						if ((pLoop->wsFlags &
+						     WHERE_AUTO_INDEX) != 0)
+							x += pLoop->nEq;
 						pOp->p2 = x;
 						pOp->p1 = pLevel->iIdxCur;
 					}
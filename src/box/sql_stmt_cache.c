@@ -0,0 +1,397 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "sql_stmt_cache.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <small/rlist.h>
+
+#include "assoc.h"
+#include "diag.h"
+#include "errcode.h"
+#include "info.h"
+#include "say.h"
+#include "schema.h"
+#include "session.h"
+#include "sql.h"
+#include "sql/sqliteInt.h"
+#include "sql/vdbeInt.h"
+
+/** A compiled statement stored in the cache. */
+struct sql_stmt_cache_entry {
+	/**
+	 * Link in sql_stmt_cache::lru. Empty if the entry has
+	 * been evicted from the cache.
+	 */
+	struct rlist in_lru;
+	/** Compiled statement. */
+	struct sqlite3_stmt *stmt;
+	/** Id of the statement returned to clients. */
+	uint32_t id;
+	/**
+	 * Session SQL flags the statement was compiled with.
+	 * They affect the compiled program, e.g. the names of
+	 * result columns or counting of changed rows.
+	 */
+	uint32_t sql_flags;
+	/** Set while the statement is being executed. */
+	bool is_busy;
+	/** Memory accounted to the entry. */
+	size_t size;
+	/** Length of the SQL text. */
+	uint32_t sql_len;
+	/** SQL text of the statement, the cache key. */
+	char sql[0];
+};
+
+static struct sql_stmt_cache {
+	/** SQL text -> struct sql_stmt_cache_entry. */
+	struct mh_strnptr_t *by_sql;
+	/** Id -> struct sql_stmt_cache_entry. */
+	struct mh_i32ptr_t *by_id;
+	/** Cached entries, least recently used first. */
+	struct rlist lru;
+	/** Number of cached entries. */
+	uint32_t count;
+	/** Memory used by cached entries. */
+	size_t mem_used;
+	/** Max memory that may be used by cached entries. */
+	size_t mem_quota;
+	/** Id that will be assigned to the next entry. */
+	uint32_t next_id;
+	/** Number of lookups that found the statement. */
+	int64_t hit;
+	/** Number of lookups that had to compile the statement. */
+	int64_t miss;
+} cache;
+
+/** Estimate memory occupied by a compiled statement. */
+static size_t
+sql_stmt_size(struct sqlite3_stmt *stmt)
+{
+	struct Vdbe *v = (struct Vdbe *)stmt;
+	return sizeof(*v) + v->nOp * sizeof(Op) +
+	       (v->nMem + v->nVar) * sizeof(Mem);
+}
+
+/** Compile an SQL statement. */
+static int
+sql_stmt_compile(const char *sql, uint32_t len, struct sqlite3_stmt **stmt)
+{
+	sqlite3 *db = sql_get();
+	if (sqlite3_prepare_v2(db, sql, len, stmt, NULL) != SQLITE_OK) {
+		diag_set(ClientError, ER_SQL_EXECUTE, sqlite3_errmsg(db));
+		return -1;
+	}
+	assert(*stmt != NULL);
+	return 0;
+}
+
+static void
+sql_stmt_cache_entry_delete(struct sql_stmt_cache_entry *entry)
+{
+	assert(!entry->is_busy);
+	sqlite3_finalize(entry->stmt);
+	free(entry);
+}
+
+void
+sql_stmt_cache_init(void)
+{
+	cache.by_sql = mh_strnptr_new();
+	cache.by_id = mh_i32ptr_new();
+	if (cache.by_sql == NULL || cache.by_id == NULL)
+		panic("failed to allocate SQL statement cache");
+	rlist_create(&cache.lru);
+	cache.count = 0;
+	cache.mem_used = 0;
+	cache.mem_quota = 0;
+	cache.next_id = 1;
+	cache.hit = 0;
+	cache.miss = 0;
+}
+
+void
+sql_stmt_cache_destroy(void)
+{
+	struct sql_stmt_cache_entry *entry, *tmp;
+	rlist_foreach_entry_safe(entry, &cache.lru, in_lru, tmp) {
+		/* Busy entries are freed by their users. */
+		if (!entry->is_busy)
+			sql_stmt_cache_entry_delete(entry);
+	}
+	mh_strnptr_delete(cache.by_sql);
+	mh_i32ptr_delete(cache.by_id);
+}
+
+/** Remove an entry from the cache. */
+static void
+sql_stmt_cache_evict(struct sql_stmt_cache_entry *entry)
+{
+	mh_int_t pos = mh_strnptr_find_inp(cache.by_sql, entry->sql,
+					   entry->sql_len);
+	assert(pos != mh_end(cache.by_sql));
+	mh_strnptr_del(cache.by_sql, pos, NULL);
+	pos = mh_i32ptr_find(cache.by_id, entry->id, NULL);
+	assert(pos != mh_end(cache.by_id));
+	mh_i32ptr_del(cache.by_id, pos, NULL);
+	rlist_del_entry(entry, in_lru);
+	rlist_create(&entry->in_lru);
+	cache.count--;
+	cache.mem_used -= entry->size;
+	/* Busy entries are freed on release. */
+	if (!entry->is_busy)
+		sql_stmt_cache_entry_delete(entry);
+}
+
+/**
+ * Evict least recently used entries until the cache fits
+ * in the quota. The most recently used entry is never evicted.
+ */
+static void
+sql_stmt_cache_shrink(void)
+{
+	while (cache.mem_used > cache.mem_quota && cache.count > 1) {
+		struct sql_stmt_cache_entry *entry = rlist_first_entry(
+				&cache.lru, struct sql_stmt_cache_entry, in_lru);
+		sql_stmt_cache_evict(entry);
+	}
+}
+
+void
+sql_stmt_cache_set_size(size_t size)
+{
+	cache.mem_quota = size;
+	sql_stmt_cache_shrink();
+}
+
+/** Put a compiled statement to the cache. */
+static struct sql_stmt_cache_entry *
+sql_stmt_cache_add(const char *sql, uint32_t len, struct sqlite3_stmt *stmt)
+{
+	struct sql_stmt_cache_entry *entry = malloc(sizeof(*entry) + len);
+	if (entry == NULL) {
+		diag_set(OutOfMemory, sizeof(*entry) + len,
+			 "malloc", "struct sql_stmt_cache_entry");
+		return NULL;
+	}
+	memcpy(entry->sql, sql, len);
+	entry->sql_len = len;
+	entry->stmt = stmt;
+	entry->sql_flags = current_session()->sql_flags;
+	entry->is_busy = false;
+	entry->size = sizeof(*entry) + len + sql_stmt_size(stmt);
+	/* Skip ids still in use after the counter wraps around. */
+	while (cache.next_id == 0 ||
+	       mh_i32ptr_find(cache.by_id, cache.next_id,
+			      NULL) != mh_end(cache.by_id))
+		cache.next_id++;
+	entry->id = cache.next_id++;
+
+	const struct mh_i32ptr_node_t id_node = { entry->id, entry };
+	mh_int_t id_pos = mh_i32ptr_put(cache.by_id, &id_node, NULL, NULL);
+	if (id_pos == mh_end(cache.by_id)) {
+		diag_set(OutOfMemory, sizeof(id_node), "malloc",
+			 "sql_stmt_cache");
+		free(entry);
+		return NULL;
+	}
+	uint32_t hash = mh_strn_hash(entry->sql, len);
+	const struct mh_strnptr_node_t sql_node =
+		{ entry->sql, len, hash, entry };
+	if (mh_strnptr_put(cache.by_sql, &sql_node, NULL,
+			   NULL) == mh_end(cache.by_sql)) {
+		diag_set(OutOfMemory, sizeof(sql_node), "malloc",
+			 "sql_stmt_cache");
+		mh_i32ptr_del(cache.by_id, id_pos, NULL);
+		free(entry);
+		return NULL;
+	}
+	rlist_add_tail_entry(&cache.lru, entry, in_lru);
+	cache.count++;
+	cache.mem_used += entry->size;
+	sql_stmt_cache_shrink();
+	return entry;
+}
+
+/**
+ * Recompile a cached statement if the schema has changed or
+ * the statement was compiled with other session SQL flags.
+ */
+static int
+sql_stmt_cache_refresh(struct sql_stmt_cache_entry *entry)
+{
+	assert(!entry->is_busy);
+	struct Vdbe *v = (struct Vdbe *)entry->stmt;
+	if (v->schema_ver == box_schema_version() &&
+	    entry->sql_flags == current_session()->sql_flags)
+		return 0;
+	struct sqlite3_stmt *stmt;
+	if (sql_stmt_compile(entry->sql, entry->sql_len, &stmt) != 0)
+		return -1;
+	sqlite3_finalize(entry->stmt);
+	entry->stmt = stmt;
+	/*
+	 * Compiling a PRAGMA may change the flags, remember
+	 * them afterwards so that the PRAGMA is compiled again
+	 * by sessions it would have any effect on.
+	 */
+	entry->sql_flags = current_session()->sql_flags;
+	cache.mem_used -= entry->size;
+	entry->size = sizeof(*entry) + entry->sql_len + sql_stmt_size(stmt);
+	cache.mem_used += entry->size;
+	sql_stmt_cache_shrink();
+	return 0;
+}
+
+/** Look up a statement by SQL text, compiling it on miss. */
+static struct sql_stmt_cache_entry *
+sql_stmt_cache_get(const char *sql, uint32_t len)
+{
+	mh_int_t pos = mh_strnptr_find_inp(cache.by_sql, sql, len);
+	if (pos != mh_end(cache.by_sql)) {
+		cache.hit++;
+		struct sql_stmt_cache_entry *entry =
+			mh_strnptr_node(cache.by_sql, pos)->val;
+		rlist_move_tail_entry(&cache.lru, entry, in_lru);
+		return entry;
+	}
+	cache.miss++;
+	struct sqlite3_stmt *stmt;
+	if (sql_stmt_compile(sql, len, &stmt) != 0)
+		return NULL;
+	struct sql_stmt_cache_entry *entry = sql_stmt_cache_add(sql, len, stmt);
+	if (entry == NULL)
+		sqlite3_finalize(stmt);
+	return entry;
+}
+
+int
+sql_stmt_cache_prepare(const char *sql, uint32_t len, uint32_t *id)
+{
+	struct sql_stmt_cache_entry *entry = sql_stmt_cache_get(sql, len);
+	if (entry == NULL)
+		return -1;
+	if (!entry->is_busy && sql_stmt_cache_refresh(entry) != 0)
+		return -1;
+	*id = entry->id;
+	return 0;
+}
+
+/** Mark a cached statement as being executed. */
+static int
+sql_stmt_cache_use(struct sql_stmt_cache_entry *entry,
+		   struct sqlite3_stmt **stmt,
+		   struct sql_stmt_cache_entry **used)
+{
+	if (entry->is_busy) {
+		/*
+		 * The statement is being executed by another
+		 * fiber, which yielded. Use a private copy.
+		 */
+		*used = NULL;
+		return sql_stmt_compile(entry->sql, entry->sql_len, stmt);
+	}
+	if (sql_stmt_cache_refresh(entry) != 0)
+		return -1;
+	entry->is_busy = true;
+	*stmt = entry->stmt;
+	*used = entry;
+	return 0;
+}
+
+int
+sql_stmt_cache_acquire(const char *sql, uint32_t len,
+		       struct sqlite3_stmt **stmt,
+		       struct sql_stmt_cache_entry **entry)
+{
+	struct sql_stmt_cache_entry *cached = sql_stmt_cache_get(sql, len);
+	if (cached == NULL)
+		return -1;
+	return sql_stmt_cache_use(cached, stmt, entry);
+}
+
+int
+sql_stmt_cache_acquire_by_id(uint32_t id, struct sqlite3_stmt **stmt,
+			     struct sql_stmt_cache_entry **entry)
+{
+	mh_int_t pos = mh_i32ptr_find(cache.by_id, id, NULL);
+	if (pos == mh_end(cache.by_id)) {
+		diag_set(ClientError, ER_WRONG_QUERY_ID, id);
+		return -1;
+	}
+	cache.hit++;
+	struct sql_stmt_cache_entry *cached =
+		mh_i32ptr_node(cache.by_id, pos)->val;
+	rlist_move_tail_entry(&cache.lru, cached, in_lru);
+	return sql_stmt_cache_use(cached, stmt, entry);
+}
+
+void
+sql_stmt_cache_release(struct sql_stmt_cache_entry *entry,
+		       struct sqlite3_stmt *stmt)
+{
+	if (entry == NULL) {
+		sqlite3_finalize(stmt);
+		return;
+	}
+	assert(entry->is_busy);
+	assert(entry->stmt == stmt);
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+	/* Autoincrement ids are allocated on the fiber region. */
+	stailq_create(vdbe_autoinc_id_list((struct Vdbe *)stmt));
+	entry->is_busy = false;
+	if (rlist_empty(&entry->in_lru))
+		sql_stmt_cache_entry_delete(entry);
+}
+
+void
+sql_stmt_cache_stat(struct info_handler *h)
+{
+	info_begin(h);
+	info_table_begin(h, "cache");
+	info_append_int(h, "size", cache.mem_used);
+	info_append_int(h, "stmt_count", cache.count);
+	info_append_int(h, "hit", cache.hit);
+	info_append_int(h, "miss", cache.miss);
+	info_table_end(h); /* cache */
+	info_end(h);
+}
+
+void
+sql_stmt_cache_reset_stat(void)
+{
+	cache.hit = 0;
+	cache.miss = 0;
+}
@@ -0,0 +1,143 @@
+#ifndef TARANTOOL_BOX_SQL_STMT_CACHE_H_INCLUDED
+#define TARANTOOL_BOX_SQL_STMT_CACHE_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct info_handler;
+struct sqlite3_stmt;
+struct sql_stmt_cache_entry;
+
+/**
+ * Cache of compiled SQL statements.
+ *
+ * Compiling an SQL statement into a VDBE program usually takes
+ * longer than executing it, so compiled statements are kept
+ * in the cache keyed by SQL text and reused by subsequent
+ * executions of the same text. Each cached statement is also
+ * assigned a numeric id, which is returned to clients by the
+ * PREPARE request and can be used to execute the statement
+ * without sending its text.
+ *
+ * A cached statement compiled before the last schema change
+ * or with other session SQL flags (PRAGMA full_column_names
+ * and the like) is recompiled the next time it is used. Statements are
+ * evicted in LRU order when the cache size exceeds the limit,
+ * but the most recently used statement is always kept so that
+ * a freshly prepared statement can be executed by id.
+ */
+
+/** Initialize the cache. Panics on memory allocation error. */
+void
+sql_stmt_cache_init(void);
+
+/** Finalize all cached statements and free the cache. */
+void
+sql_stmt_cache_destroy(void);
+
+/** Set the max size of compiled statements stored in the cache. */
+void
+sql_stmt_cache_set_size(size_t size);
+
+/**
+ * Compile an SQL statement and put it to the cache unless
+ * it's already there.
+ *
+ * @param sql SQL statement text.
+ * @param len Length of @a sql.
+ * @param[out] id Id of the cached statement.
+ *
+ * @retval  0 Success.
+ * @retval -1 Compilation or memory error, diag is set.
+ */
+int
+sql_stmt_cache_prepare(const char *sql, uint32_t len, uint32_t *id);
+
+/**
+ * Get a compiled statement for execution, compiling and
+ * caching it if necessary. The statement must be released
+ * with sql_stmt_cache_release() after use.
+ *
+ * If the cached statement is being executed by another fiber,
+ * a private copy is compiled and @a entry is set to NULL.
+ *
+ * @param sql SQL statement text.
+ * @param len Length of @a sql.
+ * @param[out] stmt Statement ready for execution.
+ * @param[out] entry Cache entry of the statement or NULL.
+ *
+ * @retval  0 Success.
+ * @retval -1 Compilation or memory error, diag is set.
+ */
+int
+sql_stmt_cache_acquire(const char *sql, uint32_t len,
+		       struct sqlite3_stmt **stmt,
+		       struct sql_stmt_cache_entry **entry);
+
+/**
+ * Same as sql_stmt_cache_acquire(), but look up the statement
+ * by the id returned by sql_stmt_cache_prepare().
+ *
+ * @retval  0 Success.
+ * @retval -1 The statement isn't in the cache or compilation
+ *            or memory error, diag is set.
+ */
+int
+sql_stmt_cache_acquire_by_id(uint32_t id, struct sqlite3_stmt **stmt,
+			     struct sql_stmt_cache_entry **entry);
+
+/**
+ * Release a statement returned by sql_stmt_cache_acquire().
+ * A cached statement is reset for the next execution while
+ * a private one is finalized.
+ */
+void
+sql_stmt_cache_release(struct sql_stmt_cache_entry *entry,
+		       struct sqlite3_stmt *stmt);
+
+/** Report cache statistics, box.stat.sql(). */
+void
+sql_stmt_cache_stat(struct info_handler *h);
+
+/** Reset cache hit and miss counters. */
+void
+sql_stmt_cache_reset_stat(void);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_SQL_STMT_CACHE_H_INCLUDED */
@@ -48,6 +48,14 @@
 
 enum { HASH_SEED = 13U };
 
+/**
+ * Max number of partial key hashes computed before checking
+ * the bloom filters. Blocks of the filters are prefetched as
+ * soon as the hashes are computed so that all of them are
+ * fetched from memory at the same time.
+ */
+enum { TUPLE_BLOOM_PREFETCH_MAX = 8 };
+
 struct tuple_bloom_builder *
 tuple_bloom_builder_new(uint32_t part_count)
 {
@@ -177,13 +185,23 @@ tuple_bloom_maybe_has(const struct tuple_bloom *bloom,
 	uint32_t h = HASH_SEED;
 	uint32_t carry = 0;
 	uint32_t total_size = 0;
-
-	for (uint32_t i = 0; i < key_def->part_count; i++) {
-		total_size += tuple_hash_key_part(&h, &carry, tuple,
-						  &key_def->parts[i]);
-		uint32_t hash = PMurHash32_Result(h, carry, total_size);
-		if (!bloom_maybe_has(&bloom->parts[i], hash))
-			return false;
+	uint32_t hashes[TUPLE_BLOOM_PREFETCH_MAX];
+
+	for (uint32_t i = 0; i < key_def->part_count; ) {
+		uint32_t n = MIN(key_def->part_count - i,
+				 (uint32_t)TUPLE_BLOOM_PREFETCH_MAX);
+		for (uint32_t j = 0; j < n; j++) {
+			struct key_part *part = &key_def->parts[i + j];
+			total_size += tuple_hash_key_part(&h, &carry,
+							  tuple, part);
+			hashes[j] = PMurHash32_Result(h, carry, total_size);
+			bloom_prefetch(&bloom->parts[i + j], hashes[j]);
+		}
+		for (uint32_t j = 0; j < n; j++) {
+			if (!bloom_maybe_has(&bloom->parts[i + j], hashes[j]))
+				return false;
+		}
+		i += n;
 	}
 	return true;
 }
@@ -206,13 +224,22 @@ tuple_bloom_maybe_has_key(const struct tuple_bloom *bloom,
 	uint32_t h = HASH_SEED;
 	uint32_t carry = 0;
 	uint32_t total_size = 0;
-
-	for (uint32_t i = 0; i < part_count; i++) {
-		total_size += tuple_hash_field(&h, &carry, &key,
-					       key_def->parts[i].coll);
-		uint32_t hash = PMurHash32_Result(h, carry, total_size);
-		if (!bloom_maybe_has(&bloom->parts[i], hash))
-			return false;
+	uint32_t hashes[TUPLE_BLOOM_PREFETCH_MAX];
+
+	for (uint32_t i = 0; i < part_count; ) {
+		uint32_t n = MIN(part_count - i,
+				 (uint32_t)TUPLE_BLOOM_PREFETCH_MAX);
+		for (uint32_t j = 0; j < n; j++) {
+			total_size += tuple_hash_field(&h, &carry, &key,
+						key_def->parts[i + j].coll);
+			hashes[j] = PMurHash32_Result(h, carry, total_size);
+			bloom_prefetch(&bloom->parts[i + j], hashes[j]);
+		}
+		for (uint32_t j = 0; j < n; j++) {
+			if (!bloom_maybe_has(&bloom->parts[i + j], hashes[j]))
+				return false;
+		}
+		i += n;
 	}
 	return true;
 }
@@ -33,6 +33,7 @@
 #include "coll.h"
 #include "trivia/util.h" /* NOINLINE */
 #include <math.h>
+#include <limits.h>
 
 /* {{{ tuple_compare */
 
@@ -763,6 +764,41 @@ key_compare(const char *key_a, const char *key_b, struct key_def *key_def)
 	}
 }
 
+int
+tuple_compare_with_key_raw(const char *tuple, const char *key,
+			   uint32_t part_count, struct key_def *key_def)
+{
+	assert(key != NULL || part_count == 0);
+	assert(part_count <= key_def->part_count);
+	uint32_t field_count = mp_decode_array(&tuple);
+	struct key_part *part = key_def->parts;
+	struct key_part *end = part + part_count;
+	for (; part < end; ++part, mp_next(&key)) {
+		const char *field = NULL;
+		if (part->fieldno < field_count) {
+			field = tuple;
+			for (uint32_t i = 0; i < part->fieldno; i++)
+				mp_next(&field);
+		}
+		enum mp_type a_type = field != NULL ? mp_typeof(*field) :
+				      MP_NIL;
+		enum mp_type b_type = mp_typeof(*key);
+		int rc;
+		if (a_type == MP_NIL) {
+			if (b_type != MP_NIL)
+				return -1;
+			continue;
+		} else if (b_type == MP_NIL) {
+			return 1;
+		}
+		rc = tuple_compare_field_with_hint(field, a_type, key, b_type,
+						   part->type, part->coll);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
 template <bool is_nullable, bool has_optional_parts>
 static int
 tuple_compare_sequential(const struct tuple *tuple_a,
@@ -1273,3 +1309,136 @@ tuple_compare_with_key_create(const struct key_def *def)
 }
 
 /* }}} tuple_compare_with_key */
+
+/* {{{ tuple_hint */
+
+/**
+ * A hint consists of the MessagePack class of the field in the
+ * upper bits, which orders values of different classes the same
+ * way mp_compare_scalar() does, and an order-preserving digest
+ * of the value in the lower HINT_VALUE_BITS bits. Since the
+ * digest only depends on the value, hints stay valid if the
+ * field type of an index part is changed without a rebuild.
+ */
+/** Offset of zero in the digest of a number. */
+#define HINT_NUMBER_ZERO (1ULL << (HINT_VALUE_BITS - 1))
+
+static inline hint_t
+hint_create(enum mp_class mp_class, uint64_t value)
+{
+	assert(value <= HINT_VALUE_MAX);
+	return ((hint_t)mp_class << HINT_VALUE_BITS) | value;
+}
+
+/**
+ * Numbers beyond [-2^59, 2^59) are saturated, doubles are
+ * rounded down, which keeps the digest monotonic.
+ */
+static hint_t
+field_hint_number(const char *field, enum mp_type type)
+{
+	uint64_t value;
+	switch (type) {
+	case MP_UINT: {
+		uint64_t val = mp_decode_uint(&field);
+		value = val > HINT_VALUE_MAX - HINT_NUMBER_ZERO ?
+			HINT_VALUE_MAX : val + HINT_NUMBER_ZERO;
+		break;
+	}
+	case MP_INT: {
+		int64_t val = mp_decode_int(&field);
+		value = val < -(int64_t)HINT_NUMBER_ZERO ? 0 :
+			(uint64_t)(val + (int64_t)HINT_NUMBER_ZERO);
+		break;
+	}
+	case MP_FLOAT:
+	case MP_DOUBLE: {
+		double val = type == MP_FLOAT ? mp_decode_float(&field) :
+			     mp_decode_double(&field);
+		if (isnan(val))
+			return HINT_NONE;
+		if (val >= (double)HINT_NUMBER_ZERO)
+			value = HINT_VALUE_MAX;
+		else if (val < -(double)HINT_NUMBER_ZERO)
+			value = 0;
+		else
+			value = (uint64_t)((int64_t)floor(val) +
+					   (int64_t)HINT_NUMBER_ZERO);
+		break;
+	}
+	default:
+		unreachable();
+		return HINT_NONE;
+	}
+	return hint_create(MP_CLASS_NUMBER, value);
+}
+
+/**
+ * The first bytes of a string or a binary blob, padded with
+ * zeros. A shorter prefix sorts first, like in memcmp().
+ */
+static hint_t
+field_hint_bytes(enum mp_class mp_class, const char *data, uint32_t size)
+{
+	enum { HINT_BYTES = HINT_VALUE_BITS / CHAR_BIT };
+	uint64_t value = 0;
+	for (uint32_t i = 0; i < HINT_BYTES; i++) {
+		value <<= CHAR_BIT;
+		if (i < size)
+			value |= (unsigned char)data[i];
+	}
+	value <<= HINT_VALUE_BITS - HINT_BYTES * CHAR_BIT;
+	return hint_create(mp_class, value);
+}
+
+static hint_t
+field_hint(const char *field, struct coll *coll)
+{
+	if (field == NULL)
+		return hint_create(MP_CLASS_NIL, 0);
+	enum mp_type type = mp_typeof(*field);
+	switch (type) {
+	case MP_NIL:
+		return hint_create(MP_CLASS_NIL, 0);
+	case MP_BOOL:
+		return hint_create(MP_CLASS_BOOL, mp_decode_bool(&field));
+	case MP_UINT:
+	case MP_INT:
+	case MP_FLOAT:
+	case MP_DOUBLE:
+		return field_hint_number(field, type);
+	case MP_STR: {
+		/* Collation order can't be derived from bytes. */
+		if (coll != NULL)
+			return HINT_NONE;
+		uint32_t size;
+		const char *data = mp_decode_str(&field, &size);
+		return field_hint_bytes(MP_CLASS_STR, data, size);
+	}
+	case MP_BIN: {
+		uint32_t size;
+		const char *data = mp_decode_bin(&field, &size);
+		return field_hint_bytes(MP_CLASS_BIN, data, size);
+	}
+	default:
+		return HINT_NONE;
+	}
+}
+
+hint_t
+tuple_hint(const struct tuple *tuple, struct key_def *key_def)
+{
+	assert(key_def->part_count > 0);
+	const struct key_part *part = &key_def->parts[0];
+	return field_hint(tuple_field(tuple, part->fieldno), part->coll);
+}
+
+hint_t
+key_hint(const char *key, uint32_t part_count, struct key_def *key_def)
+{
+	if (part_count == 0)
+		return HINT_NONE;
+	return field_hint(key, key_def->parts[0].coll);
+}
+
+/* }}} tuple_hint */
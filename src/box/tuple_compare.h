@@ -67,6 +67,94 @@ tuple_compare_create(const struct key_def *key_def);
 tuple_compare_with_key_t
 tuple_compare_with_key_create(const struct key_def *key_def);
 
+/**
+ * Compare a tuple with a key like tuple_compare_with_key(), but
+ * find the fields by decoding the tuple instead of using its
+ * format. It is slower, but doesn't access the tuple format
+ * registry, so it is safe to call from threads other than tx
+ * while the tuple memory is alive.
+ * @param tuple tuple data with MessagePack array header
+ * @param key key parts without MessagePack array header
+ * @param part_count the number of parts in @a key
+ * @param key_def key definition
+ * @retval 0  if tuple == key in terms of key_def
+ * @retval <0 if tuple < key in terms of key_def
+ * @retval >0 if tuple > key in terms of key_def
+ */
+int
+tuple_compare_with_key_raw(const char *tuple, const char *key,
+			   uint32_t part_count, struct key_def *key_def);
+
+/**
+ * Tuple comparison hint.
+ *
+ * A hint is a 64-bit number computed from the first key part
+ * of a tuple (or a key) in such a way that hints preserve the
+ * order of keys: if hint(a) < hint(b) then a < b. Equal hints
+ * tell nothing, and the keys have to be compared in full. This
+ * lets an index store hints next to tuple pointers and resolve
+ * most comparisons without touching tuple memory.
+ */
+typedef uint64_t hint_t;
+
+/**
+ * A hint that can't be used for comparison, e.g. for a string
+ * with a collation. Never equal to a valid hint.
+ */
+#define HINT_NONE ((hint_t)UINT64_MAX)
+
+/** Number of low bits of a hint holding a digest of the value. */
+enum {
+	HINT_VALUE_BITS = 60,
+};
+
+#define HINT_VALUE_MAX ((1ULL << HINT_VALUE_BITS) - 1)
+
+/**
+ * Check if a hint of an integer identifies the integer, i.e.
+ * the integer fits in the digest without saturation. Equal
+ * exact hints of two integers mean equal integers.
+ */
+static inline bool
+hint_is_exact(hint_t hint)
+{
+	hint_t value = hint & HINT_VALUE_MAX;
+	return value != 0 && value != HINT_VALUE_MAX;
+}
+
+/**
+ * Compare two hints.
+ * @retval <0 or >0 if the hints are valid and decide the order
+ * @retval 0 if the keys have to be compared in full
+ */
+static inline int
+hint_cmp(hint_t hint_a, hint_t hint_b)
+{
+	if (hint_a == hint_b || hint_a == HINT_NONE || hint_b == HINT_NONE)
+		return 0;
+	return hint_a < hint_b ? -1 : 1;
+}
+
+/**
+ * Compute the comparison hint of a tuple.
+ * @param tuple tuple
+ * @param key_def key definition
+ * @return hint of the first key part of @a tuple
+ */
+hint_t
+tuple_hint(const struct tuple *tuple, struct key_def *key_def);
+
+/**
+ * Compute the comparison hint of a key.
+ * @param key key parts without MessagePack array header
+ * @param part_count the number of parts in @a key
+ * @param key_def key definition
+ * @return hint of the first part of @a key, HINT_NONE
+ *         if @a key is empty
+ */
+hint_t
+key_hint(const char *key, uint32_t part_count, struct key_def *key_def);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "tuple_sketch.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <msgpuck.h>
+#include "diag.h"
+#include "errcode.h"
+#include "key_def.h"
+#include "tuple.h"
+#include "tuple_hash.h"
+#include "third_party/PMurHash.h"
+
+enum { HASH_SEED = 13U };
+
+struct tuple_sketch *
+tuple_sketch_new(uint32_t part_count)
+{
+	size_t size = sizeof(struct tuple_sketch) +
+		part_count * sizeof(struct hll);
+	struct tuple_sketch *sketch = malloc(size);
+	if (sketch == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "tuple sketch");
+		return NULL;
+	}
+	sketch->part_count = 0;
+	for (uint32_t i = 0; i < part_count; i++) {
+		if (hll_create(&sketch->parts[i],
+			       TUPLE_SKETCH_PRECISION) != 0) {
+			diag_set(OutOfMemory, 0, "hll_create",
+				 "tuple sketch part");
+			tuple_sketch_delete(sketch);
+			return NULL;
+		}
+		sketch->part_count++;
+	}
+	return sketch;
+}
+
+void
+tuple_sketch_delete(struct tuple_sketch *sketch)
+{
+	for (uint32_t i = 0; i < sketch->part_count; i++)
+		hll_destroy(&sketch->parts[i]);
+	free(sketch);
+}
+
+void
+tuple_sketch_reset(struct tuple_sketch *sketch)
+{
+	for (uint32_t i = 0; i < sketch->part_count; i++)
+		hll_reset(&sketch->parts[i]);
+}
+
+/**
+ * Spread bits of a 32-bit key hash over a 64-bit value
+ * (MurmurHash3 finalizer), because the estimator takes
+ * the register index from the high bits of a hash.
+ */
+static inline uint64_t
+tuple_sketch_hash(uint32_t hash)
+{
+	uint64_t h = ((uint64_t)hash << 32) | hash;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+void
+tuple_sketch_add(struct tuple_sketch *sketch, const struct tuple *tuple,
+		 struct key_def *key_def)
+{
+	assert(sketch->part_count == key_def->part_count);
+
+	uint32_t h = HASH_SEED;
+	uint32_t carry = 0;
+	uint32_t total_size = 0;
+
+	for (uint32_t i = 0; i < key_def->part_count; i++) {
+		total_size += tuple_hash_key_part(&h, &carry, tuple,
+						  &key_def->parts[i]);
+		uint32_t hash = PMurHash32_Result(h, carry, total_size);
+		hll_add(&sketch->parts[i], tuple_sketch_hash(hash));
+	}
+}
+
+void
+tuple_sketch_merge(struct tuple_sketch *sketch,
+		   const struct tuple_sketch *src)
+{
+	assert(sketch->part_count == src->part_count);
+	for (uint32_t i = 0; i < sketch->part_count; i++)
+		hll_merge(&sketch->parts[i], &src->parts[i]);
+}
+
+size_t
+tuple_sketch_size(const struct tuple_sketch *sketch)
+{
+	size_t size = mp_sizeof_array(sketch->part_count);
+	for (uint32_t i = 0; i < sketch->part_count; i++) {
+		const struct hll *part = &sketch->parts[i];
+		size += mp_sizeof_bin(hll_register_count(part));
+	}
+	return size;
+}
+
+char *
+tuple_sketch_encode(const struct tuple_sketch *sketch, char *buf)
+{
+	buf = mp_encode_array(buf, sketch->part_count);
+	for (uint32_t i = 0; i < sketch->part_count; i++) {
+		const struct hll *part = &sketch->parts[i];
+		buf = mp_encode_bin(buf, (const char *)part->registers,
+				    hll_register_count(part));
+	}
+	return buf;
+}
+
+struct tuple_sketch *
+tuple_sketch_decode(const char **data)
+{
+	uint32_t part_count = mp_decode_array(data);
+	struct tuple_sketch *sketch = tuple_sketch_new(part_count);
+	if (sketch == NULL)
+		return NULL;
+	for (uint32_t i = 0; i < part_count; i++) {
+		struct hll *part = &sketch->parts[i];
+		uint32_t len;
+		const uint8_t *registers =
+			(const uint8_t *)mp_decode_bin(data, &len);
+		assert(len == hll_register_count(part));
+		(void)len;
+		for (uint32_t j = 0; j < hll_register_count(part); j++)
+			hll_update_register(part, j, registers[j]);
+	}
+	return sketch;
+}
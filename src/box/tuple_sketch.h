@@ -0,0 +1,153 @@
+#ifndef TARANTOOL_BOX_TUPLE_SKETCH_H_INCLUDED
+#define TARANTOOL_BOX_TUPLE_SKETCH_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "salad/hll.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct tuple;
+struct key_def;
+
+enum {
+	/**
+	 * Precision of distinct key estimators: 2^10 one-byte
+	 * registers per key part, standard error is about 3%.
+	 */
+	TUPLE_SKETCH_PRECISION = 10,
+};
+
+/**
+ * Estimates of the number of distinct keys stored in an index,
+ * one per each partial key. Engines maintain sketches of their
+ * indexes as tuples are written so that the SQL planner can use
+ * fresh statistics without running ANALYZE.
+ *
+ * A sketch never forgets a key, so it may overestimate the
+ * number of distinct keys after deletions until it is rebuilt.
+ */
+struct tuple_sketch {
+	/** Number of key parts. */
+	uint32_t part_count;
+	/** Estimators, one per each partial key. */
+	struct hll parts[0];
+};
+
+/**
+ * Create a new empty tuple sketch.
+ * @param part_count - number of key parts
+ * @return sketch on success or NULL on OOM
+ */
+struct tuple_sketch *
+tuple_sketch_new(uint32_t part_count);
+
+/**
+ * Delete a tuple sketch.
+ * @param sketch - sketch to delete
+ */
+void
+tuple_sketch_delete(struct tuple_sketch *sketch);
+
+/**
+ * Forget all tuples added to a sketch.
+ * @param sketch - sketch to reset
+ */
+void
+tuple_sketch_reset(struct tuple_sketch *sketch);
+
+/**
+ * Add a tuple to a sketch.
+ * @param sketch - sketch
+ * @param tuple - tuple to add
+ * @param key_def - key definition
+ */
+void
+tuple_sketch_add(struct tuple_sketch *sketch, const struct tuple *tuple,
+		 struct key_def *key_def);
+
+/**
+ * Add all tuples added to @a src to @a sketch.
+ * @param sketch - sketch to update
+ * @param src - sketch to merge, must have the same part count
+ */
+void
+tuple_sketch_merge(struct tuple_sketch *sketch,
+		   const struct tuple_sketch *src);
+
+/**
+ * Estimate the number of distinct partial keys in a sketch.
+ * @param sketch - sketch
+ * @param part_count - length of partial keys, >= 1
+ * @return estimated number of distinct keys
+ */
+static inline uint64_t
+tuple_sketch_distinct(const struct tuple_sketch *sketch, uint32_t part_count)
+{
+	assert(part_count > 0 && part_count <= sketch->part_count);
+	return hll_estimate(&sketch->parts[part_count - 1]);
+}
+
+/**
+ * Return the size of a tuple sketch when encoded.
+ * @param sketch - sketch
+ * @return size of encoded sketch
+ */
+size_t
+tuple_sketch_size(const struct tuple_sketch *sketch);
+
+/**
+ * Encode a tuple sketch in MsgPack.
+ * @param sketch - sketch
+ * @param buf - buffer where to encode the sketch
+ * @return pointer to the first byte after encoded data
+ */
+char *
+tuple_sketch_encode(const struct tuple_sketch *sketch, char *buf);
+
+/**
+ * Decode a tuple sketch from MsgPack.
+ * @param data - pointer to buffer storing encoded sketch
+ * @return sketch on success or NULL on OOM
+ */
+struct tuple_sketch *
+tuple_sketch_decode(const char **data);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_TUPLE_SKETCH_H_INCLUDED */
@@ -32,10 +32,12 @@
 #include "engine.h"
 #include "tuple.h"
 #include "journal.h"
+#include "memtx_tx.h"
 #include <fiber.h>
 #include "xrow.h"
 
 double too_long_threshold;
+int64_t txn_end_count;
 
 static inline void
 fiber_set_txn(struct fiber *fiber, struct txn *txn)
@@ -65,6 +67,7 @@ txn_add_redo(struct txn_stmt *stmt, struct request *request)
 	row->lsn = 0;
 	row->sync = 0;
 	row->tm = 0;
+	row->stream_id = 0;
 	row->bodycnt = xrow_encode_dml(request, row->body);
 	if (row->bodycnt < 0)
 		return -1;
@@ -150,7 +153,17 @@ txn_begin(bool is_autocommit)
 	txn->engine = NULL;
 	txn->engine_tx = NULL;
 	txn->psql_txn = NULL;
-	/* fiber_on_yield/fiber_on_stop initialized by engine on demand */
+	memtx_tx_register_txn(txn);
+	/* fiber_on_yield initialized by engine on demand */
+	if (!is_autocommit) {
+		/*
+		 * A multi-statement transaction must not outlive
+		 * its fiber, it's registered in the transaction
+		 * manager and allocated on the fiber region.
+		 */
+		trigger_create(&txn->fiber_on_stop, txn_on_stop, NULL, NULL);
+		trigger_add(&fiber()->on_stop, &txn->fiber_on_stop);
+	}
 	fiber_set_txn(fiber(), txn);
 	return txn;
 }
@@ -331,6 +344,10 @@ txn_commit(struct txn *txn)
 			goto fail;
 	}
 
+	/* Submit triggers must not yield. */
+	if (txn->has_triggers &&
+	    trigger_run(&txn->on_submit, txn) != 0)
+		goto fail;
 	if (txn->n_rows > 0) {
 		txn->signature = txn_write_to_wal(txn);
 		if (txn->signature < 0)
@@ -358,6 +375,10 @@ txn_commit(struct txn *txn)
 	stailq_foreach_entry(stmt, &txn->stmts, next)
 		txn_stmt_unref_tuples(stmt);
 
+	if (!txn->is_autocommit)
+		trigger_clear(&txn->fiber_on_stop);
+	memtx_tx_unregister_txn(txn);
+	txn_end_count++;
 	TRASH(txn);
 	fiber_set_txn(fiber(), NULL);
 	return 0;
@@ -398,6 +419,10 @@ txn_rollback()
 	stailq_foreach_entry(stmt, &txn->stmts, next)
 		txn_stmt_unref_tuples(stmt);
 
+	if (!txn->is_autocommit)
+		trigger_clear(&txn->fiber_on_stop);
+	memtx_tx_unregister_txn(txn);
+	txn_end_count++;
 	TRASH(txn);
 	/** Free volatile txn memory. */
 	fiber_gc();
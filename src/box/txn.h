@@ -110,6 +110,13 @@ struct txn_savepoint {
 
 extern double too_long_threshold;
 
+/**
+ * Number of transactions that have been committed or rolled
+ * back. Changes made by a transaction are final once it is
+ * counted, so if the counter hasn't changed, neither has data.
+ */
+extern int64_t txn_end_count;
+
 struct sql_txn {
 	/** List of active SQL savepoints. */
 	struct Savepoint *pSavepoint;
@@ -152,7 +159,10 @@ struct txn {
 	 * rolled back at commit.
 	 */
 	bool is_aborted;
-	/** True if on_commit and on_rollback lists are non-empty. */
+	/**
+	 * True if on_commit, on_rollback and on_submit lists
+	 * are initialized.
+	 */
 	bool has_triggers;
 	/** The number of active nested statement-level transactions. */
 	int8_t in_sub_stmt;
@@ -163,6 +173,19 @@ struct txn {
 	struct stailq_entry *sub_stmt_begin[TXN_SUB_STMT_MAX];
 	/** LSN of this transaction when written to WAL. */
 	int64_t signature;
+	/**
+	 * Prepare sequence number assigned by the memtx
+	 * transaction manager when the transaction is prepared.
+	 */
+	int64_t psn;
+	/**
+	 * Read view of the memtx transaction manager: changes
+	 * of transactions prepared with psn <= rv_psn are
+	 * visible to this transaction.
+	 */
+	int64_t rv_psn;
+	/** Link in the list of running memtx transactions. */
+	struct rlist in_all_txs;
 	/** Engine involved in multi-statement transaction. */
 	struct engine *engine;
 	/** Engine-specific transaction data */
@@ -179,6 +202,16 @@ struct txn {
 	struct trigger fiber_on_stop;
 	 /** Commit and rollback triggers */
 	struct rlist on_commit, on_rollback;
+	/**
+	 * Triggers invoked right before the transaction is
+	 * submitted to WAL, after it has been prepared by the
+	 * engine. There is no yield between the triggers and
+	 * the submission, so the order of submission of
+	 * concurrent transactions is the order in which they
+	 * run their on_submit triggers. If a trigger fails,
+	 * the transaction is rolled back.
+	 */
+	struct rlist on_submit;
 	struct sql_txn *psql_txn;
 };
 
@@ -232,6 +265,7 @@ txn_init_triggers(struct txn *txn)
 	if (txn->has_triggers == false) {
 		rlist_create(&txn->on_commit);
 		rlist_create(&txn->on_rollback);
+		rlist_create(&txn->on_submit);
 		txn->has_triggers = true;
 	}
 }
@@ -250,6 +284,13 @@ txn_on_rollback(struct txn *txn, struct trigger *trigger)
 	trigger_add(&txn->on_rollback, trigger);
 }
 
+static inline void
+txn_on_submit(struct txn *txn, struct trigger *trigger)
+{
+	txn_init_triggers(txn);
+	trigger_add(&txn->on_submit, trigger);
+}
+
 /**
  * Start a new statement. If no current transaction,
  * start a new transaction with autocommit = true.
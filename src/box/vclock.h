@@ -210,6 +210,24 @@ vclock_sum(const struct vclock *vclock)
 int64_t
 vclock_follow(struct vclock *vclock, uint32_t replica_id, int64_t lsn);
 
+/**
+ * Move the LSN of given replica id back to a value that
+ * doesn't exceed the current one.
+ *
+ * @param vclock Vector clock.
+ * @param replica_id Replica identifier.
+ * @param lsn New lsn.
+ */
+static inline void
+vclock_reset(struct vclock *vclock, uint32_t replica_id, int64_t lsn)
+{
+	assert(lsn >= 0);
+	assert(replica_id < VCLOCK_MAX);
+	assert(lsn <= vclock->lsn[replica_id]);
+	vclock->signature -= vclock->lsn[replica_id] - lsn;
+	vclock->lsn[replica_id] = lsn;
+}
+
 /**
  * \brief Format vclock to YAML-compatible string representation:
  * { replica_id: lsn, replica_id:lsn })
@@ -44,6 +44,7 @@
 #include "say.h"
 #include "schema.h"
 #include "tuple.h"
+#include "tuple_sketch.h"
 #include "vy_log.h"
 #include "vy_mem.h"
 #include "vy_range.h"
@@ -173,6 +174,15 @@ vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 	if (lsm->mem == NULL)
 		goto fail_mem;
 
+	if (index_def->opts.sketch) {
+		lsm->sketch = tuple_sketch_new(key_def->part_count);
+		if (lsm->sketch == NULL)
+			goto fail_sketch;
+		lsm->mem_sketch = tuple_sketch_new(key_def->part_count);
+		if (lsm->mem_sketch == NULL)
+			goto fail_mem_sketch;
+	}
+
 	lsm->id = -1;
 	lsm->refs = 1;
 	lsm->dump_lsn = -1;
@@ -199,6 +209,10 @@ vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 	lsm_env->lsm_count++;
 	return lsm;
 
+fail_mem_sketch:
+	tuple_sketch_delete(lsm->sketch);
+fail_sketch:
+	vy_mem_delete(lsm->mem);
 fail_mem:
 	histogram_delete(lsm->run_hist);
 fail_run_hist:
@@ -260,6 +274,10 @@ vy_lsm_delete(struct vy_lsm *lsm)
 	key_def_delete(lsm->cmp_def);
 	key_def_delete(lsm->key_def);
 	histogram_delete(lsm->run_hist);
+	if (lsm->sketch != NULL) {
+		tuple_sketch_delete(lsm->sketch);
+		tuple_sketch_delete(lsm->mem_sketch);
+	}
 	vy_lsm_stat_destroy(&lsm->stat);
 	vy_cache_destroy(&lsm->cache);
 	tuple_format_unref(lsm->mem_format);
@@ -660,6 +678,22 @@ vy_lsm_generation(struct vy_lsm *lsm)
 	return oldest->generation;
 }
 
+void
+vy_lsm_update_sketch(struct vy_lsm *lsm)
+{
+	if (lsm->sketch == NULL)
+		return;
+	if (lsm->stat.memory.count.rows == 0)
+		tuple_sketch_reset(lsm->mem_sketch);
+	tuple_sketch_reset(lsm->sketch);
+	if (lsm->sketchless_run_count > 0)
+		return;
+	struct vy_run *run;
+	rlist_foreach_entry(run, &lsm->runs, in_lsm)
+		tuple_sketch_merge(lsm->sketch, run->info.sketch);
+	tuple_sketch_merge(lsm->sketch, lsm->mem_sketch);
+}
+
 int
 vy_lsm_compact_priority(struct vy_lsm *lsm)
 {
@@ -686,6 +720,14 @@ vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run)
 	lsm->bloom_size += bloom_size;
 	lsm->page_index_size += page_index_size;
 
+	if (run->info.sketch == NULL) {
+		lsm->sketchless_run_count++;
+		if (lsm->sketch != NULL)
+			tuple_sketch_reset(lsm->sketch);
+	} else if (lsm->sketch != NULL && lsm->sketchless_run_count == 0) {
+		tuple_sketch_merge(lsm->sketch, run->info.sketch);
+	}
+
 	env->bloom_size += bloom_size;
 	env->page_index_size += page_index_size;
 
@@ -715,6 +757,11 @@ vy_lsm_remove_run(struct vy_lsm *lsm, struct vy_run *run)
 	lsm->bloom_size -= bloom_size;
 	lsm->page_index_size -= page_index_size;
 
+	if (run->info.sketch == NULL) {
+		assert(lsm->sketchless_run_count > 0);
+		lsm->sketchless_run_count--;
+	}
+
 	env->bloom_size -= bloom_size;
 	env->page_index_size -= page_index_size;
 
@@ -991,6 +1038,12 @@ vy_lsm_commit_stmt(struct vy_lsm *lsm, struct vy_mem *mem,
 
 	lsm->stat.memory.count.rows++;
 
+	if (lsm->sketch != NULL && vy_stmt_type(stmt) != IPROTO_DELETE) {
+		tuple_sketch_add(lsm->mem_sketch, stmt, lsm->key_def);
+		if (lsm->sketchless_run_count == 0)
+			tuple_sketch_add(lsm->sketch, stmt, lsm->key_def);
+	}
+
 	if (vy_stmt_type(stmt) == IPROTO_UPSERT)
 		vy_lsm_commit_upsert(lsm, mem, stmt);
 
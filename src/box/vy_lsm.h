@@ -53,6 +53,7 @@ struct histogram;
 struct index;
 struct tuple;
 struct tuple_format;
+struct tuple_sketch;
 struct vy_lsm;
 struct vy_mem;
 struct vy_mem_env;
@@ -91,6 +92,22 @@ struct vy_lsm_env {
 	size_t bloom_size;
 	/** Size of memory used for page index. */
 	size_t page_index_size;
+	/**
+	 * Distinct key estimates of all statements stored in
+	 * this LSM tree, on disk and in memory. Exported to the
+	 * SQL planner as index::sketch. Kept empty while there
+	 * are runs written without estimates. NULL if disabled
+	 * by index_opts::sketch.
+	 */
+	struct tuple_sketch *sketch;
+	/**
+	 * Distinct key estimates of statements committed to
+	 * in-memory trees since they were empty last time.
+	 * NULL if disabled by index_opts::sketch.
+	 */
+	struct tuple_sketch *mem_sketch;
+	/** Number of runs that don't have distinct key estimates. */
+	int sketchless_run_count;
 	/** Global disk statistics. */
 	struct vy_disk_stat disk_stat;
 	/** Memory pool for vy_history_node allocations. */
@@ -416,6 +433,15 @@ vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run);
 void
 vy_lsm_remove_run(struct vy_lsm *lsm, struct vy_run *run);
 
+/**
+ * Rebuild distinct key estimates of an LSM tree from estimates
+ * of its runs and in-memory trees. Called when runs are removed
+ * or in-memory trees are dumped so that the estimates forget
+ * statements that are no longer stored in the LSM tree.
+ */
+void
+vy_lsm_update_sketch(struct vy_lsm *lsm);
+
 /**
  * Add a range to both the range tree and the range heap
  * of an LSM tree.
@@ -128,7 +128,8 @@ vy_point_lookup_scan_mems(struct vy_lsm *lsm, const struct vy_read_view **rv,
 }
 
 /**
- * Scan one particular slice.
+ * Scan one particular slice, whose bloom filter has already
+ * been checked for the key, see vy_point_lookup_scan_slices().
  * Add found statements to the history list up to terminal statement.
  */
 static int
@@ -145,6 +146,7 @@ vy_point_lookup_scan_slice(struct vy_lsm *lsm, struct vy_slice *slice,
 	vy_run_iterator_open(&run_itr, &lsm->stat.disk.iterator, slice,
 			     ITER_EQ, key, rv, lsm->cmp_def, lsm->key_def,
 			     lsm->disk_format, lsm->index_id == 0);
+	run_itr.is_bloom_checked = true;
 	struct vy_history slice_history;
 	vy_history_create(&slice_history, &lsm->env->history_node_pool);
 	int rc = vy_run_iterator_next(&run_itr, &slice_history);
@@ -153,11 +155,71 @@ vy_point_lookup_scan_slice(struct vy_lsm *lsm, struct vy_slice *slice,
 	return rc;
 }
 
+/** Scan of one slice that may contain the looked up key. */
+struct vy_point_lookup_task {
+	struct vy_lsm *lsm;
+	struct vy_slice *slice;
+	const struct vy_read_view **rv;
+	struct tuple *key;
+	/** Statements found in the slice. */
+	struct vy_history history;
+	/** Fiber scanning the slice or NULL. */
+	struct fiber *fiber;
+};
+
+static int
+vy_point_lookup_task_f(va_list ap)
+{
+	struct vy_point_lookup_task *task =
+		va_arg(ap, struct vy_point_lookup_task *);
+	return vy_point_lookup_scan_slice(task->lsm, task->slice, task->rv,
+					  task->key, &task->history);
+}
+
+/**
+ * Scan slices concurrently. Every slice but the first one is
+ * scanned in its own fiber so that disk reads from different
+ * runs are issued at the same time and spread among reader
+ * threads. If a fiber can't be started, the slice is scanned
+ * in the caller's fiber.
+ */
+static int
+vy_point_lookup_run_tasks(struct vy_point_lookup_task *tasks, int count)
+{
+	for (int i = 1; i < count; i++) {
+		struct vy_point_lookup_task *task = &tasks[i];
+		task->fiber = fiber_new("vinyl.lookup", vy_point_lookup_task_f);
+		if (task->fiber == NULL) {
+			diag_clear(diag_get());
+			continue;
+		}
+		fiber_set_joinable(task->fiber, true);
+		fiber_start(task->fiber, task);
+	}
+	int rc = 0;
+	for (int i = 0; i < count; i++) {
+		struct vy_point_lookup_task *task = &tasks[i];
+		if (task->fiber != NULL) {
+			if (fiber_join(task->fiber) != 0)
+				rc = -1;
+		} else if (rc == 0) {
+			rc = vy_point_lookup_scan_slice(task->lsm, task->slice,
+							task->rv, task->key,
+							&task->history);
+		}
+	}
+	return rc;
+}
+
 /**
  * Find a range and scan all slices that belongs to the range.
  * Add found statements to the history list up to terminal statement.
  * All slices are pinned before first slice scan, so it's guaranteed
  * that complete history from runs will be extracted.
+ *
+ * Slices whose bloom filters reject the key are skipped, the
+ * rest are scanned concurrently and their histories are merged
+ * afterwards.
  */
 static int
 vy_point_lookup_scan_slices(struct vy_lsm *lsm, const struct vy_read_view **rv,
@@ -169,24 +231,52 @@ vy_point_lookup_scan_slices(struct vy_lsm *lsm, const struct vy_read_view **rv,
 	int slice_count = range->slice_count;
 	struct vy_slice **slices = (struct vy_slice **)
 		region_alloc(&fiber()->gc, slice_count * sizeof(*slices));
-	if (slices == NULL) {
-		diag_set(OutOfMemory, slice_count * sizeof(*slices),
+	struct vy_point_lookup_task *tasks = (struct vy_point_lookup_task *)
+		region_alloc(&fiber()->gc, slice_count * sizeof(*tasks));
+	if (slices == NULL || tasks == NULL) {
+		diag_set(OutOfMemory, slice_count * (sizeof(*slices) +
+						     sizeof(*tasks)),
 			 "region", "slices array");
 		return -1;
 	}
 	int i = 0;
+	int task_count = 0;
 	struct vy_slice *slice;
 	rlist_foreach_entry(slice, &range->slices, in_range) {
-		vy_slice_pin(slice);
 		slices[i++] = slice;
+		if (!vy_run_maybe_has(slice->run, key, lsm->key_def))
+			continue;
+		struct vy_point_lookup_task *task = &tasks[task_count++];
+		task->lsm = lsm;
+		task->slice = slice;
+		task->rv = rv;
+		task->key = key;
+		task->fiber = NULL;
+		vy_history_create(&task->history,
+				  &lsm->env->history_node_pool);
+		vy_slice_pin(slice);
 	}
 	assert(i == slice_count);
-	int rc = 0;
+	int rc = vy_point_lookup_run_tasks(tasks, task_count);
+	/*
+	 * Merge histories in the slice order. Account bloom
+	 * filter hits only for slices that would have been
+	 * checked by a sequential scan.
+	 */
+	struct vy_point_lookup_task *task = tasks;
 	for (i = 0; i < slice_count; i++) {
-		if (rc == 0 && !vy_history_is_terminal(history))
-			rc = vy_point_lookup_scan_slice(lsm, slices[i],
-							rv, key, history);
-		vy_slice_unpin(slices[i]);
+		bool is_done = rc != 0 || vy_history_is_terminal(history);
+		if (task == tasks + task_count || task->slice != slices[i]) {
+			if (!is_done)
+				lsm->stat.disk.iterator.bloom_hit++;
+			continue;
+		}
+		if (!is_done)
+			vy_history_splice(history, &task->history);
+		else
+			vy_history_cleanup(&task->history);
+		vy_slice_unpin(task->slice);
+		task++;
 	}
 	return rc;
 }
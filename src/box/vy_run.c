@@ -41,6 +41,7 @@
 
 #include "replication.h"
 #include "tuple_bloom.h"
+#include "tuple_sketch.h"
 #include "tuple_compare.h"
 #include "xlog.h"
 #include "xrow.h"
@@ -161,6 +162,143 @@ vy_run_env_stop_readers(struct vy_run_env *env)
 	free(env->reader_pool);
 }
 
+/* {{{ vy_page_cache */
+
+static void
+vy_page_delete(struct vy_page *page);
+
+static inline void
+vy_page_ref(struct vy_page *page)
+{
+	page->refs++;
+}
+
+static inline void
+vy_page_unref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	if (--page->refs == 0)
+		vy_page_delete(page);
+}
+
+/** Return the size of memory occupied by a page. */
+static inline size_t
+vy_page_mem_used(struct vy_page *page)
+{
+	return sizeof(*page) + page->unpacked_size +
+	       page->row_count * sizeof(*page->row_index);
+}
+
+static void
+vy_page_cache_create(struct vy_page_cache *cache)
+{
+	rlist_create(&cache->lru);
+	cache->mem_used = 0;
+	cache->quota = 0;
+	cache->hit = 0;
+	cache->miss = 0;
+}
+
+/** Remove a page from the cache. */
+static void
+vy_page_cache_evict(struct vy_page_cache *cache, struct vy_page *page)
+{
+	struct vy_run *run = page->run;
+	assert(run != NULL && run->cached_pages[page->page_no] == page);
+	run->cached_pages[page->page_no] = NULL;
+	page->run = NULL;
+	rlist_del_entry(page, in_lru);
+	assert(cache->mem_used >= vy_page_mem_used(page));
+	cache->mem_used -= vy_page_mem_used(page);
+	vy_page_unref(page);
+}
+
+/** Evict least recently used pages until the cache fits the quota. */
+static void
+vy_page_cache_shrink(struct vy_page_cache *cache)
+{
+	while (cache->mem_used > cache->quota) {
+		assert(!rlist_empty(&cache->lru));
+		struct vy_page *page = rlist_first_entry(&cache->lru,
+							 struct vy_page,
+							 in_lru);
+		vy_page_cache_evict(cache, page);
+	}
+}
+
+static void
+vy_page_cache_destroy(struct vy_page_cache *cache)
+{
+	cache->quota = 0;
+	vy_page_cache_shrink(cache);
+}
+
+/** Remove all pages of a run from the cache. */
+static void
+vy_page_cache_purge_run(struct vy_page_cache *cache, struct vy_run *run)
+{
+	if (run->cached_pages == NULL)
+		return;
+	for (uint32_t page_no = 0; page_no < run->info.page_count; page_no++) {
+		struct vy_page *page = run->cached_pages[page_no];
+		if (page != NULL)
+			vy_page_cache_evict(cache, page);
+	}
+	free(run->cached_pages);
+	run->cached_pages = NULL;
+}
+
+/**
+ * Look up a page in the cache.
+ * Returns the page with the reference counter elevated or
+ * NULL if the page isn't cached.
+ */
+static struct vy_page *
+vy_page_cache_get(struct vy_page_cache *cache, struct vy_run *run,
+		  uint32_t page_no)
+{
+	if (cache->quota == 0)
+		return NULL;
+	struct vy_page *page = NULL;
+	if (run->cached_pages != NULL)
+		page = run->cached_pages[page_no];
+	if (page == NULL) {
+		cache->miss++;
+		return NULL;
+	}
+	cache->hit++;
+	rlist_move_tail_entry(&cache->lru, page, in_lru);
+	vy_page_ref(page);
+	return page;
+}
+
+/** Add a page read from disk to the cache. */
+static void
+vy_page_cache_put(struct vy_page_cache *cache, struct vy_run *run,
+		  struct vy_page *page)
+{
+	assert(page->run == NULL);
+	size_t size = vy_page_mem_used(page);
+	if (size > cache->quota)
+		return;
+	if (run->cached_pages == NULL) {
+		run->cached_pages = calloc(run->info.page_count,
+					   sizeof(*run->cached_pages));
+		if (run->cached_pages == NULL)
+			return; /* caching is optional */
+	}
+	if (run->cached_pages[page->page_no] != NULL)
+		return; /* the page was read by another fiber */
+	run->cached_pages[page->page_no] = page;
+	page->run = run;
+	rlist_add_tail_entry(&cache->lru, page, in_lru);
+	cache->mem_used += size;
+	vy_page_ref(page);
+	vy_page_cache_shrink(cache);
+}
+
+/* }}} vy_page_cache */
+
 /**
  * Initialize vinyl run environment
  */
@@ -172,6 +310,7 @@ vy_run_env_create(struct vy_run_env *env, int read_threads)
 	tt_pthread_key_create(&env->zdctx_key, vy_free_zdctx);
 	mempool_create(&env->read_task_pool, cord_slab_cache(),
 		       sizeof(struct vy_page_read_task));
+	vy_page_cache_create(&env->page_cache);
 }
 
 /**
@@ -182,10 +321,18 @@ vy_run_env_destroy(struct vy_run_env *env)
 {
 	if (env->reader_pool != NULL)
 		vy_run_env_stop_readers(env);
+	vy_page_cache_destroy(&env->page_cache);
 	mempool_destroy(&env->read_task_pool);
 	tt_pthread_key_delete(env->zdctx_key);
 }
 
+void
+vy_run_env_set_page_cache(struct vy_run_env *env, size_t quota)
+{
+	env->page_cache.quota = quota;
+	vy_page_cache_shrink(&env->page_cache);
+}
+
 /**
  * Enable coio reads for a vinyl run environment.
  */
@@ -259,6 +406,10 @@ vy_run_clear(struct vy_run *run)
 		tuple_bloom_delete(run->info.bloom);
 		run->info.bloom = NULL;
 	}
+	if (run->info.sketch != NULL) {
+		tuple_sketch_delete(run->info.sketch);
+		run->info.sketch = NULL;
+	}
 	free(run->info.min_key);
 	run->info.min_key = NULL;
 	free(run->info.max_key);
@@ -269,6 +420,7 @@ void
 vy_run_delete(struct vy_run *run)
 {
 	assert(run->refs == 0);
+	vy_page_cache_purge_run(&run->env->page_cache, run);
 	if (run->fd >= 0 && close(run->fd) < 0)
 		say_syserror("close failed");
 	vy_run_clear(run);
@@ -282,6 +434,22 @@ vy_run_bloom_size(struct vy_run *run)
 	return run->info.bloom == NULL ? 0 : tuple_bloom_size(run->info.bloom);
 }
 
+bool
+vy_run_maybe_has(struct vy_run *run, const struct tuple *key,
+		 struct key_def *key_def)
+{
+	struct tuple_bloom *bloom = run->info.bloom;
+	if (bloom == NULL)
+		return true;
+	if (vy_stmt_type(key) == IPROTO_SELECT) {
+		const char *data = tuple_data(key);
+		uint32_t part_count = mp_decode_array(&data);
+		return tuple_bloom_maybe_has_key(bloom, data, part_count,
+						 key_def);
+	}
+	return tuple_bloom_maybe_has(bloom, key, key_def);
+}
+
 /**
  * Find a page from which the iteration of a given key must be started.
  * LE and LT: the found page definitely contains the position
@@ -633,6 +801,11 @@ vy_run_info_decode(struct vy_run_info *run_info,
 		case VY_RUN_INFO_STMT_STAT:
 			vy_stmt_stat_decode(&run_info->stmt_stat, &pos);
 			break;
+		case VY_RUN_INFO_SKETCH:
+			run_info->sketch = tuple_sketch_decode(&pos);
+			if (run_info->sketch == NULL)
+				return -1;
+			break;
 		default:
 			diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
 				"Can't decode run info: unknown key %u",
@@ -660,6 +833,9 @@ vy_page_new(const struct vy_page_info *page_info)
 			 "load_page", "page cache");
 		return NULL;
 	}
+	page->refs = 1;
+	page->run = NULL;
+	rlist_create(&page->in_lru);
 	page->unpacked_size = page_info->unpacked_size;
 	page->row_count = page_info->row_count;
 	page->row_index = calloc(page_info->row_count, sizeof(uint32_t));
@@ -684,6 +860,7 @@ vy_page_new(const struct vy_page_info *page_info)
 static void
 vy_page_delete(struct vy_page *page)
 {
+	assert(page->run == NULL);
 	uint32_t *row_index = page->row_index;
 	char *data = page->data;
 #if !defined(NDEBUG)
@@ -743,9 +920,9 @@ vy_run_iterator_stop(struct vy_run_iterator *itr)
 		itr->curr_stmt = NULL;
 	}
 	if (itr->curr_page != NULL) {
-		vy_page_delete(itr->curr_page);
+		vy_page_unref(itr->curr_page);
 		if (itr->prev_page != NULL)
-			vy_page_delete(itr->prev_page);
+			vy_page_unref(itr->prev_page);
 		itr->curr_page = itr->prev_page = NULL;
 	}
 	itr->search_ended = true;
@@ -938,9 +1115,15 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		}
 	}
 
+	/* Check the page cache */
+	struct vy_page *page = vy_page_cache_get(&env->page_cache,
+						 slice->run, page_no);
+	if (page != NULL)
+		goto done;
+
 	/* Allocate buffers */
 	struct vy_page_info *page_info = vy_run_page_info(slice->run, page_no);
-	struct vy_page *page = vy_page_new(page_info);
+	page = vy_page_new(page_info);
 	if (page == NULL)
 		return -1;
 
@@ -998,18 +1181,20 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		}
 	}
 
-	/* Update cache */
-	if (itr->prev_page != NULL)
-		vy_page_delete(itr->prev_page);
-	itr->prev_page = itr->curr_page;
-	itr->curr_page = page;
 	page->page_no = page_no;
+	vy_page_cache_put(&env->page_cache, slice->run, page);
 
 	/* Update read statistics. */
 	itr->stat->read.rows += page_info->row_count;
 	itr->stat->read.bytes += page_info->unpacked_size;
 	itr->stat->read.bytes_compressed += page_info->size;
 	itr->stat->read.pages++;
+done:
+	/* Update cache */
+	if (itr->prev_page != NULL)
+		vy_page_unref(itr->prev_page);
+	itr->prev_page = itr->curr_page;
+	itr->curr_page = page;
 
 	*result = page;
 	return 0;
@@ -1256,23 +1441,12 @@ vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 	*ret = NULL;
 
 	struct tuple_bloom *bloom = run->info.bloom;
-	struct key_def *key_def = itr->key_def;
-	if (iterator_type == ITER_EQ && bloom != NULL) {
-		bool need_lookup;
-		if (vy_stmt_type(key) == IPROTO_SELECT) {
-			const char *data = tuple_data(key);
-			uint32_t part_count = mp_decode_array(&data);
-			need_lookup = tuple_bloom_maybe_has_key(bloom, data,
-							part_count, key_def);
-		} else {
-			need_lookup = tuple_bloom_maybe_has(bloom, key,
-							    key_def);
-		}
-		if (!need_lookup) {
-			itr->search_ended = true;
-			itr->stat->bloom_hit++;
-			return 0;
-		}
+	if (iterator_type == ITER_EQ &&
+	    (key != itr->key || !itr->is_bloom_checked) &&
+	    !vy_run_maybe_has(run, key, itr->key_def)) {
+		itr->search_ended = true;
+		itr->stat->bloom_hit++;
+		return 0;
 	}
 
 	itr->stat->lookup++;
@@ -1442,6 +1616,7 @@ vy_run_iterator_open(struct vy_run_iterator *itr,
 
 	itr->search_started = false;
 	itr->search_ended = false;
+	itr->is_bloom_checked = false;
 }
 
 /**
@@ -1962,6 +2137,8 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	uint32_t key_count = 6;
 	if (run_info->bloom != NULL)
 		key_count++;
+	if (run_info->sketch != NULL)
+		key_count++;
 
 	size_t size = mp_sizeof_map(key_count);
 	size += mp_sizeof_uint(VY_RUN_INFO_MIN_KEY) + min_key_size;
@@ -1977,6 +2154,9 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 			tuple_bloom_size(run_info->bloom);
 	size += mp_sizeof_uint(VY_RUN_INFO_STMT_STAT) +
 		vy_stmt_stat_sizeof(&run_info->stmt_stat);
+	if (run_info->sketch != NULL)
+		size += mp_sizeof_uint(VY_RUN_INFO_SKETCH) +
+			tuple_sketch_size(run_info->sketch);
 
 	char *pos = region_alloc(&fiber()->gc, size);
 	if (pos == NULL) {
@@ -2005,6 +2185,10 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	}
 	pos = mp_encode_uint(pos, VY_RUN_INFO_STMT_STAT);
 	pos = vy_stmt_stat_encode(&run_info->stmt_stat, pos);
+	if (run_info->sketch != NULL) {
+		pos = mp_encode_uint(pos, VY_RUN_INFO_SKETCH);
+		pos = tuple_sketch_encode(run_info->sketch, pos);
+	}
 	xrow->body->iov_len = (void *)pos - xrow->body->iov_base;
 	xrow->bodycnt = 1;
 	xrow->type = VY_INDEX_RUN_INFO;
@@ -2099,6 +2283,12 @@ vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 		if (writer->bloom == NULL)
 			return -1;
 	}
+	writer->sketch = tuple_sketch_new(key_def->part_count);
+	if (writer->sketch == NULL) {
+		if (writer->bloom != NULL)
+			tuple_bloom_builder_delete(writer->bloom);
+		return -1;
+	}
 	xlog_clear(&writer->data_xlog);
 	ibuf_create(&writer->row_index_buf, &cord()->slabc,
 		    4096 * sizeof(uint32_t));
@@ -2182,6 +2372,8 @@ vy_run_writer_write_to_page(struct vy_run_writer *writer, struct tuple *stmt)
 		tuple_bloom_builder_add(writer->bloom, stmt,
 					writer->key_def, hashed_parts);
 	}
+	if (vy_stmt_type(stmt) != IPROTO_DELETE)
+		tuple_sketch_add(writer->sketch, stmt, writer->key_def);
 	if (writer->last_stmt != NULL)
 		vy_stmt_unref_if_possible(writer->last_stmt);
 	writer->last_stmt = stmt;
@@ -2280,6 +2472,8 @@ vy_run_writer_destroy(struct vy_run_writer *writer, bool reuse_fd)
 		xlog_close(&writer->data_xlog, reuse_fd);
 	if (writer->bloom != NULL)
 		tuple_bloom_builder_delete(writer->bloom);
+	if (writer->sketch != NULL)
+		tuple_sketch_delete(writer->sketch);
 	ibuf_destroy(&writer->row_index_buf);
 }
 
@@ -2327,6 +2521,8 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 		if (run->info.bloom == NULL)
 			goto out;
 	}
+	run->info.sketch = writer->sketch;
+	writer->sketch = NULL;
 	if (vy_run_write_index(run, writer->dirpath,
 			       writer->space_id, writer->iid) != 0)
 		goto out;
@@ -2352,6 +2548,7 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 		     struct tuple_format *format, const struct index_opts *opts)
 {
 	assert(run->info.bloom == NULL);
+	assert(run->info.sketch == NULL);
 	assert(run->page_info == NULL);
 	struct region *region = &fiber()->gc;
 	size_t mem_used = region_used(region);
@@ -2379,6 +2576,9 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 		if (bloom_builder == NULL)
 			goto close_err;
 	}
+	run->info.sketch = tuple_sketch_new(key_def->part_count);
+	if (run->info.sketch == NULL)
+		goto close_err;
 
 	off_t page_offset, next_page_offset = xlog_cursor_pos(&cursor);
 	while ((rc = xlog_cursor_next_tx(&cursor)) == 0) {
@@ -2412,6 +2612,9 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 				tuple_bloom_builder_add(bloom_builder, tuple,
 							key_def, hashed_parts);
 			}
+			if (vy_stmt_type(tuple) != IPROTO_DELETE)
+				tuple_sketch_add(run->info.sketch, tuple,
+						 key_def);
 			key = tuple_extract_key(tuple, cmp_def, NULL);
 			if (prev_tuple != NULL)
 				tuple_unref(prev_tuple);
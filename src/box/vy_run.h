@@ -51,6 +51,25 @@ extern "C" {
 
 struct vy_history;
 struct vy_run_reader;
+struct tuple_sketch;
+
+/**
+ * Cache of decompressed run pages shared by all runs of
+ * an environment. Cached pages are evicted in the LRU order
+ * when their total size exceeds the quota.
+ */
+struct vy_page_cache {
+	/** Cached pages, least recently used first. */
+	struct rlist lru;
+	/** Size of memory occupied by cached pages. */
+	size_t mem_used;
+	/** Max size of cached pages. Zero disables the cache. */
+	size_t quota;
+	/** Number of page reads served from the cache. */
+	int64_t hit;
+	/** Number of page reads that had to go to disk. */
+	int64_t miss;
+};
 
 /** Part of vinyl environment for run read/write */
 struct vy_run_env {
@@ -69,6 +88,8 @@ struct vy_run_env {
 	 * processing the next read request.
 	 */
 	int next_reader;
+	/** Cache of pages read by run iterators. */
+	struct vy_page_cache page_cache;
 };
 
 /**
@@ -89,6 +110,11 @@ struct vy_run_info {
 	struct tuple_bloom *bloom;
 	/** Statement statistics. */
 	struct vy_stmt_stat stmt_stat;
+	/**
+	 * Distinct key estimates of all tuples in the run or
+	 * NULL if the run was written without them.
+	 */
+	struct tuple_sketch *sketch;
 };
 
 /**
@@ -151,6 +177,12 @@ struct vy_run {
 	struct rlist in_unused;
 	/** Link in vy_lsm::runs list. */
 	struct rlist in_lsm;
+	/**
+	 * Pages of this run stored in the page cache, indexed
+	 * by page number, or NULL if no page of this run has
+	 * been cached yet.
+	 */
+	struct vy_page **cached_pages;
 };
 
 /**
@@ -261,6 +293,12 @@ struct vy_run_iterator {
 	struct vy_page *prev_page;
 	/** Is false until first .._get or .._next_.. method is called */
 	bool search_started;
+	/**
+	 * Set if the caller has already checked the run bloom
+	 * filter for the search key, so the iterator need not
+	 * probe it again. Cleared by vy_run_iterator_open().
+	 */
+	bool is_bloom_checked;
 	/** Search is finished, you will not get more values from iterator */
 	bool search_ended;
 };
@@ -271,6 +309,12 @@ struct vy_run_iterator {
 struct vy_page {
 	/** Page position in the run file. */
 	uint32_t page_no;
+	/** Number of run iterators using the page plus the cache. */
+	int refs;
+	/** Run the page is cached for or NULL if not cached. */
+	struct vy_run *run;
+	/** Link in vy_page_cache::lru. */
+	struct rlist in_lru;
 	/** Size of page data in memory, i.e. unpacked. */
 	uint32_t unpacked_size;
 	/** Number of statements in the page. */
@@ -297,6 +341,13 @@ vy_run_env_create(struct vy_run_env *env, int read_threads);
 void
 vy_run_env_destroy(struct vy_run_env *env);
 
+/**
+ * Set the max size of memory occupied by cached pages.
+ * Zero disables the page cache.
+ */
+void
+vy_run_env_set_page_cache(struct vy_run_env *env, size_t quota);
+
 /**
  * Enable coio reads for a vinyl run environment.
  *
@@ -318,6 +369,15 @@ vy_run_env_enable_coio(struct vy_run_env *env);
 size_t
 vy_run_bloom_size(struct vy_run *run);
 
+/**
+ * Check the run bloom filter for a full key. Return false if
+ * the run definitely doesn't have the key, true otherwise.
+ * The key may be a SELECT statement or a tuple.
+ */
+bool
+vy_run_maybe_has(struct vy_run *run, const struct tuple *key,
+		 struct key_def *key_def);
+
 static inline struct vy_page_info *
 vy_run_page_info(struct vy_run *run, uint32_t pos)
 {
@@ -603,6 +663,8 @@ struct vy_run_writer {
 	double bloom_fpr;
 	/** Bloom filter. */
 	struct tuple_bloom_builder *bloom;
+	/** Distinct key estimates of written statements. */
+	struct tuple_sketch *sketch;
 	/** Buffer of a current page row offsets. */
 	struct ibuf row_index_buf;
 	/**
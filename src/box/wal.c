@@ -43,6 +43,10 @@
 #include "cbus.h"
 #include "coio_task.h"
 #include "replication.h"
+#include "histogram.h"
+#include "latency.h"
+#include "info.h"
+#include "wal_mem.h"
 
 enum {
 	/**
@@ -56,6 +60,9 @@ enum {
 	WAL_FALLOCATE_LEN = 1024 * 1024,
 };
 
+/** Percentiles reported by box.stat.wal(). */
+static const int wal_stat_pct[WAL_STAT_PCT_COUNT] = { 50, 90, 99 };
+
 const char *wal_mode_STRS[] = { "none", "write", "fsync", NULL };
 
 int wal_dir_lock = -1;
@@ -158,6 +165,42 @@ struct wal_writer
 	 * Used for replication relays.
 	 */
 	struct rlist watchers;
+	/**
+	 * Max time to wait for more requests before writing
+	 * a batch to disk, box.cfg.wal_batch_max_delay.
+	 * 0 means write every message as soon as it arrives.
+	 */
+	double batch_max_delay;
+	/**
+	 * Write a batch without waiting for batch_max_delay
+	 * once it grows this big, box.cfg.wal_batch_max_bytes.
+	 */
+	int64_t batch_max_bytes;
+	/**
+	 * Messages received from tx, but not written yet,
+	 * linked by wal_msg::in_batch.
+	 */
+	struct stailq batch;
+	/** Approximate size of all requests in the batch. */
+	size_t batch_len;
+	/** Timer writing the batch when batch_max_delay expires. */
+	struct ev_timer batch_timer;
+	/** Number of batches written to disk. */
+	int64_t stat_batches;
+	/** Number of requests written to disk. */
+	int64_t stat_requests;
+	/** Number of bytes written to disk. */
+	int64_t stat_bytes;
+	/** Histogram of the number of requests per batch. */
+	struct histogram *batch_hist;
+	/** Time it takes to write (and sync) a batch. */
+	struct latency write_latency;
+	/**
+	 * Rows written recently. Relays read rows from here
+	 * rather than from xlog files unless they lag behind.
+	 * Its size is box.cfg.wal_cache_size.
+	 */
+	struct wal_mem mem;
 };
 
 struct wal_msg {
@@ -171,6 +214,8 @@ struct wal_msg {
 	 * be rolled back.
 	 */
 	struct stailq rollback;
+	/** Link in wal_writer::batch. */
+	struct stailq_entry in_batch;
 };
 
 /**
@@ -191,14 +236,30 @@ wal_mode()
 	return wal_writer_singleton.wal_mode;
 }
 
+struct wal_mem *
+wal_get_mem(void)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return NULL;
+	return &writer->mem;
+}
+
 static void
 wal_write_to_disk(struct cmsg *msg);
 
 static void
 tx_schedule_commit(struct cmsg *msg);
 
+/**
+ * A request stops in the WAL thread until the batch it belongs
+ * to is written, then it is sent back along wal_reply_route.
+ */
 static struct cmsg_hop wal_request_route[] = {
-	{wal_write_to_disk, &wal_thread.tx_prio_pipe},
+	{wal_write_to_disk, NULL},
+};
+
+static struct cmsg_hop wal_reply_route[] = {
 	{tx_schedule_commit, NULL},
 };
 
@@ -335,6 +396,9 @@ tx_notify_checkpoint(struct cmsg *msg)
 	free(msg);
 }
 
+static void
+wal_batch_timer_cb(ev_loop *loop, ev_timer *timer, int events);
+
 /**
  * Initialize WAL writer context. Even though it's a singleton,
  * encapsulate the details just in case we may use
@@ -373,6 +437,29 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 
 	writer->on_garbage_collection = on_garbage_collection;
 	writer->on_checkpoint_threshold = on_checkpoint_threshold;
+
+	writer->batch_max_delay = 0;
+	writer->batch_max_bytes = INT64_MAX;
+	stailq_create(&writer->batch);
+	writer->batch_len = 0;
+	ev_timer_init(&writer->batch_timer, wal_batch_timer_cb, 0, 0);
+	writer->batch_timer.data = writer;
+
+	writer->stat_batches = 0;
+	writer->stat_requests = 0;
+	writer->stat_bytes = 0;
+	static const int64_t batch_buckets[] = {
+		1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096,
+		8192, 16384, 32768, 65536,
+	};
+	writer->batch_hist = histogram_new(batch_buckets,
+					   lengthof(batch_buckets));
+	if (writer->batch_hist == NULL ||
+	    latency_create(&writer->write_latency) != 0)
+		panic("failed to allocate WAL statistics");
+
+	/* Disabled until box.cfg.wal_cache_size is applied. */
+	wal_mem_create(&writer->mem, 0);
 }
 
 /** Destroy a WAL writer structure. */
@@ -380,6 +467,9 @@ static void
 wal_writer_destroy(struct wal_writer *writer)
 {
 	xdir_destroy(&writer->wal_dir);
+	histogram_delete(writer->batch_hist);
+	latency_destroy(&writer->write_latency);
+	wal_mem_destroy(&writer->mem);
 }
 
 /** WAL thread routine. */
@@ -522,13 +612,33 @@ wal_thread_stop()
 		wal_writer_destroy(&wal_writer_singleton);
 }
 
+static void
+wal_write_batch(struct wal_writer *writer);
+
+static int
+wal_sync_f(struct cbus_call_msg *msg)
+{
+	(void)msg;
+	wal_write_batch(&wal_writer_singleton);
+	return 0;
+}
+
 void
 wal_sync(void)
 {
 	struct wal_writer *writer = &wal_writer_singleton;
 	if (writer->wal_mode == WAL_NONE)
 		return;
-	cbus_flush(&wal_thread.wal_pipe, &wal_thread.tx_prio_pipe, NULL);
+	/*
+	 * Write the pending batch, if any. Its messages are
+	 * sent to tx before the reply, so once we are back,
+	 * all requests submitted before are complete.
+	 */
+	struct cbus_call_msg msg;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&wal_thread.wal_pipe, &wal_thread.tx_prio_pipe, &msg,
+		  wal_sync_f, NULL, TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
 }
 
 static int
@@ -536,6 +646,8 @@ wal_begin_checkpoint_f(struct cbus_call_msg *data)
 {
 	struct wal_checkpoint *msg = (struct wal_checkpoint *) data;
 	struct wal_writer *writer = &wal_writer_singleton;
+	/* The checkpoint must include all submitted requests. */
+	wal_write_batch(writer);
 	if (writer->in_rollback.route != NULL) {
 		/*
 		 * We're rolling back a failed write and so
@@ -659,6 +771,127 @@ wal_set_checkpoint_threshold(int64_t threshold)
 	fiber_set_cancellable(cancellable);
 }
 
+struct wal_set_batch_msg {
+	struct cbus_call_msg base;
+	double max_delay;
+	int64_t max_bytes;
+};
+
+static int
+wal_set_batch_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_set_batch_msg *msg = (struct wal_set_batch_msg *)data;
+	writer->batch_max_delay = msg->max_delay;
+	writer->batch_max_bytes = msg->max_bytes;
+	/* Don't keep requests waiting for the old timeout. */
+	wal_write_batch(writer);
+	return 0;
+}
+
+void
+wal_set_batch(double max_delay, int64_t max_bytes)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_set_batch_msg msg;
+	msg.max_delay = max_delay;
+	msg.max_bytes = max_bytes;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&wal_thread.wal_pipe, &wal_thread.tx_prio_pipe,
+		  &msg.base, wal_set_batch_f, NULL, TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+void
+wal_set_cache_size(int64_t size)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	wal_mem_set_max_size(&writer->mem, size);
+}
+
+struct wal_stat_msg {
+	struct cbus_call_msg base;
+	int64_t batches;
+	int64_t requests;
+	int64_t bytes;
+	int64_t batch_size[WAL_STAT_PCT_COUNT];
+	double latency[WAL_STAT_PCT_COUNT];
+};
+
+static int
+wal_stat_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_stat_msg *msg = (struct wal_stat_msg *)data;
+	msg->batches = writer->stat_batches;
+	msg->requests = writer->stat_requests;
+	msg->bytes = writer->stat_bytes;
+	for (int i = 0; i < WAL_STAT_PCT_COUNT; i++) {
+		msg->batch_size[i] = histogram_percentile(writer->batch_hist,
+							  wal_stat_pct[i]);
+		msg->latency[i] = latency_get(&writer->write_latency,
+					      wal_stat_pct[i]);
+	}
+	return 0;
+}
+
+void
+wal_stat(struct info_handler *h)
+{
+	struct wal_stat_msg msg;
+	memset(&msg, 0, sizeof(msg));
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&wal_thread.wal_pipe, &wal_thread.tx_prio_pipe,
+		  &msg.base, wal_stat_f, NULL, TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+
+	char name[16];
+	info_begin(h);
+	info_append_int(h, "batches", msg.batches);
+	info_append_int(h, "requests", msg.requests);
+	info_append_int(h, "bytes", msg.bytes);
+	info_table_begin(h, "batch_size");
+	for (int i = 0; i < WAL_STAT_PCT_COUNT; i++) {
+		snprintf(name, sizeof(name), "p%d", wal_stat_pct[i]);
+		info_append_int(h, name, msg.batch_size[i]);
+	}
+	info_table_end(h); /* batch_size */
+	info_table_begin(h, "latency");
+	for (int i = 0; i < WAL_STAT_PCT_COUNT; i++) {
+		snprintf(name, sizeof(name), "p%d", wal_stat_pct[i]);
+		info_append_double(h, name, msg.latency[i]);
+	}
+	info_table_end(h); /* latency */
+	info_end(h);
+}
+
+static int
+wal_reset_stat_f(struct cbus_call_msg *msg)
+{
+	(void)msg;
+	struct wal_writer *writer = &wal_writer_singleton;
+	writer->stat_batches = 0;
+	writer->stat_requests = 0;
+	writer->stat_bytes = 0;
+	histogram_reset(writer->batch_hist);
+	latency_reset(&writer->write_latency);
+	return 0;
+}
+
+void
+wal_reset_stat(void)
+{
+	struct cbus_call_msg msg;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&wal_thread.wal_pipe, &wal_thread.tx_prio_pipe,
+		  &msg, wal_reset_stat_f, NULL, TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
 struct wal_gc_msg
 {
 	struct cbus_call_msg base;
@@ -915,11 +1148,81 @@ wal_assign_lsn(struct wal_writer *writer, struct xrow_header **row,
 	}
 }
 
+/**
+ * Move all requests of the messages in @a batch to their
+ * rollback lists.
+ */
+static void
+wal_batch_rollback(struct stailq *batch)
+{
+	struct wal_msg *wal_msg;
+	stailq_foreach_entry(wal_msg, batch, in_batch)
+		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
+}
+
+/**
+ * Append rows of all messages in @a batch, which have just
+ * been written to disk, to the cache of recent rows.
+ * @a vclock is the WAL vclock preceding the batch.
+ */
 static void
-wal_write_to_disk(struct cmsg *msg)
+wal_mem_write_batch(struct wal_writer *writer, const struct vclock *vclock,
+		    struct stailq *batch)
+{
+	if (!wal_mem_is_used(&writer->mem)) {
+		/*
+		 * Nobody reads the cache, don't waste time on
+		 * encoding rows, but make sure the cache isn't
+		 * continued after the skipped rows.
+		 */
+		wal_mem_reset(&writer->mem);
+		return;
+	}
+	struct wal_msg *wal_msg;
+	struct journal_entry *entry;
+	int n_rows = 0;
+	stailq_foreach_entry(wal_msg, batch, in_batch) {
+		stailq_foreach_entry(entry, &wal_msg->commit, fifo)
+			n_rows += entry->n_rows;
+	}
+	size_t size = sizeof(struct iovec) * XROW_IOVMAX * n_rows;
+	struct iovec *iov = region_alloc(&fiber()->gc, size);
+	if (iov == NULL) {
+		diag_set(OutOfMemory, size, "region", "struct iovec");
+		goto error;
+	}
+	int iovcnt = 0;
+	stailq_foreach_entry(wal_msg, batch, in_batch) {
+		stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
+			for (int i = 0; i < entry->n_rows; i++) {
+				int rc = xrow_to_iovec(entry->rows[i],
+						       iov + iovcnt);
+				if (rc < 0)
+					goto error;
+				iovcnt += rc;
+			}
+		}
+	}
+	if (wal_mem_append(&writer->mem, vclock, iov, iovcnt) == 0)
+		return;
+error:
+	/*
+	 * The cache must not have holes, so make relays read
+	 * the rows from disk.
+	 */
+	diag_log();
+	wal_mem_reset(&writer->mem);
+}
+
+/**
+ * Write requests of all messages in @a batch to the current
+ * WAL file. Requests that failed to be written are moved to
+ * the rollback lists of their messages.
+ */
+static void
+wal_write_batch_to_disk(struct wal_writer *writer, struct stailq *batch,
+			size_t approx_len)
 {
-	struct wal_writer *writer = &wal_writer_singleton;
-	struct wal_msg *wal_msg = (struct wal_msg *) msg;
 	struct error *error;
 
 	struct errinj *inj = errinj(ERRINJ_WAL_DELAY, ERRINJ_BOOL);
@@ -928,19 +1231,19 @@ wal_write_to_disk(struct cmsg *msg)
 
 	if (writer->in_rollback.route != NULL) {
 		/* We're rolling back a failed write. */
-		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
+		wal_batch_rollback(batch);
 		return;
 	}
 
 	/* Xlog is only rotated between queue processing  */
 	if (wal_opt_rotate(writer) != 0) {
-		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
+		wal_batch_rollback(batch);
 		return wal_writer_begin_rollback(writer);
 	}
 
 	/* Ensure there's enough disk space before writing anything. */
-	if (wal_fallocate(writer, wal_msg->approx_len) != 0) {
-		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
+	if (wal_fallocate(writer, approx_len) != 0) {
+		wal_batch_rollback(batch);
 		return wal_writer_begin_rollback(writer);
 	}
 
@@ -966,31 +1269,61 @@ wal_write_to_disk(struct cmsg *msg)
 	 */
 
 	struct xlog *l = &writer->current_wal;
+	double start = ev_monotonic_time();
+	struct vclock vclock_begin;
+	vclock_copy(&vclock_begin, &writer->vclock);
+	/* The WAL vclock after the last request known to be written. */
+	struct vclock vclock_committed;
+	vclock_copy(&vclock_committed, &writer->vclock);
 
 	/*
 	 * Iterate over requests (transactions)
 	 */
 	int rc;
+	struct wal_msg *wal_msg;
 	struct journal_entry *entry;
+	/* The last request known to be written and its message. */
+	struct wal_msg *last_committed_msg = NULL;
 	struct stailq_entry *last_committed = NULL;
-	stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
-		wal_assign_lsn(writer, entry->rows, entry->rows + entry->n_rows);
-		entry->res = vclock_sum(&writer->vclock);
-		rc = xlog_write_entry(l, entry);
-		if (rc < 0)
-			goto done;
-		if (rc > 0) {
-			writer->checkpoint_wal_size += rc;
-			last_committed = &entry->fifo;
+	int64_t n_requests = 0;
+	int64_t n_bytes = 0;
+	stailq_foreach_entry(wal_msg, batch, in_batch) {
+		stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
+			wal_assign_lsn(writer, entry->rows,
+				       entry->rows + entry->n_rows);
+			entry->res = vclock_sum(&writer->vclock);
+			rc = xlog_write_entry(l, entry);
+			if (rc < 0)
+				goto done;
+			if (rc > 0) {
+				writer->checkpoint_wal_size += rc;
+				n_bytes += rc;
+				last_committed_msg = wal_msg;
+				last_committed = &entry->fifo;
+				vclock_copy(&vclock_committed,
+					    &writer->vclock);
+			}
+			/* rc == 0: the write is buffered in xlog_tx */
+			n_requests++;
 		}
-		/* rc == 0: the write is buffered in xlog_tx */
 	}
 	rc = xlog_flush(l);
 	if (rc < 0)
 		goto done;
 
 	writer->checkpoint_wal_size += rc;
-	last_committed = stailq_last(&wal_msg->commit);
+	n_bytes += rc;
+	last_committed_msg = stailq_last_entry(batch, struct wal_msg,
+					       in_batch);
+	last_committed = stailq_last(&last_committed_msg->commit);
+
+	writer->stat_batches++;
+	writer->stat_requests += n_requests;
+	writer->stat_bytes += n_bytes;
+	histogram_collect(writer->batch_hist, n_requests);
+	latency_collect(&writer->write_latency, ev_monotonic_time() - start);
+
+	wal_mem_write_batch(writer, &vclock_begin, batch);
 
 	/*
 	 * Notify TX if the checkpoint threshold has been exceeded.
@@ -1024,25 +1357,113 @@ done:
 	/*
 	 * We need to start rollback from the first request
 	 * following the last committed request. If
-	 * last_commit_req is NULL, it means we have committed
-	 * nothing, and need to start rollback from the first
-	 * request. Otherwise we rollback from the first request.
+	 * last_committed_msg is NULL, it means we have committed
+	 * nothing, and need to roll back all requests of the batch.
 	 */
-	struct stailq rollback;
-	stailq_cut_tail(&wal_msg->commit, last_committed, &rollback);
-
-	if (!stailq_empty(&rollback)) {
-		/* Update status of the successfully committed requests. */
+	bool need_rollback = false;
+	bool is_after_last = last_committed_msg == NULL;
+	stailq_foreach_entry(wal_msg, batch, in_batch) {
+		struct stailq rollback;
+		if (wal_msg == last_committed_msg) {
+			stailq_cut_tail(&wal_msg->commit, last_committed,
+					&rollback);
+			is_after_last = true;
+		} else if (is_after_last) {
+			stailq_create(&rollback);
+			stailq_concat(&rollback, &wal_msg->commit);
+		} else {
+			continue;
+		}
+		if (stailq_empty(&rollback))
+			continue;
+		/* Update status of the requests which were not written. */
 		stailq_foreach_entry(entry, &rollback, fifo)
 			entry->res = -1;
 		/* Rollback unprocessed requests */
 		stailq_concat(&wal_msg->rollback, &rollback);
+		need_rollback = true;
+	}
+	if (need_rollback) {
+		/*
+		 * LSNs of rows received from other instances
+		 * must be assignable again when the rows are
+		 * re-applied.
+		 */
+		vclock_copy(&writer->vclock, &vclock_committed);
+		/*
+		 * Some of the rows may have reached the disk,
+		 * but not the cache.
+		 */
+		wal_mem_reset(&writer->mem);
 		wal_writer_begin_rollback(writer);
 	}
 	fiber_gc();
 	wal_notify_watchers(writer, WAL_EVENT_WRITE);
 }
 
+/**
+ * Write the pending batch to disk and send its messages
+ * back to tx in the order they were received.
+ */
+static void
+wal_write_batch(struct wal_writer *writer)
+{
+	ev_timer_stop(loop(), &writer->batch_timer);
+	if (stailq_empty(&writer->batch))
+		return;
+	struct stailq batch;
+	stailq_create(&batch);
+	stailq_concat(&batch, &writer->batch);
+	size_t approx_len = writer->batch_len;
+	writer->batch_len = 0;
+
+	wal_write_batch_to_disk(writer, &batch, approx_len);
+
+	/*
+	 * A message may be freed as soon as it is delivered
+	 * to tx, so fetch the next one before pushing.
+	 */
+	struct wal_msg *wal_msg, *next;
+	stailq_foreach_entry_safe(wal_msg, next, &batch, in_batch) {
+		cmsg_init(&wal_msg->base, wal_reply_route);
+		cpipe_push(&wal_thread.tx_prio_pipe, &wal_msg->base);
+	}
+}
+
+static void
+wal_batch_timer_cb(ev_loop *loop, ev_timer *timer, int events)
+{
+	(void)loop;
+	(void)events;
+	wal_write_batch((struct wal_writer *)timer->data);
+}
+
+static void
+wal_write_to_disk(struct cmsg *msg)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_msg *wal_msg = (struct wal_msg *) msg;
+
+	stailq_add_tail_entry(&writer->batch, wal_msg, in_batch);
+	writer->batch_len += wal_msg->approx_len;
+	/*
+	 * Group commit: unless the batch is big enough already,
+	 * give tx a chance to send more requests so that they
+	 * all get written and synced at once.
+	 */
+	if (writer->batch_max_delay > 0 &&
+	    writer->in_rollback.route == NULL &&
+	    writer->batch_len < (size_t)writer->batch_max_bytes) {
+		if (!ev_is_active(&writer->batch_timer)) {
+			ev_timer_set(&writer->batch_timer,
+				     writer->batch_max_delay, 0);
+			ev_timer_start(loop(), &writer->batch_timer);
+		}
+		return;
+	}
+	wal_write_batch(writer);
+}
+
 /** WAL thread main loop.  */
 static int
 wal_thread_f(va_list ap)
@@ -1065,6 +1486,9 @@ wal_thread_f(va_list ap)
 
 	struct wal_writer *writer = &wal_writer_singleton;
 
+	/* Don't lose requests waiting for the batch timer. */
+	wal_write_batch(writer);
+
 	/*
 	 * Create a new empty WAL on shutdown so that we don't
 	 * have to rescan the last WAL to find the instance vclock.
@@ -40,9 +40,16 @@
 struct fiber;
 struct wal_writer;
 struct tt_uuid;
+struct info_handler;
+struct wal_mem;
 
 enum wal_mode { WAL_NONE = 0, WAL_WRITE, WAL_FSYNC, WAL_MODE_MAX };
 
+enum {
+	/** Number of percentiles reported by wal_stat(). */
+	WAL_STAT_PCT_COUNT = 3,
+};
+
 /** String constants for the supported modes. */
 extern const char *wal_mode_STRS[];
 
@@ -210,6 +217,45 @@ wal_commit_checkpoint(struct wal_checkpoint *checkpoint);
 void
 wal_set_checkpoint_threshold(int64_t threshold);
 
+/**
+ * Configure group commit: the WAL thread waits up to
+ * @max_delay seconds for more requests to write them all
+ * with one write and sync, unless the requests received so
+ * far take @max_bytes or more. @max_delay = 0 disables
+ * batching.
+ */
+void
+wal_set_batch(double max_delay, int64_t max_bytes);
+
+/**
+ * Get WAL write statistics: the number of batches, requests
+ * and bytes written, and percentiles of the batch size and
+ * write latency.
+ */
+void
+wal_stat(struct info_handler *h);
+
+/**
+ * Reset WAL write statistics.
+ */
+void
+wal_reset_stat(void);
+
+/**
+ * Set the max size of the cache of recently written rows
+ * read by relays, see wal_get_mem(). 0 disables the cache.
+ */
+void
+wal_set_cache_size(int64_t size);
+
+/**
+ * Return the cache of recently written rows, which relays
+ * read instead of xlog files, or NULL if WAL is disabled.
+ * The cache may be used from any thread.
+ */
+struct wal_mem *
+wal_get_mem(void);
+
 /**
  * Remove WAL files that are not needed by consumers reading
  * rows at @vclock or newer.
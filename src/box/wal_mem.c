@@ -0,0 +1,305 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "wal_mem.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <msgpuck.h>
+
+#include "diag.h"
+#include "error.h"
+#include "tt_pthread.h"
+#include "vclock.h"
+#include "xrow.h"
+
+/** A batch of rows written to WAL at once. */
+struct wal_mem_batch {
+	/**
+	 * Link in wal_mem::batches. Empty if the batch has been
+	 * evicted from the cache.
+	 */
+	struct rlist in_mem;
+	/** Batch id, ids of consecutive batches are consecutive. */
+	int64_t id;
+	/** Number of cursors referencing this batch. */
+	int refs;
+	/** Vclock preceding the first row of the batch. */
+	struct vclock vclock;
+	/** Size of encoded rows. */
+	size_t size;
+	/** Encoded rows. */
+	char data[0];
+};
+
+void
+wal_mem_create(struct wal_mem *mem, size_t max_size)
+{
+	tt_pthread_mutex_init(&mem->mutex, NULL);
+	rlist_create(&mem->batches);
+	mem->size = 0;
+	mem->max_size = max_size;
+	mem->readers = 0;
+	mem->next_id = 0;
+}
+
+void
+wal_mem_destroy(struct wal_mem *mem)
+{
+	struct wal_mem_batch *batch, *tmp;
+	rlist_foreach_entry_safe(batch, &mem->batches, in_mem, tmp)
+		free(batch);
+	tt_pthread_mutex_destroy(&mem->mutex);
+}
+
+/** Remove the oldest batch from the cache. Call under the mutex. */
+static void
+wal_mem_evict(struct wal_mem *mem)
+{
+	assert(!rlist_empty(&mem->batches));
+	struct wal_mem_batch *batch = rlist_first_entry(&mem->batches,
+					struct wal_mem_batch, in_mem);
+	rlist_del_entry(batch, in_mem);
+	rlist_create(&batch->in_mem);
+	mem->size -= batch->size;
+	/* Referenced batches are freed by the last reader. */
+	if (batch->refs == 0)
+		free(batch);
+}
+
+void
+wal_mem_set_max_size(struct wal_mem *mem, size_t max_size)
+{
+	tt_pthread_mutex_lock(&mem->mutex);
+	mem->max_size = max_size;
+	while (mem->size > mem->max_size)
+		wal_mem_evict(mem);
+	tt_pthread_mutex_unlock(&mem->mutex);
+}
+
+void
+wal_mem_attach(struct wal_mem *mem)
+{
+	tt_pthread_mutex_lock(&mem->mutex);
+	mem->readers++;
+	tt_pthread_mutex_unlock(&mem->mutex);
+}
+
+void
+wal_mem_detach(struct wal_mem *mem)
+{
+	tt_pthread_mutex_lock(&mem->mutex);
+	assert(mem->readers > 0);
+	mem->readers--;
+	tt_pthread_mutex_unlock(&mem->mutex);
+}
+
+bool
+wal_mem_is_used(struct wal_mem *mem)
+{
+	tt_pthread_mutex_lock(&mem->mutex);
+	bool is_used = mem->readers > 0 && mem->max_size > 0;
+	tt_pthread_mutex_unlock(&mem->mutex);
+	return is_used;
+}
+
+int
+wal_mem_append(struct wal_mem *mem, const struct vclock *vclock,
+	       const struct iovec *iov, int iovcnt)
+{
+	size_t size = 0;
+	for (int i = 0; i < iovcnt; i++)
+		size += iov[i].iov_len;
+	struct wal_mem_batch *batch = malloc(sizeof(*batch) + size);
+	if (batch == NULL) {
+		diag_set(OutOfMemory, sizeof(*batch) + size,
+			 "malloc", "struct wal_mem_batch");
+		return -1;
+	}
+	batch->refs = 0;
+	vclock_copy(&batch->vclock, vclock);
+	batch->size = size;
+	char *data = batch->data;
+	for (int i = 0; i < iovcnt; i++) {
+		memcpy(data, iov[i].iov_base, iov[i].iov_len);
+		data += iov[i].iov_len;
+	}
+
+	tt_pthread_mutex_lock(&mem->mutex);
+	batch->id = mem->next_id++;
+	rlist_add_tail_entry(&mem->batches, batch, in_mem);
+	mem->size += size;
+	/* Always keep the last batch so that readers can catch up. */
+	while (mem->size > mem->max_size &&
+	       rlist_first_entry(&mem->batches, struct wal_mem_batch,
+				 in_mem) != batch)
+		wal_mem_evict(mem);
+	tt_pthread_mutex_unlock(&mem->mutex);
+	return 0;
+}
+
+void
+wal_mem_reset(struct wal_mem *mem)
+{
+	tt_pthread_mutex_lock(&mem->mutex);
+	while (!rlist_empty(&mem->batches))
+		wal_mem_evict(mem);
+	/*
+	 * Make readers positioned at the last batch notice
+	 * that the rows following it are missing.
+	 */
+	mem->next_id++;
+	tt_pthread_mutex_unlock(&mem->mutex);
+}
+
+int
+wal_mem_cursor_create(struct wal_mem *mem, struct wal_mem_cursor *cursor,
+		      const struct vclock *vclock)
+{
+	int rc = -1;
+	struct wal_mem_batch *batch;
+	tt_pthread_mutex_lock(&mem->mutex);
+	if (rlist_empty(&mem->batches))
+		goto out;
+	/*
+	 * Batch vclocks grow, so if the oldest batch follows
+	 * the given vclock, the reader lags behind the cache.
+	 */
+	batch = rlist_first_entry(&mem->batches, struct wal_mem_batch, in_mem);
+	if (vclock_compare(&batch->vclock, vclock) > 0)
+		goto out;
+	/*
+	 * Readers are usually close to the end of the cache,
+	 * so look for the newest batch that doesn't skip any
+	 * rows following the given vclock.
+	 */
+	rlist_foreach_entry_reverse(batch, &mem->batches, in_mem) {
+		if (vclock_compare(&batch->vclock, vclock) <= 0) {
+			batch->refs++;
+			cursor->batch = batch;
+			cursor->pos = batch->data;
+			cursor->next_id = batch->id + 1;
+			rc = 0;
+			break;
+		}
+	}
+out:
+	tt_pthread_mutex_unlock(&mem->mutex);
+	return rc;
+}
+
+/** Drop the reference to the batch being read by a cursor. */
+static void
+wal_mem_cursor_release(struct wal_mem *mem, struct wal_mem_cursor *cursor)
+{
+	struct wal_mem_batch *batch = cursor->batch;
+	if (batch == NULL)
+		return;
+	cursor->batch = NULL;
+	cursor->pos = NULL;
+	tt_pthread_mutex_lock(&mem->mutex);
+	assert(batch->refs > 0);
+	if (--batch->refs == 0 && rlist_empty(&batch->in_mem))
+		free(batch);
+	tt_pthread_mutex_unlock(&mem->mutex);
+}
+
+void
+wal_mem_cursor_destroy(struct wal_mem *mem, struct wal_mem_cursor *cursor)
+{
+	wal_mem_cursor_release(mem, cursor);
+}
+
+/**
+ * Advance a cursor to the batch following the one it has
+ * read last.
+ *
+ * @retval 0 Success.
+ * @retval 1 There are no more batches in the cache yet.
+ * @retval -1 The next batch has been evicted.
+ */
+static int
+wal_mem_cursor_next_batch(struct wal_mem *mem, struct wal_mem_cursor *cursor)
+{
+	wal_mem_cursor_release(mem, cursor);
+	int rc;
+	tt_pthread_mutex_lock(&mem->mutex);
+	if (cursor->next_id >= mem->next_id) {
+		rc = 1;
+		goto out;
+	}
+	rc = -1;
+	struct wal_mem_batch *batch;
+	rlist_foreach_entry_reverse(batch, &mem->batches, in_mem) {
+		if (batch->id < cursor->next_id)
+			break;
+		if (batch->id == cursor->next_id) {
+			batch->refs++;
+			cursor->batch = batch;
+			cursor->pos = batch->data;
+			cursor->next_id++;
+			rc = 0;
+			break;
+		}
+	}
+out:
+	tt_pthread_mutex_unlock(&mem->mutex);
+	return rc;
+}
+
+int
+wal_mem_cursor_next(struct wal_mem *mem, struct wal_mem_cursor *cursor,
+		    struct xrow_header *row)
+{
+	struct wal_mem_batch *batch = cursor->batch;
+	while (batch == NULL || cursor->pos == batch->data + batch->size) {
+		int rc = wal_mem_cursor_next_batch(mem, cursor);
+		if (rc != 0)
+			return rc;
+		batch = cursor->batch;
+	}
+	/* Rows are encoded by xrow_to_iovec(): length, header, body. */
+	const char *end = batch->data + batch->size;
+	const char *pos = cursor->pos;
+	if (mp_typeof(*pos) != MP_UINT || mp_check_uint(pos, end) > 0)
+		goto error;
+	uint32_t len = mp_decode_uint(&pos);
+	if (len > (size_t)(end - pos))
+		goto error;
+	end = pos + len;
+	if (xrow_header_decode(row, &pos, end) != 0)
+		return -1;
+	cursor->pos = end;
+	return 0;
+error:
+	diag_set(ClientError, ER_INVALID_MSGPACK, "WAL cache row");
+	return -1;
+}
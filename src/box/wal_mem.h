@@ -0,0 +1,181 @@
+#ifndef TARANTOOL_BOX_WAL_MEM_H_INCLUDED
+#define TARANTOOL_BOX_WAL_MEM_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <small/rlist.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct vclock;
+struct xrow_header;
+struct wal_mem_batch;
+
+/**
+ * In-memory cache of recently written WAL rows.
+ *
+ * The WAL thread appends every batch of rows it writes to
+ * disk to the cache, encoded the same way rows are sent over
+ * the network. Replication relays running in their own threads
+ * read rows from the cache instead of re-reading and decoding
+ * xlog files as long as they don't lag behind the cache.
+ *
+ * The cache is a list of immutable reference counted batches.
+ * The oldest batches are evicted when the cache size exceeds
+ * the limit; an evicted batch is freed when the last reader
+ * referencing it is done with it.
+ *
+ * Rows are only cached while there are readers attached to
+ * the cache, see wal_mem_is_used().
+ */
+struct wal_mem {
+	/** Protects all members below and batch reference counters. */
+	pthread_mutex_t mutex;
+	/** Cached batches, oldest first. */
+	struct rlist batches;
+	/** Total size of cached batches. */
+	size_t size;
+	/** Max size of cached batches, 0 disables the cache. */
+	size_t max_size;
+	/** Number of attached readers. */
+	int readers;
+	/** Id that will be assigned to the next appended batch. */
+	int64_t next_id;
+};
+
+/** A position of a reader in the cache. */
+struct wal_mem_cursor {
+	/** Referenced batch being read or NULL. */
+	struct wal_mem_batch *batch;
+	/** Position of the next row in the batch. */
+	const char *pos;
+	/** Id of the batch to read after the current one. */
+	int64_t next_id;
+};
+
+/** Initialize a cache holding up to @a max_size bytes. */
+void
+wal_mem_create(struct wal_mem *mem, size_t max_size);
+
+/** Free a cache. Must not be called while readers are running. */
+void
+wal_mem_destroy(struct wal_mem *mem);
+
+/**
+ * Change the max size of a cache, evicting the oldest batches
+ * if needed. 0 disables the cache.
+ */
+void
+wal_mem_set_max_size(struct wal_mem *mem, size_t max_size);
+
+/** Register a reader of a cache. */
+void
+wal_mem_attach(struct wal_mem *mem);
+
+/** Unregister a reader of a cache. */
+void
+wal_mem_detach(struct wal_mem *mem);
+
+/**
+ * Return true if rows written to WAL should be appended to
+ * the cache, i.e. the cache is enabled and has readers.
+ * Otherwise the writer must call wal_mem_reset() instead.
+ */
+bool
+wal_mem_is_used(struct wal_mem *mem);
+
+/**
+ * Append rows written to WAL to the cache.
+ *
+ * @param mem Cache.
+ * @param vclock Vclock preceding the first row.
+ * @param iov Rows encoded with xrow_to_iovec().
+ * @param iovcnt Number of elements in @a iov.
+ *
+ * @retval 0 Success.
+ * @retval -1 Memory allocation error, diag is set.
+ */
+int
+wal_mem_append(struct wal_mem *mem, const struct vclock *vclock,
+	       const struct iovec *iov, int iovcnt);
+
+/**
+ * Drop all cached rows, e.g. because the WAL failed to write
+ * some rows or didn't append them, so the cache can't be
+ * continued. Readers will have to fall back on reading xlog
+ * files.
+ */
+void
+wal_mem_reset(struct wal_mem *mem);
+
+/**
+ * Position a cursor so that it returns all rows following
+ * @a vclock.
+ *
+ * The cursor may return rows preceding @a vclock as well,
+ * it's up to the caller to skip them.
+ *
+ * @retval 0 Success.
+ * @retval -1 The cache doesn't have all rows following
+ *            @a vclock.
+ */
+int
+wal_mem_cursor_create(struct wal_mem *mem, struct wal_mem_cursor *cursor,
+		      const struct vclock *vclock);
+
+/** Release a cursor. */
+void
+wal_mem_cursor_destroy(struct wal_mem *mem, struct wal_mem_cursor *cursor);
+
+/**
+ * Fetch the next row from the cache. The row body is valid
+ * until the next call or until the cursor is destroyed.
+ *
+ * @retval 0 Success.
+ * @retval 1 No more rows yet.
+ * @retval -1 The rows following the cursor position have
+ *            been evicted from the cache or are corrupted.
+ */
+int
+wal_mem_cursor_next(struct wal_mem *mem, struct wal_mem_cursor *cursor,
+		    struct xrow_header *row);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_WAL_MEM_H_INCLUDED */
@@ -0,0 +1,335 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "xlog_reader.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <small/region.h>
+#include <small/rlist.h>
+
+#include "cbus.h"
+#include "diag.h"
+#include "fiber.h"
+#include "fiber_cond.h"
+#include "xlog.h"
+#include "xrow.h"
+
+enum {
+	/** Number of batches travelling between tx and the reader. */
+	XLOG_READER_BATCH_COUNT = 4,
+	/** Max number of rows in a batch. */
+	XLOG_READER_BATCH_ROWS = 4096,
+	/** Max size of row bodies stored in a batch. */
+	XLOG_READER_BATCH_SIZE = 4 * 1024 * 1024,
+};
+
+/**
+ * A batch of rows read by the reader thread. Batches travel
+ * in a loop: tx sends an empty batch to the reader thread,
+ * which fills it with rows and returns it back to tx.
+ */
+struct xlog_reader_batch {
+	struct cmsg base;
+	/** Reader this batch belongs to. */
+	struct xlog_reader *reader;
+	/** Rows read from the file. */
+	struct xrow_header *rows;
+	/** Number of rows in the batch. */
+	int row_count;
+	/** Position of the next row to return to the caller. */
+	int pos;
+	/**
+	 * Memory for row bodies. Allocated and freed in the
+	 * reader thread.
+	 */
+	struct region region;
+	/**
+	 * Status of the reader after the last row of this
+	 * batch: 0 if there are more rows, 1 on end of file,
+	 * -1 on error.
+	 */
+	int rc;
+	/** Error that stopped the reader, if rc is -1. */
+	struct diag diag;
+	/** Link in xlog_reader::ready. */
+	struct rlist in_ready;
+};
+
+struct xlog_reader {
+	/** Name of the file to read. */
+	char filename[PATH_MAX];
+	/** Skip corrupted rows instead of failing. */
+	bool force_recovery;
+	/** Reader thread. */
+	struct cord cord;
+	/** Pipe from tx to the reader thread. */
+	struct cpipe reader_pipe;
+	/** Pipe from the reader thread to tx. */
+	struct cpipe tx_pipe;
+	/** Cursor used by the reader thread. */
+	struct xlog_cursor cursor;
+	/** True if the cursor was opened. Reader thread only. */
+	bool is_open;
+	/**
+	 * True if the reader thread has reached the end of
+	 * file or failed. Reader thread only.
+	 */
+	bool is_done;
+	/** True if the EOF marker was found. */
+	bool is_eof;
+	/** Route of a batch: fill in the reader, return to tx. */
+	struct cmsg_hop route[2];
+	/** All batches of this reader. */
+	struct xlog_reader_batch batches[XLOG_READER_BATCH_COUNT];
+	/** Filled batches returned to tx, in file order. */
+	struct rlist ready;
+	/** Batch rows are currently returned from. */
+	struct xlog_reader_batch *current;
+	/** Number of batches sent to the reader thread. */
+	int in_flight;
+	/** Signalled when a batch returns to tx. */
+	struct fiber_cond cond;
+};
+
+/** Fill a batch with rows. Runs in the reader thread. */
+static void
+xlog_reader_fill_f(struct cmsg *m)
+{
+	struct xlog_reader_batch *batch = (struct xlog_reader_batch *) m;
+	struct xlog_reader *reader = batch->reader;
+
+	region_free(&batch->region);
+	batch->row_count = 0;
+	batch->pos = 0;
+	batch->rc = 0;
+	if (reader->is_done) {
+		batch->rc = 1;
+		return;
+	}
+	if (!reader->is_open) {
+		if (xlog_cursor_open(&reader->cursor, reader->filename) != 0)
+			goto error;
+		reader->is_open = true;
+	}
+	while (batch->row_count < XLOG_READER_BATCH_ROWS &&
+	       region_used(&batch->region) < XLOG_READER_BATCH_SIZE) {
+		struct xrow_header *row = &batch->rows[batch->row_count];
+		int rc = xlog_cursor_next(&reader->cursor, row,
+					  reader->force_recovery);
+		if (rc < 0)
+			goto error;
+		if (rc > 0) {
+			reader->is_eof = xlog_cursor_is_eof(&reader->cursor);
+			reader->is_done = true;
+			batch->rc = 1;
+			return;
+		}
+		/*
+		 * Row bodies point to the cursor buffer, which
+		 * is reused for the next tx block. Copy them.
+		 */
+		for (int i = 0; i < row->bodycnt; i++) {
+			size_t len = row->body[i].iov_len;
+			void *body = region_alloc(&batch->region, len);
+			if (body == NULL) {
+				diag_set(OutOfMemory, len, "region",
+					 "xlog row body");
+				goto error;
+			}
+			memcpy(body, row->body[i].iov_base, len);
+			row->body[i].iov_base = body;
+		}
+		batch->row_count++;
+	}
+	return;
+error:
+	reader->is_done = true;
+	diag_move(diag_get(), &batch->diag);
+	batch->rc = -1;
+}
+
+/** Accept a filled batch. Runs in tx. */
+static void
+xlog_reader_ready_f(struct cmsg *m)
+{
+	struct xlog_reader_batch *batch = (struct xlog_reader_batch *) m;
+	struct xlog_reader *reader = batch->reader;
+	assert(reader->in_flight > 0);
+	reader->in_flight--;
+	rlist_add_tail_entry(&reader->ready, batch, in_ready);
+	fiber_cond_signal(&reader->cond);
+}
+
+/** Send a batch to the reader thread to be filled. */
+static void
+xlog_reader_send(struct xlog_reader *reader, struct xlog_reader_batch *batch)
+{
+	cmsg_init(&batch->base, reader->route);
+	reader->in_flight++;
+	cpipe_push(&reader->reader_pipe, &batch->base);
+}
+
+/** Reader thread function. */
+static int
+xlog_reader_f(va_list ap)
+{
+	struct xlog_reader *reader = va_arg(ap, struct xlog_reader *);
+
+	for (int i = 0; i < XLOG_READER_BATCH_COUNT; i++)
+		region_create(&reader->batches[i].region, &cord()->slabc);
+
+	cpipe_create(&reader->tx_pipe, "tx");
+
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, cord_name(cord()),
+			     fiber_schedule_cb, fiber());
+
+	cbus_loop(&endpoint);
+
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	cpipe_destroy(&reader->tx_pipe);
+
+	if (reader->is_open)
+		xlog_cursor_close(&reader->cursor, false);
+	for (int i = 0; i < XLOG_READER_BATCH_COUNT; i++)
+		region_destroy(&reader->batches[i].region);
+	return 0;
+}
+
+struct xlog_reader *
+xlog_reader_new(const char *filename, bool force_recovery)
+{
+	struct xlog_reader *reader = calloc(1, sizeof(*reader));
+	if (reader == NULL) {
+		diag_set(OutOfMemory, sizeof(*reader), "calloc",
+			 "struct xlog_reader");
+		return NULL;
+	}
+	snprintf(reader->filename, sizeof(reader->filename), "%s", filename);
+	reader->force_recovery = force_recovery;
+	rlist_create(&reader->ready);
+	fiber_cond_create(&reader->cond);
+
+	reader->route[0].f = xlog_reader_fill_f;
+	reader->route[0].pipe = &reader->tx_pipe;
+	reader->route[1].f = xlog_reader_ready_f;
+	reader->route[1].pipe = NULL;
+
+	for (int i = 0; i < XLOG_READER_BATCH_COUNT; i++) {
+		struct xlog_reader_batch *batch = &reader->batches[i];
+		batch->reader = reader;
+		diag_create(&batch->diag);
+		batch->rows = malloc(XLOG_READER_BATCH_ROWS *
+				     sizeof(*batch->rows));
+		if (batch->rows == NULL) {
+			diag_set(OutOfMemory, XLOG_READER_BATCH_ROWS *
+				 sizeof(*batch->rows), "malloc",
+				 "xlog reader rows");
+			goto fail;
+		}
+	}
+
+	char name[FIBER_NAME_MAX];
+	snprintf(name, sizeof(name), "xlog_reader_%p", reader);
+	if (cord_costart(&reader->cord, name, xlog_reader_f, reader) != 0)
+		goto fail;
+	cpipe_create(&reader->reader_pipe, name);
+
+	for (int i = 0; i < XLOG_READER_BATCH_COUNT; i++)
+		xlog_reader_send(reader, &reader->batches[i]);
+	return reader;
+fail:
+	for (int i = 0; i < XLOG_READER_BATCH_COUNT; i++)
+		free(reader->batches[i].rows);
+	fiber_cond_destroy(&reader->cond);
+	free(reader);
+	return NULL;
+}
+
+void
+xlog_reader_delete(struct xlog_reader *reader)
+{
+	/*
+	 * Batch memory is owned by the reader thread, so wait
+	 * for all batches to return before stopping it.
+	 */
+	while (reader->in_flight > 0)
+		fiber_cond_wait(&reader->cond);
+
+	cbus_stop_loop(&reader->reader_pipe);
+	cpipe_destroy(&reader->reader_pipe);
+	if (cord_cojoin(&reader->cord) != 0)
+		diag_log();
+
+	for (int i = 0; i < XLOG_READER_BATCH_COUNT; i++) {
+		struct xlog_reader_batch *batch = &reader->batches[i];
+		diag_destroy(&batch->diag);
+		free(batch->rows);
+	}
+	fiber_cond_destroy(&reader->cond);
+	free(reader);
+}
+
+int
+xlog_reader_next(struct xlog_reader *reader, struct xrow_header *row)
+{
+	struct xlog_reader_batch *batch = reader->current;
+	while (batch == NULL || batch->pos >= batch->row_count) {
+		if (batch != NULL) {
+			if (batch->rc < 0) {
+				diag_move(&batch->diag, diag_get());
+				return -1;
+			}
+			if (batch->rc > 0)
+				return 1;
+			/* All rows are consumed, refill the batch. */
+			reader->current = NULL;
+			xlog_reader_send(reader, batch);
+		}
+		while (rlist_empty(&reader->ready))
+			fiber_cond_wait(&reader->cond);
+		batch = rlist_shift_entry(&reader->ready,
+					  struct xlog_reader_batch, in_ready);
+		reader->current = batch;
+	}
+	*row = batch->rows[batch->pos++];
+	return 0;
+}
+
+bool
+xlog_reader_is_eof(struct xlog_reader *reader)
+{
+	return reader->is_eof;
+}
@@ -0,0 +1,90 @@
+#ifndef TARANTOOL_BOX_XLOG_READER_H_INCLUDED
+#define TARANTOOL_BOX_XLOG_READER_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct xrow_header;
+struct xlog_reader;
+
+/**
+ * Open an xlog file for reading in a background thread.
+ *
+ * The thread reads the file, decompresses and decodes rows
+ * and passes them to the caller in batches, so that disk
+ * reads and decompression overlap with processing of rows
+ * in the tx thread.
+ *
+ * @param filename Name of the file to read.
+ * @param force_recovery Skip corrupted rows and tx blocks
+ *        instead of failing, like xlog_cursor_next() does.
+ * @retval NULL Error, diag is set.
+ */
+struct xlog_reader *
+xlog_reader_new(const char *filename, bool force_recovery);
+
+/**
+ * Stop the background thread and free the reader.
+ * Rows returned by the reader must not be used after
+ * this function is called.
+ */
+void
+xlog_reader_delete(struct xlog_reader *reader);
+
+/**
+ * Fetch the next row. May yield while waiting for the
+ * background thread.
+ *
+ * The row body stays valid until the next call.
+ *
+ * @retval 0 Success.
+ * @retval 1 End of file.
+ * @retval -1 Error, diag is set.
+ */
+int
+xlog_reader_next(struct xlog_reader *reader, struct xrow_header *row);
+
+/**
+ * Return true if the reader has reached the EOF marker of
+ * the file.
+ */
+bool
+xlog_reader_is_eof(struct xlog_reader *reader);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_XLOG_READER_H_INCLUDED */
@@ -133,6 +133,9 @@ error:
 		case IPROTO_SCHEMA_VERSION:
 			header->schema_version = mp_decode_uint(pos);
 			break;
+		case IPROTO_STREAM_ID:
+			header->stream_id = mp_decode_uint(pos);
+			break;
 		default:
 			/* unknown header */
 			mp_next(pos);
@@ -348,6 +351,27 @@ iproto_reply_vclock(struct obuf *out, const struct vclock *vclock,
 	return 0;
 }
 
+int
+iproto_reply_stmt_id(struct obuf *out, uint32_t stmt_id, uint64_t sync,
+		     uint32_t schema_version)
+{
+	size_t size = IPROTO_HEADER_LEN + mp_sizeof_map(1) +
+		      mp_sizeof_uint(IPROTO_STMT_ID) + mp_sizeof_uint(stmt_id);
+	char *buf = obuf_alloc(out, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "obuf_alloc", "buf");
+		return -1;
+	}
+	char *data = buf + IPROTO_HEADER_LEN;
+	data = mp_encode_map(data, 1);
+	data = mp_encode_uint(data, IPROTO_STMT_ID);
+	data = mp_encode_uint(data, stmt_id);
+	assert(data == buf + size);
+	iproto_header_encode(buf, IPROTO_OK, sync, schema_version,
+			     size - IPROTO_HEADER_LEN);
+	return 0;
+}
+
 int
 iproto_reply_vote(struct obuf *out, const struct ballot *ballot,
 		  uint64_t sync, uint32_t schema_version)
@@ -446,18 +470,27 @@ iproto_prepare_header(struct obuf *buf, struct obuf_svp *svp, size_t size)
 }
 
 void
-iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
-		    uint32_t schema_version, uint32_t count)
+iproto_select_header_encode(char *out, uint64_t sync,
+			    uint32_t schema_version, uint32_t count,
+			    uint32_t data_len)
 {
-	char *pos = (char *) obuf_svp_to_ptr(buf, svp);
-	iproto_header_encode(pos, IPROTO_OK, sync, schema_version,
-			        obuf_size(buf) - svp->used -
-				IPROTO_HEADER_LEN);
+	iproto_header_encode(out, IPROTO_OK, sync, schema_version,
+			     sizeof(struct iproto_body_bin) + data_len);
 
 	struct iproto_body_bin body = iproto_body_bin;
 	body.v_data_len = mp_bswap_u32(count);
 
-	memcpy(pos + IPROTO_HEADER_LEN, &body, sizeof(body));
+	memcpy(out + IPROTO_HEADER_LEN, &body, sizeof(body));
+}
+
+void
+iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
+		    uint32_t schema_version, uint32_t count)
+{
+	char *pos = (char *) obuf_svp_to_ptr(buf, svp);
+	iproto_select_header_encode(pos, sync, schema_version, count,
+				    obuf_size(buf) - svp->used -
+				    IPROTO_SELECT_HEADER_LEN);
 }
 
 int
@@ -480,10 +513,12 @@ error:
 
 	uint32_t map_size = mp_decode_map(&data);
 	request->sql_text = NULL;
+	request->stmt_id = 0;
 	request->bind = NULL;
 	for (uint32_t i = 0; i < map_size; ++i) {
 		uint8_t key = *data;
-		if (key != IPROTO_SQL_BIND && key != IPROTO_SQL_TEXT) {
+		if (key != IPROTO_SQL_BIND && key != IPROTO_SQL_TEXT &&
+		    key != IPROTO_STMT_ID) {
 			mp_check(&data, end);   /* skip the key */
 			mp_check(&data, end);   /* skip the value */
 			continue;
@@ -491,12 +526,18 @@ error:
 		const char *value = ++data;     /* skip the key */
 		if (mp_check(&data, end) != 0)  /* check the value */
 			goto error;
-		if (key == IPROTO_SQL_BIND)
+		if (key == IPROTO_SQL_BIND) {
 			request->bind = value;
-		else
+		} else if (key == IPROTO_STMT_ID) {
+			if (mp_typeof(*value) != MP_UINT)
+				goto error;
+			request->stmt_id = mp_decode_uint(&value);
+		} else {
 			request->sql_text = value;
+		}
 	}
-	if (request->sql_text == NULL) {
+	if (request->sql_text == NULL &&
+	    (row->type == IPROTO_PREPARE || request->stmt_id == 0)) {
 		diag_set(ClientError, ER_MISSING_REQUEST_FIELD,
 			 iproto_key_name(IPROTO_SQL_TEXT));
 		return -1;
@@ -69,6 +69,11 @@ struct xrow_header {
 	uint64_t sync;
 	int64_t lsn; /* LSN must be signed for correct comparison */
 	double tm;
+	/**
+	 * Id of the iproto stream the request belongs to,
+	 * 0 if none. Not persisted.
+	 */
+	uint64_t stream_id;
 
 	int bodycnt;
 	uint32_t schema_version;
@@ -417,6 +422,20 @@ void
 iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		    uint32_t schema_version, uint32_t count);
 
+/**
+ * Encode the header of a select result set to a buffer of
+ * IPROTO_SELECT_HEADER_LEN bytes.
+ * @param out Encode to.
+ * @param sync Request sync.
+ * @param schema_version Schema version.
+ * @param count Number of tuples in the result set.
+ * @param data_len Size of the tuples following the header.
+ */
+void
+iproto_select_header_encode(char *out, uint64_t sync,
+			    uint32_t schema_version, uint32_t count,
+			    uint32_t data_len);
+
 /**
  * Encode iproto header with IPROTO_OK response code.
  * @param out Encode to.
@@ -444,6 +463,21 @@ int
 iproto_reply_vclock(struct obuf *out, const struct vclock *vclock,
 		    uint64_t sync, uint32_t schema_version);
 
+/**
+ * Encode iproto header with IPROTO_OK response code and
+ * prepared statement id in the body.
+ * @param out Encode to.
+ * @param stmt_id Prepared statement id.
+ * @param sync Request sync.
+ * @param schema_version.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+iproto_reply_stmt_id(struct obuf *out, uint32_t stmt_id, uint64_t sync,
+		     uint32_t schema_version);
+
 /**
  * Encode a reply to an IPROTO_VOTE request.
  * @param out Buffer to write to.
@@ -466,16 +500,20 @@ int
 iproto_reply_error(struct obuf *out, const struct error *e, uint64_t sync,
 		   uint32_t schema_version);
 
-/** EXECUTE request. */
+/** EXECUTE and PREPARE request. */
 struct sql_request {
-	/** SQL statement text. */
+	/** SQL statement text or NULL if @a stmt_id is set. */
 	const char *sql_text;
+	/** Id of a prepared statement, 0 if not set. */
+	uint32_t stmt_id;
 	/** MessagePack array of parameters. */
 	const char *bind;
 };
 
 /**
- * Parse the EXECUTE request.
+ * Parse the EXECUTE or PREPARE request. EXECUTE takes either
+ * SQL text or an id of a prepared statement, PREPARE takes
+ * SQL text only.
  * @param row Encoded data.
  * @param[out] request Request to decode to.
  *
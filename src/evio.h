@@ -121,6 +121,22 @@ evio_service_listen(struct evio_service *service);
 void
 evio_service_stop(struct evio_service *service);
 
+/**
+ * Start accepting connections on the listening socket of
+ * @a src, which must be bound and listening, in the event loop
+ * of @a dst. The socket is not duplicated, so @a dst must be
+ * detached before @a src is stopped.
+ */
+void
+evio_service_attach(struct evio_service *dst, const struct evio_service *src);
+
+/**
+ * Stop accepting connections on an attached service. Unlike
+ * evio_service_stop() the socket is left open.
+ */
+void
+evio_service_detach(struct evio_service *service);
+
 int
 evio_socket(struct ev_io *coio, int domain, int type, int protocol);
 
@@ -128,7 +144,7 @@ void
 evio_close(ev_loop *loop, struct ev_io *evio);
 
 static inline bool
-evio_service_is_active(struct evio_service *service)
+evio_service_is_active(const struct evio_service *service)
 {
 	return service->ev.fd >= 0;
 }
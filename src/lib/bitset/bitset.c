@@ -36,6 +36,110 @@
 #include <string.h>
 #include <assert.h>
 
+/**
+ * Allocate a page. A page with non-zero \a capacity stores
+ * offsets of the bits set in a sorted array, otherwise it's
+ * a bitmap.
+ */
+static struct tt_bitset_page *
+tt_bitset_page_new(struct tt_bitset *bitset, size_t first_pos,
+		   uint32_t capacity)
+{
+	struct tt_bitset_page *page;
+	if (capacity == 0) {
+		size_t size = tt_bitset_page_alloc_size(bitset->realloc);
+		page = bitset->realloc(NULL, size);
+		if (page == NULL)
+			return NULL;
+		tt_bitset_page_create(page);
+	} else {
+		size_t size = tt_bitset_page_array_alloc_size(capacity);
+		page = bitset->realloc(NULL, size);
+		if (page == NULL)
+			return NULL;
+		memset(page, 0, sizeof(*page));
+		page->capacity = capacity;
+	}
+	page->first_pos = first_pos;
+	return page;
+}
+
+static void
+tt_bitset_page_delete(struct tt_bitset *bitset, struct tt_bitset_page *page)
+{
+	tt_bitset_page_destroy(page);
+	bitset->realloc(page, 0);
+}
+
+/**
+ * Make room for one more bit in a full array page: double its
+ * capacity or convert it to a bitmap if the array would become
+ * too big. Returns the page that replaced \a page in the tree.
+ */
+static struct tt_bitset_page *
+tt_bitset_page_grow(struct tt_bitset *bitset, struct tt_bitset_page *page)
+{
+	assert(tt_bitset_page_is_array(page));
+	assert(page->cardinality == page->capacity);
+	if (page->capacity < BITSET_PAGE_ARRAY_MAX) {
+		uint32_t capacity = page->capacity * 2;
+		if (capacity > BITSET_PAGE_ARRAY_MAX)
+			capacity = BITSET_PAGE_ARRAY_MAX;
+		/* The page may move, so it must leave the tree. */
+		tt_bitset_pages_remove(&bitset->pages, page);
+		struct tt_bitset_page *new_page = bitset->realloc(page,
+				tt_bitset_page_array_alloc_size(capacity));
+		if (new_page == NULL) {
+			tt_bitset_pages_insert(&bitset->pages, page);
+			return NULL;
+		}
+		new_page->capacity = capacity;
+		tt_bitset_pages_insert(&bitset->pages, new_page);
+		return new_page;
+	}
+	struct tt_bitset_page *new_page =
+		tt_bitset_page_new(bitset, page->first_pos, 0);
+	if (new_page == NULL)
+		return NULL;
+	void *data = tt_bitset_page_data(new_page);
+	const uint16_t *array = tt_bitset_page_array(page);
+	for (uint32_t i = 0; i < page->cardinality; i++)
+		bit_set(data, array[i]);
+	new_page->cardinality = page->cardinality;
+	tt_bitset_pages_remove(&bitset->pages, page);
+	tt_bitset_pages_insert(&bitset->pages, new_page);
+	tt_bitset_page_delete(bitset, page);
+	return new_page;
+}
+
+/**
+ * Convert a bitmap page that has become sparse back to an
+ * array page. It's only an optimization, so memory errors
+ * are ignored.
+ */
+static void
+tt_bitset_page_shrink(struct tt_bitset *bitset, struct tt_bitset_page *page)
+{
+	assert(!tt_bitset_page_is_array(page));
+	assert(page->cardinality <= BITSET_PAGE_ARRAY_MAX);
+	struct tt_bitset_page *new_page =
+		tt_bitset_page_new(bitset, page->first_pos,
+				   BITSET_PAGE_ARRAY_MAX);
+	if (new_page == NULL)
+		return;
+	uint16_t *array = tt_bitset_page_array(new_page);
+	struct bit_iterator it;
+	bit_iterator_init(&it, tt_bitset_page_data(page),
+			  BITSET_PAGE_DATA_SIZE, true);
+	size_t offset;
+	while ((offset = bit_iterator_next(&it)) != SIZE_MAX)
+		array[new_page->cardinality++] = offset;
+	assert(new_page->cardinality == page->cardinality);
+	tt_bitset_pages_remove(&bitset->pages, page);
+	tt_bitset_pages_insert(&bitset->pages, new_page);
+	tt_bitset_page_delete(bitset, page);
+}
+
 void
 tt_bitset_create(struct tt_bitset *bitset,
 		 void *(*realloc)(void *ptr, size_t size))
@@ -53,8 +157,7 @@ tt_bitset_destroy_iter_cb(tt_bitset_pages_t *t, struct tt_bitset_page *page,
 {
 	(void) t;
 	struct tt_bitset *bitset = (struct tt_bitset *) arg;
-	tt_bitset_page_destroy(page);
-	bitset->realloc(page, 0);
+	tt_bitset_page_delete(bitset, page);
 	return NULL;
 }
 
@@ -80,7 +183,7 @@ tt_bitset_test(struct tt_bitset *bitset, size_t pos)
 
 	assert(page->first_pos <= pos && pos < page->first_pos +
 	       BITSET_PAGE_DATA_SIZE * CHAR_BIT);
-	return bit_test(tt_bitset_page_data(page), pos - page->first_pos);
+	return tt_bitset_page_test(page, pos - page->first_pos);
 }
 
 int
@@ -93,25 +196,45 @@ tt_bitset_set(struct tt_bitset *bitset, size_t pos)
 	struct tt_bitset_page *page =
 		tt_bitset_pages_search(&bitset->pages, &key);
 	if (page == NULL) {
-		/* Allocate a new page */
-		size_t size = tt_bitset_page_alloc_size(bitset->realloc);
-		page = bitset->realloc(NULL, size);
+		/* Allocate a new page, it's sparse at first */
+		page = tt_bitset_page_new(bitset, key.first_pos,
+					  BITSET_PAGE_ARRAY_MIN);
 		if (page == NULL)
 			return -1;
 
-		tt_bitset_page_create(page);
-		page->first_pos = key.first_pos;
-
 		/* Insert the page into pages tree */
 		tt_bitset_pages_insert(&bitset->pages, page);
 	}
 
 	assert(page->first_pos <= pos && pos < page->first_pos +
 	       BITSET_PAGE_DATA_SIZE * CHAR_BIT);
-	bool prev = bit_set(tt_bitset_page_data(page), pos - page->first_pos);
-	if (prev) {
-		/* Value has not changed */
-		return 1;
+	size_t offset = pos - page->first_pos;
+	if (tt_bitset_page_is_array(page)) {
+		uint32_t i = tt_bitset_page_array_lower_bound(page, offset);
+		if (i < page->cardinality &&
+		    tt_bitset_page_array(page)[i] == offset) {
+			/* Value has not changed */
+			return 1;
+		}
+		if (page->cardinality == page->capacity) {
+			page = tt_bitset_page_grow(bitset, page);
+			if (page == NULL)
+				return -1;
+		}
+		if (tt_bitset_page_is_array(page)) {
+			uint16_t *array = tt_bitset_page_array(page);
+			memmove(array + i + 1, array + i,
+				(page->cardinality - i) * sizeof(*array));
+			array[i] = offset;
+		} else {
+			bit_set(tt_bitset_page_data(page), offset);
+		}
+	} else {
+		bool prev = bit_set(tt_bitset_page_data(page), offset);
+		if (prev) {
+			/* Value has not changed */
+			return 1;
+		}
 	}
 
 	bitset->cardinality++;
@@ -134,9 +257,19 @@ tt_bitset_clear(struct tt_bitset *bitset, size_t pos)
 
 	assert(page->first_pos <= pos && pos < page->first_pos +
 	       BITSET_PAGE_DATA_SIZE * CHAR_BIT);
-	bool prev = bit_clear(tt_bitset_page_data(page), pos - page->first_pos);
-	if (!prev) {
-		return 0;
+	size_t offset = pos - page->first_pos;
+	if (tt_bitset_page_is_array(page)) {
+		uint32_t i = tt_bitset_page_array_lower_bound(page, offset);
+		uint16_t *array = tt_bitset_page_array(page);
+		if (i == page->cardinality || array[i] != offset)
+			return 0;
+		memmove(array + i, array + i + 1,
+			(page->cardinality - i - 1) * sizeof(*array));
+	} else {
+		bool prev = bit_clear(tt_bitset_page_data(page), offset);
+		if (!prev) {
+			return 0;
+		}
 	}
 
 	assert(bitset->cardinality > 0);
@@ -148,8 +281,14 @@ tt_bitset_clear(struct tt_bitset *bitset, size_t pos)
 		/* Remove the page from the pages tree */
 		tt_bitset_pages_remove(&bitset->pages, page);
 		/* Free the page */
-		tt_bitset_page_destroy(page);
-		bitset->realloc(page, 0);
+		tt_bitset_page_delete(bitset, page);
+	} else if (!tt_bitset_page_is_array(page) &&
+		   page->cardinality <= BITSET_PAGE_ARRAY_MAX / 2) {
+		/*
+		 * Half of the array limit, so that a page
+		 * doesn't flip back and forth.
+		 */
+		tt_bitset_page_shrink(bitset, page);
 	}
 
 	return 1;
@@ -170,6 +309,13 @@ tt_bitset_info(struct tt_bitset *bitset, struct tt_bitset_info *info)
 	struct tt_bitset_page *page = tt_bitset_pages_first(&bitset->pages);
 	while (page != NULL) {
 		info->pages++;
+		if (tt_bitset_page_is_array(page)) {
+			info->array_pages++;
+			info->mem_size +=
+				tt_bitset_page_array_alloc_size(page->capacity);
+		} else {
+			info->mem_size += info->page_total_size;
+		}
 		cardinality_check += page->cardinality;
 		page = tt_bitset_pages_next(&bitset->pages, page);
 	}
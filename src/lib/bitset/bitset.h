@@ -41,6 +41,11 @@
  * by \a size_t position number.  Initially all bits are set to
  * false. You can use any values in range [0,SIZE_MAX).  The
  * container grows automatically.
+ *
+ * Bits are stored in pages kept in a tree. A page with a few bits
+ * set stores their offsets in a sorted array, a page with many
+ * bits set is a plain bitmap, so sparse bitsets don't waste memory
+ * on zeros.
  */
 
 #include "bit/bit.h"
@@ -69,7 +74,12 @@ extern "C" {
 struct tt_bitset_page {
 	size_t first_pos;
 	rb_node(struct tt_bitset_page) node;
-	size_t cardinality;
+	uint32_t cardinality;
+	/**
+	 * Number of bit offsets the page can store in the sorted
+	 * array or 0 if the page is a bitmap.
+	 */
+	uint32_t capacity;
 	uint8_t data[0];
 };
 
@@ -158,6 +168,10 @@ struct tt_bitset_info {
 	size_t page_total_size;
 	/** A multiplier by which an address of page data is aligned **/
 	size_t page_data_alignment;
+	/** Number of pages stored as sorted arrays of offsets */
+	size_t array_pages;
+	/** Memory used by all pages (in bytes) */
+	size_t mem_size;
 };
 
 /**
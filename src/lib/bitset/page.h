@@ -55,7 +55,15 @@ extern "C" {
 
 enum {
 	/** How many bytes to store in one page */
-	BITSET_PAGE_DATA_SIZE = 160
+	BITSET_PAGE_DATA_SIZE = 160,
+	/**
+	 * How many bits a page can store as a sorted array of
+	 * 16-bit offsets. The array must stay smaller than the
+	 * bitmap, a page with more bits set is converted to it.
+	 */
+	BITSET_PAGE_ARRAY_MAX = 64,
+	/** Initial capacity of an array page */
+	BITSET_PAGE_ARRAY_MIN = 4,
 };
 
 #if defined(ENABLE_AVX)
@@ -122,6 +130,54 @@ tt_bitset_page_create(struct tt_bitset_page *page)
 	memset(page, 0, size);
 }
 
+inline size_t
+tt_bitset_page_array_alloc_size(uint32_t capacity)
+{
+	return sizeof(struct tt_bitset_page) + capacity * sizeof(uint16_t);
+}
+
+inline bool
+tt_bitset_page_is_array(const struct tt_bitset_page *page)
+{
+	return page->capacity > 0;
+}
+
+/** Sorted offsets of the bits set in an array page */
+inline uint16_t *
+tt_bitset_page_array(struct tt_bitset_page *page)
+{
+	assert(tt_bitset_page_is_array(page));
+	return (uint16_t *) page->data;
+}
+
+/** Index of the first offset >= \a offset in an array page */
+inline uint32_t
+tt_bitset_page_array_lower_bound(struct tt_bitset_page *page, size_t offset)
+{
+	const uint16_t *array = tt_bitset_page_array(page);
+	uint32_t begin = 0;
+	uint32_t end = page->cardinality;
+	while (begin < end) {
+		uint32_t mid = begin + (end - begin) / 2;
+		if (array[mid] < offset)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	return begin;
+}
+
+/** Test bit \a offset of \a page */
+inline bool
+tt_bitset_page_test(struct tt_bitset_page *page, size_t offset)
+{
+	assert(offset < BITSET_PAGE_DATA_SIZE * CHAR_BIT);
+	if (!tt_bitset_page_is_array(page))
+		return bit_test(tt_bitset_page_data(page), offset);
+	uint32_t i = tt_bitset_page_array_lower_bound(page, offset);
+	return i < page->cardinality && tt_bitset_page_array(page)[i] == offset;
+}
+
 inline void
 tt_bitset_page_destroy(struct tt_bitset_page *page)
 {
@@ -151,6 +207,7 @@ tt_bitset_page_set_ones(struct tt_bitset_page *page)
 inline void
 tt_bitset_page_and(struct tt_bitset_page *dst, struct tt_bitset_page *src)
 {
+	assert(!tt_bitset_page_is_array(dst) && !tt_bitset_page_is_array(src));
 	tt_bitset_word_t *d = (tt_bitset_word_t *) tt_bitset_page_data(dst);
 	tt_bitset_word_t *s = (tt_bitset_word_t *) tt_bitset_page_data(src);
 
@@ -164,6 +221,14 @@ tt_bitset_page_and(struct tt_bitset_page *dst, struct tt_bitset_page *src)
 inline void
 tt_bitset_page_nand(struct tt_bitset_page *dst, struct tt_bitset_page *src)
 {
+	assert(!tt_bitset_page_is_array(dst));
+	if (tt_bitset_page_is_array(src)) {
+		void *data = tt_bitset_page_data(dst);
+		const uint16_t *array = tt_bitset_page_array(src);
+		for (uint32_t i = 0; i < src->cardinality; i++)
+			bit_clear(data, array[i]);
+		return;
+	}
 	tt_bitset_word_t *d = (tt_bitset_word_t *) tt_bitset_page_data(dst);
 	tt_bitset_word_t *s = (tt_bitset_word_t *) tt_bitset_page_data(src);
 
@@ -177,6 +242,7 @@ tt_bitset_page_nand(struct tt_bitset_page *dst, struct tt_bitset_page *src)
 inline void
 tt_bitset_page_or(struct tt_bitset_page *dst, struct tt_bitset_page *src)
 {
+	assert(!tt_bitset_page_is_array(dst) && !tt_bitset_page_is_array(src));
 	tt_bitset_word_t *d = (tt_bitset_word_t *) tt_bitset_page_data(dst);
 	tt_bitset_word_t *s = (tt_bitset_word_t *) tt_bitset_page_data(src);
 
@@ -120,6 +120,16 @@ bloom_add(struct bloom *bloom, bloom_hash_t hash);
 static bool
 bloom_maybe_has(const struct bloom *bloom, bloom_hash_t hash);
 
+/**
+ * Prefetch the block of the bloom filter that is going to be
+ * checked by bloom_maybe_has() for the given hash, so that
+ * cache misses of several filters can be overlapped.
+ * @param bloom - the bloom filter
+ * @param hash - hash of the value
+ */
+static void
+bloom_prefetch(const struct bloom *bloom, bloom_hash_t hash);
+
 /**
  * Return the expected false positive rate of a bloom filter.
  * @param bloom - the bloom filter
@@ -204,6 +214,14 @@ bloom_maybe_has(const struct bloom *bloom, bloom_hash_t hash)
 	return true;
 }
 
+static inline void
+bloom_prefetch(const struct bloom *bloom, bloom_hash_t hash)
+{
+	/* The same block as in bloom_maybe_has() */
+	bloom_hash_t pos = hash % bloom->table_size;
+	__builtin_prefetch(bloom->table + pos, 0);
+}
+
 /* }}} API definition */
 
 #if defined(__cplusplus)
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "hll.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+int
+hll_create(struct hll *hll, uint8_t precision)
+{
+	assert(precision >= HLL_MIN_PRECISION &&
+	       precision <= HLL_MAX_PRECISION);
+	hll->precision = precision;
+	hll->registers = malloc(hll_register_count(hll));
+	if (hll->registers == NULL)
+		return -1;
+	hll_reset(hll);
+	return 0;
+}
+
+void
+hll_destroy(struct hll *hll)
+{
+	free(hll->registers);
+}
+
+void
+hll_reset(struct hll *hll)
+{
+	uint32_t count = hll_register_count(hll);
+	memset(hll->registers, 0, count);
+	hll->zero_count = count;
+	hll->inv_sum = count;
+}
+
+void
+hll_merge(struct hll *hll, const struct hll *src)
+{
+	assert(hll->precision == src->precision);
+	uint32_t count = hll_register_count(hll);
+	for (uint32_t i = 0; i < count; i++)
+		hll_update_register(hll, i, src->registers[i]);
+}
+
+uint64_t
+hll_estimate(const struct hll *hll)
+{
+	double m = hll_register_count(hll);
+	double alpha;
+	switch (hll->precision) {
+	case 4:
+		alpha = 0.673;
+		break;
+	case 5:
+		alpha = 0.697;
+		break;
+	case 6:
+		alpha = 0.709;
+		break;
+	default:
+		alpha = 0.7213 / (1 + 1.079 / m);
+		break;
+	}
+	double estimate = alpha * m * m / hll->inv_sum;
+	/* Raw estimates are strongly biased for small cardinalities. */
+	if (estimate <= 2.5 * m && hll->zero_count != 0)
+		estimate = m * log(m / hll->zero_count);
+	return (uint64_t)(estimate + 0.5);
+}
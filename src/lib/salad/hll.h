@@ -0,0 +1,157 @@
+#ifndef TARANTOOL_LIB_SALAD_HLL_H_INCLUDED
+#define TARANTOOL_LIB_SALAD_HLL_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * HyperLogLog cardinality estimator:
+ *  Flajolet, P.; Fusy, E.; Gandouet, O.; Meunier, F. (2007),
+ *  "HyperLogLog: the analysis of a near-optimal cardinality
+ *  estimation algorithm"
+ * Small cardinalities are estimated with linear counting as
+ * suggested in
+ *  Heule, S.; Nunkesser, M.; Hall, A. (2013),
+ *  "HyperLogLog in Practice: Algorithmic Engineering of a State
+ *  of The Art Cardinality Estimation Algorithm"
+ *
+ * The standard error of an estimate is about 1.04 / sqrt(m),
+ * where m = 2^precision is the number of registers.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bit/bit.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+enum {
+	HLL_MIN_PRECISION = 4,
+	HLL_MAX_PRECISION = 16,
+};
+
+struct hll {
+	/** Number of hash bits used to select a register. */
+	uint8_t precision;
+	/** Number of registers equal to zero. */
+	uint32_t zero_count;
+	/**
+	 * Sum of 2^-value over all registers, maintained on
+	 * update so that estimation is O(1).
+	 */
+	double inv_sum;
+	/** 2^precision registers. */
+	uint8_t *registers;
+};
+
+/**
+ * Allocate and initialize an estimator.
+ *
+ * @param hll - structure to initialize
+ * @param precision - number of registers, log2
+ * @return 0 - OK, -1 - memory error
+ */
+int
+hll_create(struct hll *hll, uint8_t precision);
+
+/**
+ * Free resources of an estimator.
+ */
+void
+hll_destroy(struct hll *hll);
+
+/**
+ * Forget all values added to an estimator.
+ */
+void
+hll_reset(struct hll *hll);
+
+/**
+ * Number of registers of an estimator.
+ */
+static inline uint32_t
+hll_register_count(const struct hll *hll)
+{
+	return 1U << hll->precision;
+}
+
+/**
+ * Set a register to a new value if it is greater than
+ * the current one.
+ */
+static inline void
+hll_update_register(struct hll *hll, uint32_t idx, uint8_t value)
+{
+	uint8_t old = hll->registers[idx];
+	if (value <= old)
+		return;
+	if (old == 0)
+		hll->zero_count--;
+	hll->inv_sum += 1.0 / ((uint64_t)1 << value) -
+			1.0 / ((uint64_t)1 << old);
+	hll->registers[idx] = value;
+}
+
+/**
+ * Add a value to an estimator.
+ *
+ * @param hll - the estimator
+ * @param hash - 64-bit hash of the value
+ */
+static inline void
+hll_add(struct hll *hll, uint64_t hash)
+{
+	uint32_t idx = hash >> (64 - hll->precision);
+	uint64_t rest = hash << hll->precision;
+	uint8_t rank = rest == 0 ? 64 - hll->precision + 1 :
+			bit_clz_u64(rest) + 1;
+	hll_update_register(hll, idx, rank);
+}
+
+/**
+ * Add all values added to @a src to @a hll.
+ * The estimators must have the same precision.
+ */
+void
+hll_merge(struct hll *hll, const struct hll *src);
+
+/**
+ * Estimate the number of distinct values added to an estimator.
+ */
+uint64_t
+hll_estimate(const struct hll *hll);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_LIB_SALAD_HLL_H_INCLUDED */
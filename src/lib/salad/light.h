@@ -92,6 +92,15 @@
 #error "LIGHT_EQUAL_KEY must be defined"
 #endif
 
+/**
+ * Optional data comparing function used by lookups in a read
+ * view, see LIGHT(view). Takes the same parameters as
+ * LIGHT_EQUAL_KEY and is used instead of it, since read views
+ * may be searched from other threads, where LIGHT_EQUAL_KEY
+ * might be unsafe to call.
+ * #define LIGHT_VIEW_EQUAL_KEY(a, b, garb) a == b
+ */
+
 /**
  * Tools for name substitution:
  */
@@ -171,6 +180,28 @@ struct LIGHT(iterator) {
 	struct matras_view view;
 };
 
+/**
+ * Read view of a hash table: a frozen state of the table that
+ * can be searched by key. Further modifications of the table
+ * copy the memory they touch instead of changing it in place,
+ * so the memory of a view is never changed, and a view can be
+ * searched from any thread without locks while the table is
+ * being modified. A view must be created and destroyed in the
+ * thread that modifies the table.
+ */
+struct LIGHT(view) {
+	/* count of values in hash table */
+	uint32_t count;
+	/* size of hash table */
+	uint32_t table_size;
+	/* cover_mask of hash table */
+	uint32_t cover_mask;
+	/* parameter for data comparison, copied from the table */
+	LIGHT_CMP_ARG_TYPE arg;
+	/* Version of matras memory */
+	struct matras_view view;
+};
+
 /**
  * Type of functions for memory allocation and deallocation
  */
@@ -375,18 +406,26 @@ LIGHT(destroy)(struct LIGHT(core) *ht)
 
 /**
  * Find a slot (index in the hash table), where an item with
- * given hash should be placed.
+ * given hash should be placed, in a table of given size.
  */
 static inline uint32_t
-LIGHT(slot)(const struct LIGHT(core) *ht, uint32_t hash)
+LIGHT(slot_in)(uint32_t cover_mask, uint32_t table_size, uint32_t hash)
 {
-	uint32_t cover_mask = ht->cover_mask;
 	uint32_t res = hash & cover_mask;
-	uint32_t probe = (ht->table_size - res - 1) >> 31;
+	uint32_t probe = (table_size - res - 1) >> 31;
 	uint32_t shift = __builtin_ctz(~(cover_mask >> 1));
 	res ^= (probe << shift);
 	return res;
+}
 
+/**
+ * Find a slot (index in the hash table), where an item with
+ * given hash should be placed.
+ */
+static inline uint32_t
+LIGHT(slot)(const struct LIGHT(core) *ht, uint32_t hash)
+{
+	return LIGHT(slot_in)(ht->cover_mask, ht->table_size, hash);
 }
 
 /**
@@ -1057,6 +1096,94 @@ LIGHT(iterator_destroy)(struct LIGHT(core) *ht, struct LIGHT(iterator) *itr)
 	matras_destroy_read_view(&ht->mtable, &itr->view);
 }
 
+/**
+ * @brief Create a read view of a hash table. The view must be
+ * destroyed with light_view_destroy after usage.
+ * @param ht - pointer to a hash table struct
+ * @param view - view to create
+ */
+static inline void
+LIGHT(view_create)(struct LIGHT(core) *ht, struct LIGHT(view) *view)
+{
+	view->count = ht->count;
+	view->table_size = ht->table_size;
+	view->cover_mask = ht->cover_mask;
+	view->arg = ht->arg;
+	matras_create_read_view(&ht->mtable, &view->view);
+}
+
+/**
+ * @brief Destroy a read view of a hash table.
+ * @param ht - pointer to a hash table struct
+ * @param view - view to destroy
+ */
+static inline void
+LIGHT(view_destroy)(struct LIGHT(core) *ht, struct LIGHT(view) *view)
+{
+	matras_destroy_read_view(&ht->mtable, &view->view);
+}
+
+/**
+ * @brief Find a record with given hash and key in a read view.
+ * Can be called from any thread.
+ * @param ht - pointer to a hash table struct
+ * @param view - read view to search in
+ * @param hash - hash to find
+ * @param key - key to find
+ * @return integer ID of found record or light_end if nothing found
+ */
+static inline uint32_t
+LIGHT(view_find_key)(const struct LIGHT(core) *ht,
+		     const struct LIGHT(view) *view,
+		     uint32_t hash, LIGHT_KEY_TYPE key)
+{
+	if (view->count == 0)
+		return LIGHT(end);
+	uint32_t slot = LIGHT(slot_in)(view->cover_mask, view->table_size,
+				       hash);
+	struct LIGHT(record) *record = (struct LIGHT(record) *)
+		matras_view_get(&ht->mtable, &view->view, slot);
+	if (record->next == slot)
+		return LIGHT(end);
+	while (1) {
+#ifdef LIGHT_VIEW_EQUAL_KEY
+		if (record->hash == hash &&
+		    LIGHT_VIEW_EQUAL_KEY((record->value), (key), (view->arg)))
+			return slot;
+#else
+		if (record->hash == hash &&
+		    LIGHT_EQUAL_KEY((record->value), (key), (view->arg)))
+			return slot;
+#endif
+		slot = record->next;
+		if (slot == LIGHT(end))
+			return LIGHT(end);
+		record = (struct LIGHT(record) *)
+			matras_view_get(&ht->mtable, &view->view, slot);
+	}
+	/* unreachable */
+	return LIGHT(end);
+}
+
+/**
+ * @brief Get a value from a read view by its ID.
+ * Can be called from any thread.
+ * @param ht - pointer to a hash table struct
+ * @param view - read view
+ * @param slotpos - ID of a record, returned by light_view_find_key
+ * @return the value
+ */
+static inline LIGHT_DATA_TYPE
+LIGHT(view_get)(const struct LIGHT(core) *ht, const struct LIGHT(view) *view,
+		uint32_t slotpos)
+{
+	assert(slotpos < view->table_size);
+	struct LIGHT(record) *record = (struct LIGHT(record) *)
+		matras_view_get(&ht->mtable, &view->view, slotpos);
+	assert(record->next != slotpos);
+	return record->value;
+}
+
 /*
  * Selfcheck of the internal state of hash table. Used only for debugging.
  * That means that you should not use this function.
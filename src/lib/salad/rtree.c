@@ -34,6 +34,7 @@
 #include <limits.h>
 #include <stddef.h>
 #include <sys/types.h>
+#include <third_party/qsort_arg.h>
 
 /*------------------------------------------------------------------------- */
 /* R-tree internal structures definition */
@@ -347,6 +348,7 @@ rtree_page_alloc(struct rtree *tree)
 		struct rtree_page *result =
 			(struct rtree_page *)tree->free_pages;
 		tree->free_pages = *(void **)tree->free_pages;
+		tree->n_free_pages--;
 		return result;
 	} else {
 		uint32_t unused_id;
@@ -360,6 +362,7 @@ rtree_page_free(struct rtree *tree, struct rtree_page *page)
 {
 	*(void **)page = tree->free_pages;
 	tree->free_pages = (void *)page;
+	tree->n_free_pages++;
 }
 
 static struct rtree_page_branch *
@@ -951,6 +954,7 @@ rtree_init(struct rtree *tree, unsigned dimension, uint32_t extent_size,
 	tree->version = 0;
 	tree->n_pages = 0;
 	tree->free_pages = 0;
+	tree->n_free_pages = 0;
 
 	tree->dimension = dimension;
 	tree->distance_type = distance_type;
@@ -1006,6 +1010,178 @@ rtree_insert(struct rtree *tree, struct rtree_rect *rect, record_t obj)
 	tree->n_records++;
 }
 
+size_t
+rtree_bulk_entry_size(const struct rtree *tree)
+{
+	return tree->page_branch_size;
+}
+
+static struct rtree_page_branch *
+rtree_bulk_entry_get(const struct rtree *tree, void *entries, size_t i)
+{
+	return (struct rtree_page_branch *)
+		((char *)entries + i * tree->page_branch_size);
+}
+
+void
+rtree_bulk_entry_set(const struct rtree *tree, void *entries, size_t i,
+		     const struct rtree_rect *rect, record_t obj)
+{
+	struct rtree_page_branch *b = rtree_bulk_entry_get(tree, entries, i);
+	b->data.record = obj;
+	rtree_rect_copy(&b->rect, rect, tree->dimension);
+}
+
+/* Compare centers of branches along the axis passed in arg */
+static int
+rtree_bulk_entry_cmp(const void *a, const void *b, void *arg)
+{
+	unsigned axis = *(unsigned *)arg;
+	const coord_t *ca = ((const struct rtree_page_branch *)a)->rect.coords;
+	const coord_t *cb = ((const struct rtree_page_branch *)b)->rect.coords;
+	coord_t sa = ca[2 * axis] + ca[2 * axis + 1];
+	coord_t sb = cb[2 * axis] + cb[2 * axis + 1];
+	return sa < sb ? -1 : sa > sb ? 1 : 0;
+}
+
+/* Smallest number of slabs s such that s ^ dims >= n_pages */
+static size_t
+rtree_bulk_slab_count(size_t n_pages, unsigned dims)
+{
+	for (size_t s = 1; ; s++) {
+		size_t p = 1;
+		for (unsigned i = 0; i < dims && p < n_pages; i++)
+			p *= s;
+		if (p >= n_pages)
+			return s;
+	}
+}
+
+/* Number of pages to pack count branches into */
+static size_t
+rtree_bulk_page_count(const struct rtree *tree, size_t count)
+{
+	return (count + tree->page_max_fill - 1) / tree->page_max_fill;
+}
+
+/*
+ * Index of the first of count branches that go to the page i of
+ * n_pages. The branches are spread evenly, so that every page is
+ * at least half full.
+ */
+static size_t
+rtree_bulk_page_begin(size_t count, size_t n_pages, size_t i)
+{
+	return count * i / n_pages;
+}
+
+/*
+ * Order branches so that the pages of a level packed by
+ * rtree_bulk_pack_level() are Sort-Tile-Recursive tiles: sort
+ * the branches of pages [first_page, last_page) along an axis,
+ * cut them into slabs of whole pages and sort each slab the same
+ * way along the next axis.
+ */
+static void
+rtree_bulk_sort(const struct rtree *tree, void *entries, size_t count,
+		size_t first_page, size_t last_page, unsigned axis)
+{
+	size_t n_pages = rtree_bulk_page_count(tree, count);
+	size_t begin = rtree_bulk_page_begin(count, n_pages, first_page);
+	size_t end = rtree_bulk_page_begin(count, n_pages, last_page);
+	qsort_arg(rtree_bulk_entry_get(tree, entries, begin), end - begin,
+		  tree->page_branch_size, rtree_bulk_entry_cmp, &axis);
+	size_t slab_pages = last_page - first_page;
+	if (axis + 1 == tree->dimension || slab_pages <= 1)
+		return;
+	size_t n_slabs = rtree_bulk_slab_count(slab_pages,
+					       tree->dimension - axis);
+	slab_pages = (slab_pages + n_slabs - 1) / n_slabs;
+	for (size_t i = first_page; i < last_page; i += slab_pages) {
+		size_t last = last_page - i < slab_pages ?
+			      last_page : i + slab_pages;
+		rtree_bulk_sort(tree, entries, count, i, last, axis + 1);
+	}
+}
+
+/*
+ * Pack ordered branches into pages of one level. The branches
+ * pointing to the new pages replace the first entries of the
+ * array. Returns the number of pages.
+ */
+static size_t
+rtree_bulk_pack_level(struct rtree *tree, void *entries, size_t count)
+{
+	size_t n_pages = rtree_bulk_page_count(tree, count);
+	size_t begin = 0;
+	for (size_t i = 0; i < n_pages; i++) {
+		size_t end = rtree_bulk_page_begin(count, n_pages, i + 1);
+		struct rtree_page *page = rtree_page_alloc(tree);
+		/* Reserved by rtree_bulk_reserve(). */
+		assert(page != NULL);
+		tree->n_pages++;
+		page->n = end - begin;
+		for (size_t j = begin; j < end; j++) {
+			rtree_branch_copy(rtree_branch_get(tree, page,
+							   j - begin),
+					  rtree_bulk_entry_get(tree, entries, j),
+					  tree->dimension);
+		}
+		/* Entry i belongs to this or a previous page. */
+		struct rtree_page_branch *b =
+			rtree_bulk_entry_get(tree, entries, i);
+		b->data.page = page;
+		rtree_page_cover(tree, page, &b->rect);
+		begin = end;
+	}
+	return n_pages;
+}
+
+int
+rtree_bulk_reserve(struct rtree *tree, size_t count)
+{
+	size_t n_pages = 0;
+	size_t n = count;
+	do {
+		n = rtree_bulk_page_count(tree, n);
+		n_pages += n;
+	} while (n > 1);
+	while (tree->n_free_pages < n_pages) {
+		uint32_t unused_id;
+		struct rtree_page *page = (struct rtree_page *)
+			matras_alloc(&tree->mtab, &unused_id);
+		if (page == NULL)
+			return -1;
+		rtree_page_free(tree, page);
+	}
+	return 0;
+}
+
+int
+rtree_bulk_load(struct rtree *tree, void *entries, size_t count)
+{
+	assert(tree->root == NULL);
+	if (count == 0)
+		return 0;
+	/* Allocate all pages first, so that packing can't fail. */
+	if (rtree_bulk_reserve(tree, count) != 0)
+		return -1;
+	unsigned height = 0;
+	size_t n = count;
+	do {
+		size_t n_pages = rtree_bulk_page_count(tree, n);
+		rtree_bulk_sort(tree, entries, n, 0, n_pages, 0);
+		n = rtree_bulk_pack_level(tree, entries, n);
+		height++;
+	} while (n > 1);
+	assert(height <= RTREE_MAX_HEIGHT);
+	tree->root = rtree_bulk_entry_get(tree, entries, 0)->data.page;
+	tree->height = height;
+	tree->n_records = count;
+	tree->version++;
+	return 0;
+}
+
 bool
 rtree_remove(struct rtree *tree, const struct rtree_rect *rect, record_t obj)
 {
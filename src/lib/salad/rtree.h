@@ -150,6 +150,8 @@ struct rtree
 	struct matras mtab;
 	/* List of free pages */
 	void *free_pages;
+	/* Number of pages in the free list */
+	unsigned n_free_pages;
 	/* Distance type */
 	enum rtree_distance_type distance_type;
 };
@@ -275,6 +277,51 @@ rtree_search(const struct rtree *tree, const struct rtree_rect *rect,
 void
 rtree_insert(struct rtree *tree, struct rtree_rect *rect, record_t obj);
 
+/**
+ * @brief Size of an element of the array passed to rtree_bulk_load()
+ * @param tree - pointer to a tree
+ */
+size_t
+rtree_bulk_entry_size(const struct rtree *tree);
+
+/**
+ * @brief Set an element of the array passed to rtree_bulk_load()
+ * @param tree - pointer to a tree
+ * @param entries - array of rtree_bulk_entry_size() sized elements
+ * @param i - index of the element to set
+ * @param rect - rectangle of the record
+ * @param obj - record
+ */
+void
+rtree_bulk_entry_set(const struct rtree *tree, void *entries, size_t i,
+		     const struct rtree_rect *rect, record_t obj);
+
+/**
+ * @brief Allocate pages for rtree_bulk_load() beforehand
+ * After a successful call loading up to count records into
+ * the empty tree can't fail.
+ * @param tree - pointer to an empty tree
+ * @param count - number of records
+ * @return 0 on success, -1 if a page allocation failed
+ */
+int
+rtree_bulk_reserve(struct rtree *tree, size_t count);
+
+/**
+ * @brief Insert many records to an empty tree at once
+ * The records are packed into full pages with Sort-Tile-Recursive
+ * algorithm, which is much faster than inserting them one by one
+ * and gives pages with less overlap.
+ * @param tree - pointer to an empty tree
+ * @param entries - records to insert, see rtree_bulk_entry_set(),
+ *  the array is used as a scratch space and spoiled
+ * @param count - number of records
+ * @return 0 on success, -1 if a page allocation failed, the tree
+ *  is left empty then
+ */
+int
+rtree_bulk_load(struct rtree *tree, void *entries, size_t count);
+
 /**
  * @brief Remove the record from a tree
  * @return true if the record deleted (false otherwise)
@@ -425,3 +425,53 @@ admin("box.schema.user.revoke('guest', 'read,write,execute', 'universe')")
 
 admin("space:drop()")
 
+
+#
+# Interactive transactions in iproto streams.
+#
+admin("space = box.schema.space.create('test_stream', { id = 569, engine = 'vinyl' })")
+admin("index = space:create_index('primary')")
+admin("box.schema.user.grant('guest', 'read,write', 'space', 'test_stream')")
+
+IPROTO_STREAM_ID = 0x0a
+REQUEST_TYPE_BEGIN = 14
+REQUEST_TYPE_COMMIT = 15
+REQUEST_TYPE_ROLLBACK = 16
+
+c = Connection('localhost', server.iproto.port)
+c.connect()
+s = c._socket
+
+def stream_request(stream_id, code, body):
+    header = { IPROTO_CODE: code, IPROTO_STREAM_ID: stream_id }
+    resp = test_request(header, body)
+    return resp['body']
+
+insert = lambda key: { IPROTO_SPACE_ID: 569, IPROTO_TUPLE: [key] }
+select = { IPROTO_SPACE_ID: 569, IPROTO_KEY: [], IPROTO_LIMIT: 100 }
+
+print 'Commit without stream id:', \
+    stream_request(0, REQUEST_TYPE_COMMIT, {})
+print 'Begin:', stream_request(1, REQUEST_TYPE_BEGIN, {})
+print 'Begin again:', stream_request(1, REQUEST_TYPE_BEGIN, {})
+print 'Insert:', stream_request(1, REQUEST_TYPE_INSERT, insert(1))
+print 'Insert:', stream_request(1, REQUEST_TYPE_INSERT, insert(2))
+print 'Select in the stream:', stream_request(1, REQUEST_TYPE_SELECT, select)
+print 'Select outside:', stream_request(0, REQUEST_TYPE_SELECT, select)
+print 'Call in a transaction:', \
+    stream_request(1, REQUEST_TYPE_CALL, { IPROTO_FUNCTION_NAME: 'kek' })
+print 'Rollback:', stream_request(1, REQUEST_TYPE_ROLLBACK, {})
+print 'Select after rollback:', stream_request(0, REQUEST_TYPE_SELECT, select)
+print 'Begin:', stream_request(2, REQUEST_TYPE_BEGIN, {})
+print 'Insert:', stream_request(2, REQUEST_TYPE_INSERT, insert(3))
+print 'Commit:', stream_request(2, REQUEST_TYPE_COMMIT, {})
+print 'Select after commit:', stream_request(0, REQUEST_TYPE_SELECT, select)
+print 'Begin:', stream_request(3, REQUEST_TYPE_BEGIN, {})
+print 'Insert:', stream_request(3, REQUEST_TYPE_INSERT, insert(4))
+
+# The transaction left open is rolled back on disconnect.
+c.close()
+admin("for i = 1, 1000 do if box.stat.vinyl().tx.transactions == 0 then break end require('fiber').sleep(0.01) end")
+admin("box.stat.vinyl().tx.transactions")
+admin("space:select()")
+admin("space:drop()")
@@ -0,0 +1,93 @@
+#!/usr/bin/env tarantool
+
+local tap = require('tap')
+local fiber = require('fiber')
+local net_box = require('net.box')
+local test = tap.test('iproto_read_threads')
+
+box.cfg{
+    listen = os.getenv('LISTEN'),
+    iproto_read_threads = 2,
+}
+
+local s = box.schema.space.create('test')
+s:create_index('pk', {type = 'hash'})
+s:create_index('sk', {type = 'hash', parts = {2, 'string'}})
+s:create_index('tk', {type = 'tree', parts = {2, 'string'}})
+box.schema.user.grant('guest', 'read,write', 'space', 'test')
+
+-- Let a new read view be created.
+local function wait_read_view()
+    fiber.sleep(0.05)
+end
+
+test:plan(14)
+
+local c1 = net_box.connect(box.cfg.listen)
+local c2 = net_box.connect(box.cfg.listen)
+
+-- A client reads its own writes.
+c1.space.test:insert{1, 'a'}
+test:is_deeply(c1.space.test:get{1}:totable(), {1, 'a'},
+               'own write is visible')
+for i = 2, 100 do
+    c1.space.test:replace{i, tostring(i)}
+end
+test:is(c1.space.test:get{100}[2], '100', 'own writes are visible')
+
+wait_read_view()
+local offloaded = box.stat.net.OFFLOADED.total
+local ok = true
+for i = 2, 100 do
+    local t = c2.space.test:get{i}
+    ok = ok and t ~= nil and t[2] == tostring(i)
+end
+test:ok(ok, 'point lookups')
+test:is(box.stat.net.OFFLOADED.total - offloaded, 99,
+        'lookups are served by readers')
+test:is(c2.space.test.index.sk:get{'a'}[1], 1, 'secondary index lookup')
+test:isnil(c2.space.test:get{1000}, 'missing key')
+test:is(#c2.space.test:select({1}, {limit = 0}), 0, 'zero limit')
+test:is(#c2.space.test:select({1}, {offset = 1}), 0, 'offset')
+test:is(#c2.space.test.index.tk:select{'a'}, 1, 'tree index lookup')
+
+local err
+ok, err = pcall(c2.space.test.get, c2.space.test, {'x'})
+test:ok(not ok and err.code == box.error.KEY_PART_TYPE, 'invalid key')
+
+-- Changes made by others are visible once a new view is taken.
+s:replace{1, 'b'}
+wait_read_view()
+test:is(c2.space.test:get{1}[2], 'b', 'changes of others are visible')
+
+-- The view is renewed without changes for a client waiting
+-- for the result of a request that changed nothing.
+c1:ping()
+wait_read_view()
+offloaded = box.stat.net.OFFLOADED.total
+c1.space.test:get{1}
+test:is(box.stat.net.OFFLOADED.total - offloaded, 1, 'view is renewed')
+
+-- Privileges are checked.
+box.schema.user.revoke('guest', 'read', 'space', 'test')
+wait_read_view()
+ok = pcall(c2.space.test.get, c2.space.test, {1})
+test:ok(not ok, 'access is checked')
+
+-- Tuples freed while a view exists are reclaimed, though
+-- views are taken one after another under load.
+local pad = string.rep('x', 1000)
+local items_used = box.slab.info().items_used
+for _ = 1, 100 do
+    for i = 1, 1000 do
+        s:replace{i, i .. pad}
+    end
+    wait_read_view()
+end
+test:ok(box.slab.info().items_used - items_used < 20 * 1024 * 1024,
+        'garbage is collected')
+
+c1:close()
+c2:close()
+s:drop()
+os.exit(test:check() == true and 0 or 1)
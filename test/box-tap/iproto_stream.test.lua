@@ -0,0 +1,116 @@
+#!/usr/bin/env tarantool
+
+local tap = require('tap')
+local fiber = require('fiber')
+local socket = require('socket')
+local msgpack = require('msgpack')
+local uri = require('uri')
+local test = tap.test('iproto_stream')
+
+box.cfg{
+    listen = os.getenv('LISTEN'),
+    memtx_use_mvcc_engine = true,
+}
+
+local s = box.schema.space.create('test')
+s:create_index('pk')
+box.schema.user.grant('guest', 'read,write', 'space', 'test')
+
+local IPROTO_CODE = 0x00
+local IPROTO_SYNC = 0x01
+local IPROTO_STREAM_ID = 0x0a
+local IPROTO_SPACE_ID = 0x10
+local IPROTO_LIMIT = 0x12
+local IPROTO_KEY = 0x20
+local IPROTO_TUPLE = 0x21
+local IPROTO_DATA = 0x30
+local IPROTO_ERROR = 0x31
+
+local IPROTO_SELECT = 1
+local IPROTO_INSERT = 2
+local IPROTO_BEGIN = 14
+local IPROTO_COMMIT = 15
+
+local function connect()
+    local parsed = uri.parse(box.cfg.listen)
+    local sock = socket.tcp_connect(parsed.host, parsed.service)
+    assert(sock ~= nil)
+    assert(#sock:read(128) == 128)
+    return sock
+end
+
+local sync = 0
+
+-- Send a request of a stream and return the response body.
+local function request(sock, stream_id, code, body)
+    sync = sync + 1
+    local header = msgpack.encode({[IPROTO_CODE] = code,
+                                   [IPROTO_SYNC] = sync,
+                                   [IPROTO_STREAM_ID] = stream_id})
+    body = msgpack.encode(body)
+    sock:write(msgpack.encode(#header + #body) .. header .. body)
+    local len = msgpack.decode(sock:read(5))
+    local data = sock:read(len)
+    local _, pos = msgpack.decode(data)
+    return (msgpack.decode(data, pos))
+end
+
+local function insert(sock, stream_id, key)
+    return request(sock, stream_id, IPROTO_INSERT,
+                   {[IPROTO_SPACE_ID] = s.id, [IPROTO_TUPLE] = {key}})
+end
+
+local function count(sock, stream_id)
+    local body = request(sock, stream_id, IPROTO_SELECT,
+                         {[IPROTO_SPACE_ID] = s.id, [IPROTO_KEY] = {},
+                          [IPROTO_LIMIT] = 100})
+    return body[IPROTO_DATA] and #body[IPROTO_DATA]
+end
+
+local function stream_count()
+    local n = 0
+    for _, f in pairs(fiber.info()) do
+        if f.name == 'iproto.stream' then
+            n = n + 1
+        end
+    end
+    return n
+end
+
+test:plan(9)
+
+local sock = connect()
+
+-- A memtx transaction may span several requests of a stream.
+request(sock, 1, IPROTO_BEGIN, {})
+insert(sock, 1, 1)
+insert(sock, 1, 2)
+test:is(count(sock, 1), 2, 'changes are visible in the stream')
+test:is(count(sock, 0), 0, 'changes are invisible outside')
+test:is(stream_count(), 1, 'stream is kept while a transaction is open')
+local body = request(sock, 1, IPROTO_COMMIT, {})
+test:is(body[IPROTO_ERROR], nil, 'commit')
+test:is(count(sock, 0), 2, 'changes are visible after commit')
+
+-- Streams without an open transaction are not kept.
+for i = 100, 1100 do
+    count(sock, i)
+end
+test:is(stream_count(), 0, 'idle streams are deleted')
+test:is(count(sock, 1), 2, 'deleted stream id can be reused')
+
+-- The transaction left open is rolled back on disconnect.
+request(sock, 2, IPROTO_BEGIN, {})
+insert(sock, 2, 3)
+sock:close()
+for _ = 1, 1000 do
+    if stream_count() == 0 then
+        break
+    end
+    fiber.sleep(0.01)
+end
+test:is(stream_count(), 0, 'stream is deleted on disconnect')
+test:is(s:get{3}, nil, 'open transaction is rolled back')
+
+s:drop()
+os.exit(test:check() == true and 0 or 1)
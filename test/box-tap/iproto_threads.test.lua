@@ -0,0 +1,83 @@
+#!/usr/bin/env tarantool
+
+local tap = require('tap')
+local fiber = require('fiber')
+local net_box = require('net.box')
+local test = tap.test('iproto_threads')
+
+box.cfg{
+    listen = os.getenv('LISTEN'),
+    iproto_threads = 4,
+    net_msg_max = 64,
+}
+
+local s = box.schema.space.create('test')
+s:create_index('pk')
+box.schema.user.grant('guest', 'read,write', 'space', 'test')
+
+test:plan(5)
+
+test:is(#box.stat.net.thread(), 4, 'thread count')
+
+local CONNECTIONS = 16
+local REQUESTS = 200
+local conns = {}
+for i = 1, CONNECTIONS do
+    conns[i] = net_box.connect(box.cfg.listen)
+end
+
+-- Change net_msg_max while network threads serve requests.
+local errors = 0
+local ch = fiber.channel(CONNECTIONS)
+for i = 1, CONNECTIONS do
+    fiber.create(function()
+        local space = conns[i].space.test
+        for j = 1, REQUESTS do
+            local ok = pcall(space.replace, space,
+                             {i * REQUESTS + j, j})
+            if not ok then
+                errors = errors + 1
+            end
+        end
+        ch:put(true)
+    end)
+end
+for _, msg_max in ipairs({2, 1000, 64, 300}) do
+    box.cfg{net_msg_max = msg_max}
+    fiber.sleep(0.01)
+end
+for _ = 1, CONNECTIONS do
+    ch:get()
+end
+test:is(errors, 0, 'no errors')
+test:is(s:len(), CONNECTIONS * REQUESTS, 'all requests are served')
+
+-- The limit is applied in every thread.
+box.cfg{net_msg_max = 2}
+local results = {}
+for i = 1, CONNECTIONS do
+    fiber.create(function()
+        results[i] = conns[i]:eval('return 1')
+        ch:put(true)
+    end)
+end
+for _ = 1, CONNECTIONS do
+    ch:get()
+end
+local ok = true
+for i = 1, CONNECTIONS do
+    ok = ok and results[i] == 1
+end
+test:ok(ok, 'requests are served with a small limit')
+
+local received = 0
+for _, stat in ipairs(box.stat.net.thread()) do
+    received = received + stat.RECEIVED.total
+end
+test:is(received, box.stat.net.RECEIVED.total, 'statistics are summed up')
+
+for i = 1, CONNECTIONS do
+    conns[i]:close()
+end
+s:drop()
+os.exit(test:check() == true and 0 or 1)
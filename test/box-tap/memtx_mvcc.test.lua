@@ -0,0 +1,71 @@
+#!/usr/bin/env tarantool
+
+local tap = require('tap')
+local fiber = require('fiber')
+local test = tap.test('memtx_mvcc')
+
+box.cfg{memtx_use_mvcc_engine = true}
+
+local s = box.schema.space.create('test')
+s:create_index('pk')
+s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+
+test:plan(12)
+
+-- A transaction may yield between statements.
+box.begin()
+s:insert{1, 10}
+fiber.sleep(0)
+s:insert{2, 20}
+test:ok(pcall(box.commit), 'commit after yield')
+test:is(s:count(), 2, 'yielding transaction is committed')
+
+-- Uncommitted changes are invisible to others.
+local ch = fiber.channel(1)
+local f = fiber.create(function()
+    box.begin()
+    s:replace{1, 11}
+    s:delete{2}
+    s:insert{3, 30}
+    ch:get()
+    box.commit()
+    ch:put(true)
+end)
+fiber.sleep(0)
+test:is(s:get{1}[2], 10, 'uncommitted replace is invisible')
+test:isnt(s:get{2}, nil, 'uncommitted delete is invisible')
+test:is(s:len(), 2, 'uncommitted insert is not counted')
+test:is(#s.index.sk:select{}, 2, 'secondary index sees committed data')
+
+-- A transaction keeps its read view.
+box.begin()
+local before = s:get{1}[2]
+ch:put(true)
+ch:get()
+test:is(s:get{1}[2], before, 'read view is kept')
+test:is(#s:select{}, 2, 'read view is kept by iterators')
+box.commit()
+test:is(#s:select{}, 2, 'changes are visible after commit')
+test:is(s:get{1}[2], 11, 'replace is visible after commit')
+
+-- The second writer of a tuple is aborted.
+local ok, err
+f = fiber.create(function()
+    box.begin()
+    s:replace{1, 12}
+    ch:get()
+    box.commit()
+    ch:put(true)
+end)
+fiber.sleep(0)
+box.begin()
+ok, err = pcall(s.replace, s, {1, 13})
+box.rollback()
+ch:put(true)
+ch:get()
+test:is(err and err.code, box.error.TRANSACTION_CONFLICT,
+        'conflicting write is aborted')
+test:is(s:get{1}[2], 12, 'first writer wins')
+
+s:drop()
+os.exit(test:check() == true and 0 or 1)
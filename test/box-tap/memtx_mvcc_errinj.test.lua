@@ -0,0 +1,43 @@
+#!/usr/bin/env tarantool
+
+local tap = require('tap')
+local fiber = require('fiber')
+local test = tap.test('memtx_mvcc_errinj')
+
+box.cfg{memtx_use_mvcc_engine = true}
+
+local errinj = box.error.injection
+local s = box.schema.space.create('test')
+s:create_index('pk')
+s:insert{1, 10}
+
+test:plan(5)
+
+-- Changes are visible as soon as they are submitted to WAL.
+errinj.set('ERRINJ_WAL_DELAY', true)
+local writers = {}
+for i = 1, 2 do
+    writers[i] = fiber.new(function()
+        return pcall(s.replace, s, {1, 10 + i})
+    end)
+    writers[i]:set_joinable(true)
+end
+fiber.sleep(0)
+test:is(s:get{1}[2], 12, 'prepared change is visible')
+box.begin()
+test:is(s:get{1}[2], 12, 'prepared change is visible in a read view')
+box.commit()
+
+-- They are rolled back if the WAL write fails.
+errinj.set('ERRINJ_WAL_WRITE', true)
+errinj.set('ERRINJ_WAL_DELAY', false)
+for i = 1, 2 do
+    local _, ok, err = writers[i]:join()
+    test:ok(not ok and err.code == box.error.WAL_IO,
+            'write to a prepared tuple fails on WAL error')
+end
+errinj.set('ERRINJ_WAL_WRITE', false)
+test:is(s:get{1}[2], 10, 'prepared changes are rolled back')
+
+s:drop()
+os.exit(test:check() == true and 0 or 1)
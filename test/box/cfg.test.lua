@@ -131,6 +131,33 @@ box.cfg{net_msg_max = 2}
 box.cfg{net_msg_max = old + 1000}
 box.cfg{net_msg_max = old}
 
+--
+-- Network threads can be configured only at startup.
+--
+box.cfg{iproto_threads = 2}
+#box.stat.net.thread()
+box.cfg{iproto_read_threads = 2}
+box.cfg{memtx_sort_threads = -1}
+box.cfg{memtx_sort_threads = 2}
+box.cfg.memtx_sort_threads
+box.cfg{memtx_sort_threads = 0}
+box.cfg{wal_batch_max_delay = -1}
+box.cfg{wal_batch_max_bytes = 0}
+box.cfg{wal_batch_max_delay = 0.001}
+box.space._schema:replace{'wal_batch'}
+box.space._schema:delete{'wal_batch'}
+box.stat.wal().requests > 0
+box.cfg{wal_batch_max_delay = 0}
+
+--
+-- The WAL cache read by relays.
+--
+old = box.cfg.wal_cache_size
+box.cfg{wal_cache_size = -1}
+box.cfg{wal_cache_size = 0}
+box.cfg.wal_cache_size
+box.cfg{wal_cache_size = old}
+
 --
 -- gh-3266: box.cfg{} still not optional on 2.0 brach
 --
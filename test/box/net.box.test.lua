@@ -1388,6 +1388,47 @@ c = net.connect('8.8.8.8:123456', {wait_connected = false})
 c
 c:close()
 
+--
+-- Responses with at most one tuple are decoded without
+-- creating an intermediate table.
+--
+s = box.schema.space.create('test_get')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {unique = false, parts = {2, 'unsigned'}})
+box.schema.user.grant('guest', 'read,write', 'space', 'test_get')
+c = net.connect(box.cfg.listen)
+c.space.test_get:insert{1, 1}
+c.space.test_get:replace{2, 1}
+c.space.test_get:get{1}
+c.space.test_get:get{3}
+c.space.test_get.index.sk:get{1}
+c.space.test_get.index.sk:select{1}
+c.space.test_get:delete{2}
+c:close()
+s:drop()
+
+--
+-- Batch requests.
+--
+s = box.schema.space.create('test_batch')
+_ = s:create_index('pk')
+box.schema.user.grant('guest', 'read,write', 'space', 'test_batch')
+c = net.connect(box.cfg.listen)
+b = net.new_batch({discard = true})
+for i = 1, 10 do c.space.test_batch:insert({i}, {batch = b}) end
+test_run:wait_cond(function() return s:count() == 10 end, 10)
+b = net.new_batch({size = 4})
+c.space.test_batch:get({1}, {batch = b})
+c.space.test_batch:get({100}, {batch = b})
+c.space.test_batch:insert({1}, {batch = b})
+c.space.test_batch:select({}, {batch = b})
+results, errors = b:wait()
+results[1], results[2] == nil, results[3] == nil, #results[4]
+errors[3]
+errors[1], errors[2], errors[4]
+c:close()
+s:drop()
+
 box.schema.func.drop('do_long')
 box.schema.user.revoke('guest', 'write', 'space', '_schema')
 box.schema.user.revoke('guest', 'read,write', 'space', '_space')
@@ -0,0 +1,48 @@
+--
+-- Check that rows received by a replica, which failed to be
+-- written to WAL while being applied in parallel, are received
+-- again when the replication is resumed.
+--
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+
+test_run:cmd("switch replica")
+test_run = require('test_run').new()
+errinj = box.error.injection
+lsn = box.info.vclock[1]
+-- Keep the rows in flight.
+errinj.set('ERRINJ_WAL_DELAY', true)
+
+test_run:cmd("switch default")
+for i = 1, 10 do s:insert{i} end
+
+test_run:cmd("switch replica")
+test_run:wait_cond(function() return box.info.replication[1].upstream.queue == 10 end, 10)
+errinj.set('ERRINJ_WAL_WRITE', true)
+errinj.set('ERRINJ_WAL_DELAY', false)
+test_run:wait_cond(function() return box.info.replication[1].upstream.status == 'stopped' end, 10)
+box.space.test:count()
+box.info.vclock[1] == lsn
+
+-- Resume the replication.
+errinj.set('ERRINJ_WAL_WRITE', false)
+replication = box.cfg.replication
+box.cfg{replication = {}}
+box.cfg{replication = replication}
+test_run:wait_cond(function() return box.space.test:count() == 10 end, 10)
+box.info.replication[1].upstream.status
+box.info.vclock[1] == lsn + 10
+
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+s:drop()
+box.schema.user.revoke('guest', 'replication')
+test_run:cleanup_cluster()
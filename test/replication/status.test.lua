@@ -85,6 +85,7 @@ master.uuid == box.space._cluster:get(master_id)[2]
 master.upstream.status == "follow"
 master.upstream.lag < 1
 master.upstream.idle < 1
+master.upstream.queue >= 0
 master.upstream.peer:match("localhost")
 master.downstream == nil
 
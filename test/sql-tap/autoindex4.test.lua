@@ -1,6 +1,6 @@
 #!/usr/bin/env tarantool
 test = require("sqltester")
-test:plan(7)
+test:plan(11)
 
 --!./tcltestrunner.lua
 -- 2014-10-24
@@ -125,5 +125,65 @@ test:do_execsql_test(
         -- </autoindex4-3.1>
     })
 
-test:finish_test()
+-- Tarantool: an automatic index is built in an ephemeral space
+-- when a join constraint can't use any index of the table.
+-- Automatic indexes are disabled by default.
+test:do_execsql_test(
+    "autoindex4-4.0",
+    [[
+        PRAGMA automatic_index;
+    ]], {
+        -- <autoindex4-4.0>
+        0
+        -- </autoindex4-4.0>
+    })
+
+test:do_test(
+    "autoindex4-4.1",
+    function()
+        test:execsql([[
+            PRAGMA automatic_index = 1;
+            CREATE TABLE t4(id INT PRIMARY KEY, a INT);
+            CREATE TABLE t5(id INT PRIMARY KEY, b INT);
+            WITH RECURSIVE cnt(x) AS (VALUES(1) UNION ALL SELECT x+1 FROM cnt WHERE x<200)
+                INSERT INTO t4 SELECT x, x % 50 FROM cnt;
+            WITH RECURSIVE cnt(x) AS (VALUES(1) UNION ALL SELECT x+1 FROM cnt WHERE x<200)
+                INSERT INTO t5 SELECT x, x % 20 FROM cnt;
+        ]])
+        local plan = test:execsql([[
+            EXPLAIN QUERY PLAN SELECT count(*) FROM t4, t5 WHERE a = b;
+        ]])
+        return {string.match(table.concat(plan, ' '),
+                             'AUTOMATIC COVERING INDEX')}
+    end, {
+        -- <autoindex4-4.1>
+        "AUTOMATIC COVERING INDEX"
+        -- </autoindex4-4.1>
+    })
 
+test:do_execsql_test(
+    "autoindex4-4.2",
+    [[
+        SELECT count(*), sum(t4.id), sum(t5.id) FROM t4, t5 WHERE a = b;
+    ]], {
+        -- <autoindex4-4.2>
+        800, 69600, 80400
+        -- </autoindex4-4.2>
+    })
+
+-- The automatic index is not used when disabled.
+test:do_test(
+    "autoindex4-4.3",
+    function()
+        test:execsql("PRAGMA automatic_index = 0;")
+        local plan = test:execsql([[
+            EXPLAIN QUERY PLAN SELECT count(*) FROM t4, t5 WHERE a = b;
+        ]])
+        return {string.match(table.concat(plan, ' '),
+                             'AUTOMATIC COVERING INDEX')}
+    end, {
+        -- <autoindex4-4.3>
+        -- </autoindex4-4.3>
+    })
+
+test:finish_test()
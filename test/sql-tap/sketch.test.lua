@@ -0,0 +1,66 @@
+#!/usr/bin/env tarantool
+test = require("sqltester")
+test:plan(5)
+
+-- Distinct key estimates maintained by indexes on write let
+-- the planner choose an index without ANALYZE.
+--
+-- Without estimates the planner assumes that an equality on
+-- more key parts is more selective, so it prefers T1A. Actually
+-- all rows have the same A, C and D, while B is unique.
+
+testprefix = "sketch"
+
+test:do_execsql_test(
+    1.0,
+    [[
+        CREATE TABLE t1(id INT PRIMARY KEY, a INT, b INT, c INT, d INT);
+        CREATE INDEX t1a ON t1(a, c, d);
+        CREATE INDEX t1b ON t1(b);
+        WITH RECURSIVE cnt(x) AS (VALUES(1) UNION ALL SELECT x+1 FROM cnt WHERE x<1000) INSERT INTO t1 SELECT x, 1, x, 1, 1 FROM cnt;
+    ]], {
+        -- <1.0>
+        -- </1.0>
+    })
+
+test:do_test(
+    1.1,
+    function()
+        return test:execsql("EXPLAIN QUERY PLAN SELECT * FROM t1 WHERE a = 1 AND c = 1 AND d = 1 AND b = 10")
+    end, {
+        '/USING INDEX T1B/'
+    })
+
+-- Estimates are not collected if disabled.
+test:do_test(
+    1.2,
+    function()
+        box.space.T1.index.T1A:alter({sketch = false})
+        box.space.T1.index.T1B:alter({sketch = false})
+        return test:execsql("EXPLAIN QUERY PLAN SELECT * FROM t1 WHERE a = 1 AND c = 1 AND d = 1 AND b = 10")
+    end, {
+        '/USING INDEX T1A/'
+    })
+
+-- Estimates are rebuilt when enabled again.
+test:do_test(
+    1.3,
+    function()
+        box.space.T1.index.T1A:alter({sketch = true})
+        box.space.T1.index.T1B:alter({sketch = true})
+        return test:execsql("EXPLAIN QUERY PLAN SELECT * FROM t1 WHERE a = 1 AND c = 1 AND d = 1 AND b = 10")
+    end, {
+        '/USING INDEX T1B/'
+    })
+
+test:do_execsql_test(
+    1.4,
+    [[
+        SELECT id FROM t1 WHERE a = 1 AND c = 1 AND d = 1 AND b = 10;
+    ]], {
+        -- <1.4>
+        10
+        -- </1.4>
+    })
+
+test:finish_test()
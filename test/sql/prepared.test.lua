@@ -0,0 +1,64 @@
+remote = require('net.box')
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+box.sql.execute('pragma sql_default_engine=\''..engine..'\'')
+
+box.sql.execute('create table test (id int primary key, a int)')
+box.space.TEST:replace{1, 10}
+box.space.TEST:replace{2, 20}
+box.schema.user.grant('guest','read,write,execute', 'universe')
+cn = remote.connect(box.cfg.listen)
+
+--
+-- Statements prepared with IPROTO_PREPARE are compiled once
+-- and can be executed by id.
+--
+box.stat.reset()
+id = cn:prepare('select a from test where id = ?')
+type(id)
+cn:prepare('select a from test where id = ?') == id
+cn:execute(id, {1}).rows
+cn:execute(id, {2}).rows
+-- Executing the same text reuses the compiled statement.
+cn:execute('select a from test where id = ?', {1}).rows
+stat = box.stat.sql().cache
+stat.hit
+stat.miss
+stat.stmt_count > 0
+stat.size > 0
+
+-- Statements are recompiled after schema change.
+box.sql.execute('create index test_a on test(a)')
+cn:execute(id, {2}).rows
+box.space.TEST.index.TEST_A:drop()
+cn:execute(id, {1}).rows
+
+-- Statements are recompiled for sessions with other SQL flags.
+cn2 = remote.connect(box.cfg.listen)
+_ = cn2:execute('pragma full_column_names = 1')
+cn2:execute(id, {1}).metadata[1].name
+cn:execute(id, {1}).metadata[1].name
+cn2:execute('select a from test where id = ?', {1}).metadata[1].name
+cn:execute('select a from test where id = ?', {1}).metadata[1].name
+cn2:close()
+
+-- Errors.
+cn:execute(0)
+cn:prepare('select * from not_existing_table')
+
+-- Statements are evicted when the cache is full.
+box.cfg{sql_cache_size = 0}
+box.stat.sql().cache.stmt_count
+id2 = cn:prepare('select id from test where a = ?')
+box.stat.sql().cache.stmt_count
+cn:execute(id2, {20}).rows
+(pcall(cn.execute, cn, id, {1}))
+box.cfg{sql_cache_size = -1}
+box.cfg{sql_cache_size = 5 * 1024 * 1024}
+
+-- Statements of dropped tables can't be executed.
+box.sql.execute('drop table test')
+cn:execute(id2, {20})
+
+cn:close()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
@@ -0,0 +1,25 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+box.sql.execute('pragma sql_default_engine=\''..engine..'\'')
+
+--
+-- Read-only statements fetch tuples of memtx spaces in batches.
+-- Check scans spanning several batches.
+--
+box.sql.execute('create table t (id int primary key, a int)')
+for i = 1, 100 do box.space.T:insert{i, i % 10} end
+box.sql.execute('select count(*), sum(a) from t')
+box.sql.execute('select count(*) from t where a = 3')
+box.sql.execute('select id from t where id > 95')
+box.sql.execute('select id from t where id < 5 order by id desc')
+box.sql.execute('select count(*) from t as x, t as y where x.id = y.a')
+box.sql.execute('select count(*) from t as x, t as y where x.a = y.a')
+box.sql.execute('select count(*) from t where id in (select a from t)')
+
+-- Statements modifying spaces don't use batches.
+box.sql.execute('insert into t select id + 100, a from t')
+box.sql.execute('select count(*), sum(a) from t')
+box.sql.execute('delete from t where id > 150')
+box.sql.execute('select count(*), max(id) from t')
+
+box.sql.execute('drop table t')
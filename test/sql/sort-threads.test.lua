@@ -0,0 +1,31 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+box.sql.execute('pragma sql_default_engine=\''..engine..'\'')
+
+--
+-- Sorter spills intermediate results that don't fit in memory
+-- to disk and merges them using worker threads.
+--
+box.cfg{sql_sort_threads = -1}
+box.cfg{sql_sort_threads = 9}
+box.cfg{sql_sort_threads = 4}
+box.cfg.sql_sort_threads
+
+box.sql.execute('create table t (id int primary key, a int, b text)')
+pad = string.rep('x', 1000)
+box.begin() for i = 1, 5000 do box.space.T:insert{i, i * 7919 % 5000, string.format('%04d', i % 100)..pad} end box.commit()
+
+function is_sorted(res) for i = 2, #res do if res[i - 1][1] < res[i][1] then return false end end return true end
+res = box.sql.execute('select a, b from t order by a desc')
+#res, res[1][1], res[#res][1], is_sorted(res)
+res = box.sql.execute('select substr(b, 1, 4), count(*) from t group by b')
+#res, res[1][1], res[1][2], res[#res][1], res[#res][2]
+box.sql.execute('select count(*) from (select distinct b from t)')
+
+-- Same in the tx thread.
+box.cfg{sql_sort_threads = 0}
+res = box.sql.execute('select a, b from t order by a desc')
+#res, res[1][1], res[#res][1], is_sorted(res)
+res = nil
+
+box.sql.execute('drop table t')
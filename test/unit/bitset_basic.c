@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <time.h>
+#include <limits.h>
 
 #include <bitset/bitset.h>
 
@@ -195,12 +196,56 @@ void test_get_set()
 	footer();
 }
 
+static
+void test_sparse_pages()
+{
+	header();
+
+	struct tt_bitset bm;
+	tt_bitset_create(&bm, realloc);
+	struct tt_bitset_info info;
+
+	/* A page with many bits set becomes a bitmap */
+	for (size_t i = 0; i < 100; i++)
+		fail_if(tt_bitset_set(&bm, i) < 0);
+	tt_bitset_info(&bm, &info);
+	fail_unless(info.pages == 1 && info.array_pages == 0);
+
+	/* A page with a few bits set stays an array */
+	const size_t far = info.page_data_size * CHAR_BIT * 5;
+	fail_if(tt_bitset_set(&bm, far) < 0);
+	tt_bitset_info(&bm, &info);
+	fail_unless(info.pages == 2 && info.array_pages == 1);
+
+	/* A bitmap page that became sparse is an array again */
+	for (size_t i = 0; i < 80; i++)
+		fail_unless(tt_bitset_clear(&bm, i) == 1);
+	tt_bitset_info(&bm, &info);
+	fail_unless(info.pages == 2 && info.array_pages == 2);
+	fail_unless(tt_bitset_cardinality(&bm) == 21);
+	for (size_t i = 0; i < 100; i++)
+		fail_unless(tt_bitset_test(&bm, i) == (i >= 80));
+	fail_unless(tt_bitset_test(&bm, far));
+
+	for (size_t i = 80; i < 100; i++)
+		fail_unless(tt_bitset_clear(&bm, i) == 1);
+	fail_unless(tt_bitset_clear(&bm, far) == 1);
+	tt_bitset_info(&bm, &info);
+	fail_unless(info.pages == 0 && info.mem_size == 0);
+	fail_unless(tt_bitset_cardinality(&bm) == 0);
+
+	tt_bitset_destroy(&bm);
+
+	footer();
+}
+
 int main(int argc, char *argv[])
 {
 	setbuf(stdout, NULL);
 	srand(time(NULL));
 	test_cardinality();
 	test_get_set();
+	test_sparse_pages();
 
 	return 0;
 }
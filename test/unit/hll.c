@@ -0,0 +1,95 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "unit.h"
+#include "salad/hll.h"
+
+/** splitmix64 finalizer: a good enough hash for tests. */
+static uint64_t
+hash(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+/** Check that an estimate is within 5 standard errors. */
+static bool
+estimate_is_good(const struct hll *hll, uint64_t count)
+{
+	double error = 5 * 1.04 / sqrt(hll_register_count(hll));
+	double estimate = hll_estimate(hll);
+	return fabs(estimate - count) <= error * count;
+}
+
+static void
+test_estimate(void)
+{
+	header();
+	plan(7);
+
+	struct hll hll;
+	fail_if(hll_create(&hll, 12) != 0);
+	is(hll_estimate(&hll), 0, "empty");
+
+	uint64_t added = 0;
+	for (uint64_t count = 10; count <= 1000000; count *= 10) {
+		for (; added < count; added++) {
+			/* Duplicates must not affect the estimate. */
+			hll_add(&hll, hash(added));
+			hll_add(&hll, hash(added / 2));
+		}
+		ok(estimate_is_good(&hll, count), "%llu values",
+		   (unsigned long long)count);
+	}
+	hll_destroy(&hll);
+
+	check_plan();
+	footer();
+}
+
+static void
+test_merge(void)
+{
+	header();
+	plan(4);
+
+	struct hll a, b, all;
+	fail_if(hll_create(&a, 10) != 0);
+	fail_if(hll_create(&b, 10) != 0);
+	fail_if(hll_create(&all, 10) != 0);
+	for (uint64_t i = 0; i < 20000; i++) {
+		hll_add(i % 2 == 0 ? &a : &b, hash(i));
+		hll_add(&all, hash(i));
+	}
+	ok(estimate_is_good(&a, 10000), "first half");
+	hll_merge(&a, &b);
+	is(hll_estimate(&a), hll_estimate(&all), "merge of halves");
+	ok(estimate_is_good(&a, 20000), "merged");
+
+	hll_reset(&a);
+	is(hll_estimate(&a), 0, "reset");
+
+	hll_destroy(&a);
+	hll_destroy(&b);
+	hll_destroy(&all);
+
+	check_plan();
+	footer();
+}
+
+int
+main(void)
+{
+	header();
+	plan(2);
+
+	test_estimate();
+	test_merge();
+
+	int rc = check_plan();
+	footer();
+	return rc;
+}
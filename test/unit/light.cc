@@ -318,6 +318,57 @@ iterator_freeze_check()
 	footer();
 }
 
+static void
+view_check()
+{
+	header();
+
+	const int test_data_size = 1000;
+	const int test_data_mod = 2000;
+	srand(0);
+	struct light_core ht;
+
+	for (int i = 0; i < 10; i++) {
+		light_create(&ht, light_extent_size,
+			     my_light_alloc, my_light_free, &extents_count, 0);
+		bool in_view[test_data_mod] = {false};
+		for (int j = 0; j < test_data_size; j++) {
+			hash_value_t val = rand() % test_data_mod;
+			hash_t h = hash(val);
+			if (light_find(&ht, h, val) == light_end)
+				light_insert(&ht, h, val);
+			in_view[val] = true;
+		}
+		struct light_view view;
+		light_view_create(&ht, &view);
+		for (int j = 0; j < test_data_mod; j++) {
+			hash_value_t val = j;
+			hash_t h = hash(val);
+			hash_t pos = light_find(&ht, h, val);
+			if (pos != light_end)
+				light_delete(&ht, pos);
+			else
+				light_insert(&ht, h, val);
+		}
+		for (int j = 0; j < test_data_mod; j++) {
+			hash_value_t val = j;
+			hash_t pos = light_view_find_key(&ht, &view,
+							 hash(val), val);
+			if ((pos != light_end) != in_view[j]) {
+				fail("view lookup failed (1)", "true");
+			}
+			if (pos != light_end &&
+			    light_view_get(&ht, &view, pos) != val) {
+				fail("view lookup failed (2)", "true");
+			}
+		}
+		light_view_destroy(&ht, &view);
+		light_destroy(&ht);
+	}
+
+	footer();
+}
+
 int
 main(int, const char**)
 {
@@ -326,6 +377,7 @@ main(int, const char**)
 	collision_test();
 	iterator_test();
 	iterator_freeze_check();
+	view_check();
 	if (extents_count != 0)
 		fail("memory leak!", "true");
 }
@@ -29,6 +29,13 @@ extent_free(void *ctx, void *page)
 	free(page);
 }
 
+static void *
+extent_alloc_fail(void *ctx)
+{
+	(void)ctx;
+	return NULL;
+}
+
 static void
 simple_check()
 {
@@ -275,13 +282,96 @@ neighbor_test()
 
 	footer();
 }
+static void
+bulk_load_check()
+{
+	struct rtree_rect rect;
+	struct rtree_iterator iterator;
+	rtree_iterator_init(&iterator);
+	const size_t side = 100;
+	const size_t count = side * side;
+
+	header();
+
+	struct rtree tree;
+	rtree_init(&tree, 2, extent_size,
+		   extent_alloc, extent_free, &page_count,
+		   RTREE_EUCLID);
+
+	void *entries = malloc(count * rtree_bulk_entry_size(&tree));
+	for (size_t i = 0; i < count; i++) {
+		coord_t x = i % side, y = i / side;
+		rtree_set2d(&rect, x, y, x + 0.5, y + 0.5);
+		rtree_bulk_entry_set(&tree, entries, i, &rect,
+				     (record_t)(i + 1));
+	}
+	if (rtree_bulk_load(&tree, entries, count) != 0) {
+		fail("bulk load", "false");
+	}
+
+	if (rtree_number_of_records(&tree) != count) {
+		fail("Tree count mismatch", "true");
+	}
+	for (size_t i = 0; i < count; i++) {
+		coord_t x = i % side, y = i / side;
+		rtree_set2d(&rect, x, y, x + 0.5, y + 0.5);
+		if (!rtree_search(&tree, &rect, SOP_EQUALS, &iterator)) {
+			fail("element in tree", "false");
+		}
+		if (rtree_iterator_next(&iterator) != (record_t)(i + 1)) {
+			fail("right search result", "true");
+		}
+		if (rtree_iterator_next(&iterator)) {
+			fail("single search result", "true");
+		}
+	}
+	rtree_set2d(&rect, 10, 10, 19.5, 19.5);
+	size_t found = 0;
+	if (rtree_search(&tree, &rect, SOP_BELONGS, &iterator)) {
+		while (rtree_iterator_next(&iterator) != NULL)
+			found++;
+	}
+	if (found != 100) {
+		fail("belongs search result count", "false");
+	}
+	rtree_set2d(&rect, side, side, side + 0.5, side + 0.5);
+	rtree_insert(&tree, &rect, (record_t)(count + 1));
+	for (size_t i = 0; i < count; i++) {
+		coord_t x = i % side, y = i / side;
+		rtree_set2d(&rect, x, y, x + 0.5, y + 0.5);
+		if (!rtree_remove(&tree, &rect, (record_t)(i + 1))) {
+			fail("delete element in tree", "false");
+		}
+	}
+	if (rtree_number_of_records(&tree) != 1) {
+		fail("Tree count mismatch after remove", "true");
+	}
+
+	rtree_iterator_destroy(&iterator);
+	rtree_destroy(&tree);
 
+	/* Allocation failure is reported, the tree is left empty. */
+	rtree_init(&tree, 2, extent_size,
+		   extent_alloc_fail, extent_free, &page_count,
+		   RTREE_EUCLID);
+	if (rtree_bulk_load(&tree, entries, count) == 0) {
+		fail("bulk load failure", "true");
+	}
+	if (rtree_number_of_records(&tree) != 0) {
+		fail("Tree count mismatch after failure", "true");
+	}
+	rtree_destroy(&tree);
+	free(entries);
+
+	footer();
+}
 
 int
 main(void)
 {
 	simple_check();
 	neighbor_test();
+	bulk_load_check();
 	if (page_count != 0) {
 		fail("memory leak!", "true");
 	}
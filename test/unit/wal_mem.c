@@ -0,0 +1,222 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unit.h"
+#include "fiber.h"
+#include "memory.h"
+#include "box/iproto_constants.h"
+#include "box/vclock.h"
+#include "box/wal_mem.h"
+#include "box/xrow.h"
+
+enum { ROWS_PER_BATCH = 2 };
+
+/**
+ * Append a batch of ROWS_PER_BATCH rows following @a vclock
+ * to the cache and promote the vclock.
+ */
+static void
+append_batch(struct wal_mem *mem, struct vclock *vclock)
+{
+	struct vclock begin;
+	vclock_copy(&begin, vclock);
+	struct xrow_header rows[ROWS_PER_BATCH];
+	struct iovec iov[XROW_IOVMAX * ROWS_PER_BATCH];
+	int iovcnt = 0;
+	for (int i = 0; i < ROWS_PER_BATCH; i++) {
+		struct xrow_header *row = &rows[i];
+		memset(row, 0, sizeof(*row));
+		row->type = IPROTO_INSERT;
+		row->replica_id = 1;
+		row->lsn = vclock_get(vclock, 1) + 1;
+		vclock_follow_xrow(vclock, row);
+		iovcnt += xrow_to_iovec(row, iov + iovcnt);
+	}
+	fail_if(wal_mem_append(mem, &begin, iov, iovcnt) != 0);
+	fiber_gc();
+}
+
+/**
+ * Read all rows available to a cursor. Return the number
+ * of rows read, the LSN of the first row read and the last
+ * return code of wal_mem_cursor_next().
+ */
+static int
+read_all(struct wal_mem *mem, struct wal_mem_cursor *cursor,
+	 int64_t *first_lsn, int64_t *last_lsn, int *rc)
+{
+	int count = 0;
+	struct xrow_header row;
+	*first_lsn = *last_lsn = -1;
+	while ((*rc = wal_mem_cursor_next(mem, cursor, &row)) == 0) {
+		if (count++ == 0)
+			*first_lsn = row.lsn;
+		*last_lsn = row.lsn;
+	}
+	return count;
+}
+
+static void
+test_basic(void)
+{
+	header();
+	plan(11);
+
+	struct wal_mem mem;
+	wal_mem_create(&mem, SIZE_MAX);
+
+	struct vclock vclock, start;
+	vclock_create(&vclock);
+	vclock_create(&start);
+
+	struct wal_mem_cursor cursor;
+	is(wal_mem_cursor_create(&mem, &cursor, &start), -1,
+	   "cursor on empty cache");
+
+	for (int i = 0; i < 3; i++)
+		append_batch(&mem, &vclock);
+
+	int64_t first_lsn, last_lsn;
+	int rc;
+	is(wal_mem_cursor_create(&mem, &cursor, &start), 0,
+	   "cursor at the start");
+	is(read_all(&mem, &cursor, &first_lsn, &last_lsn, &rc),
+	   3 * ROWS_PER_BATCH, "all rows read");
+	ok(first_lsn == 1 && last_lsn == 3 * ROWS_PER_BATCH,
+	   "rows read in order");
+	is(rc, 1, "end of cache");
+
+	append_batch(&mem, &vclock);
+	is(read_all(&mem, &cursor, &first_lsn, &last_lsn, &rc),
+	   ROWS_PER_BATCH, "new rows read");
+	is(first_lsn, 3 * ROWS_PER_BATCH + 1, "new rows follow old ones");
+	wal_mem_cursor_destroy(&mem, &cursor);
+
+	struct vclock middle;
+	vclock_create(&middle);
+	vclock_follow(&middle, 1, ROWS_PER_BATCH + 1);
+	is(wal_mem_cursor_create(&mem, &cursor, &middle), 0,
+	   "cursor in the middle");
+	is(read_all(&mem, &cursor, &first_lsn, &last_lsn, &rc),
+	   3 * ROWS_PER_BATCH, "rows of the batch containing vclock read");
+	is(first_lsn, ROWS_PER_BATCH + 1, "cursor starts at the batch");
+	wal_mem_cursor_destroy(&mem, &cursor);
+
+	wal_mem_reset(&mem);
+	is(wal_mem_cursor_create(&mem, &cursor, &vclock), -1,
+	   "cursor after reset");
+
+	wal_mem_destroy(&mem);
+
+	check_plan();
+	footer();
+}
+
+static void
+test_eviction(void)
+{
+	header();
+	plan(6);
+
+	/* Keep only the last batch. */
+	struct wal_mem mem;
+	wal_mem_create(&mem, 1);
+
+	struct vclock vclock, start;
+	vclock_create(&vclock);
+	vclock_create(&start);
+
+	append_batch(&mem, &vclock);
+	struct wal_mem_cursor cursor;
+	is(wal_mem_cursor_create(&mem, &cursor, &start), 0,
+	   "cursor at the start");
+	struct xrow_header row;
+	is(wal_mem_cursor_next(&mem, &cursor, &row), 0, "row read");
+
+	append_batch(&mem, &vclock);
+	append_batch(&mem, &vclock);
+	is(wal_mem_cursor_next(&mem, &cursor, &row), 0,
+	   "row of evicted referenced batch read");
+	is(wal_mem_cursor_next(&mem, &cursor, &row), -1,
+	   "next batch evicted");
+	wal_mem_cursor_destroy(&mem, &cursor);
+
+	is(wal_mem_cursor_create(&mem, &cursor, &start), -1,
+	   "cursor before the cache");
+	is(wal_mem_cursor_create(&mem, &cursor, &vclock), 0,
+	   "cursor at the end");
+	wal_mem_cursor_destroy(&mem, &cursor);
+
+	wal_mem_destroy(&mem);
+
+	check_plan();
+	footer();
+}
+
+static void
+test_readers(void)
+{
+	header();
+	plan(7);
+
+	struct wal_mem mem;
+	wal_mem_create(&mem, SIZE_MAX);
+	ok(!wal_mem_is_used(&mem), "unused without readers");
+	wal_mem_attach(&mem);
+	ok(wal_mem_is_used(&mem), "used with a reader");
+
+	struct vclock vclock, start;
+	vclock_create(&vclock);
+	vclock_create(&start);
+
+	append_batch(&mem, &vclock);
+	struct wal_mem_cursor cursor;
+	is(wal_mem_cursor_create(&mem, &cursor, &start), 0,
+	   "cursor at the start");
+	int64_t first_lsn, last_lsn;
+	int rc;
+	is(read_all(&mem, &cursor, &first_lsn, &last_lsn, &rc),
+	   ROWS_PER_BATCH, "all rows read");
+
+	/* A batch written while the cache is not used. */
+	struct vclock skipped;
+	vclock_copy(&skipped, &vclock);
+	vclock_follow(&vclock, 1, vclock_get(&vclock, 1) + ROWS_PER_BATCH);
+	wal_mem_reset(&mem);
+	append_batch(&mem, &vclock);
+	read_all(&mem, &cursor, &first_lsn, &last_lsn, &rc);
+	is(rc, -1, "skipped batch is noticed");
+	wal_mem_cursor_destroy(&mem, &cursor);
+	is(wal_mem_cursor_create(&mem, &cursor, &skipped), -1,
+	   "cursor before the skipped batch");
+
+	wal_mem_set_max_size(&mem, 0);
+	ok(!wal_mem_is_used(&mem), "unused if disabled");
+
+	wal_mem_detach(&mem);
+	wal_mem_destroy(&mem);
+
+	check_plan();
+	footer();
+}
+
+int
+main(void)
+{
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	header();
+	plan(3);
+
+	test_basic();
+	test_eviction();
+	test_readers();
+
+	int rc = check_plan();
+	footer();
+	fiber_free();
+	memory_free();
+	return rc;
+}
@@ -79,9 +79,11 @@ end;
 --
 -- Note, checking correctness of the load regulator logic is beyond
 -- the scope of this test so we just filter out related statistics.
+-- Page cache statistics are checked by vinyl/page_cache.test.lua.
 function gstat()
     local st = box.stat.vinyl()
     st.regulator = nil
+    st.page_cache = nil
     return st
 end;
 
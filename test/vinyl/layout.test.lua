@@ -50,6 +50,9 @@ for i, path in pairs(files) do
             if row.BODY.bloom_filter ~= nil then
                 row.BODY.bloom_filter = '<bloom_filter>'
             end
+            if row.BODY.sketch ~= nil then
+                row.BODY.sketch = '<sketch>'
+            end
             rows[i] = row
             i = i + 1
         end
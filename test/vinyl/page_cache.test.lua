@@ -0,0 +1,48 @@
+test_run = require('test_run').new()
+
+--
+-- Page cache.
+--
+box.cfg.vinyl_page_cache
+
+-- Disable tuple cache so that all reads go to disk.
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+box.cfg{vinyl_page_cache = 1024 * 1024}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 1024})
+pad = string.rep('x', 100)
+for i = 1, 100 do s:replace{i, pad} end
+box.snapshot()
+
+function pstat() return box.stat.vinyl().page_cache end
+function page_reads() return s.index.pk:stat().disk.iterator.read.pages end
+
+-- Pages are read from disk and cached.
+st = pstat()
+reads = page_reads()
+#s:select()
+pstat().miss > st.miss
+pstat().size > 0
+page_reads() > reads
+
+-- Pages are read from the cache.
+st = pstat()
+reads = page_reads()
+#s:select()
+pstat().hit > st.hit
+pstat().miss == st.miss
+page_reads() == reads
+
+-- Disabling the cache evicts all pages.
+box.cfg{vinyl_page_cache = 0}
+pstat().size
+st = pstat()
+reads = page_reads()
+#s:select()
+pstat().hit == st.hit and pstat().miss == st.miss
+page_reads() > reads
+
+s:drop()
+box.cfg{vinyl_cache = vinyl_cache}
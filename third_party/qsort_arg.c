@@ -202,7 +202,7 @@ loop:SWAPINIT(a, es);
 	r = min(pd - pc, pn - pd - (intptr_t)es);
 	vecswap(pb, pn - r, r);
 	if ((r = pb - pa) > (intptr_t)es)
-		qsort_arg(a, r / es, es, cmp, arg);
+		qsort_arg_st(a, r / es, es, cmp, arg);
 	if ((r = pd - pc) > (intptr_t)es)
 	{
 		/* Iterate rather than recurse to save stack space */
@@ -219,7 +219,8 @@ loop:SWAPINIT(a, es);
  * open MP.
  */
 void qsort_arg_mt(void *a, size_t n, size_t es,
-		  int (*cmp)(const void *, const void *, void *), void *arg);
+		  int (*cmp)(const void *, const void *, void *), void *arg,
+		  int n_threads);
 #endif
 
 /**
@@ -229,13 +230,22 @@ void qsort_arg_mt(void *a, size_t n, size_t es,
 void
 qsort_arg(void *a, size_t n, size_t es,
 	  int (*cmp)(const void *a, const void *b, void *arg), void *arg)
+{
+	qsort_arg_threads(a, n, es, cmp, arg, 0);
+}
+
+void
+qsort_arg_threads(void *a, size_t n, size_t es,
+		  int (*cmp)(const void *a, const void *b, void *arg),
+		  void *arg, int n_threads)
 {
 #ifdef HAVE_OPENMP
-	if (n >= MULTITHREAD_SIZE_THRESHOLD)
-		qsort_arg_mt(a, n, es, cmp, arg);
+	if (n >= MULTITHREAD_SIZE_THRESHOLD && n_threads != 1)
+		qsort_arg_mt(a, n, es, cmp, arg, n_threads);
 	else
 		qsort_arg_st(a, n, es, cmp, arg);
 #else
+	(void)n_threads;
 	qsort_arg_st(a, n, es, cmp, arg);
 #endif
 }
@@ -15,6 +15,15 @@ extern "C" {
 void qsort_arg(void *a, size_t n, size_t es,
 	       int (*cmp)(const void *a, const void *b, void *arg), void *arg);
 
+/**
+ * Same as qsort_arg(), but sort big arrays in at most @a n_threads
+ * threads. 0 means the open MP default (the number of CPUs),
+ * 1 forces single-threaded sort.
+ */
+void qsort_arg_threads(void *a, size_t n, size_t es,
+		       int (*cmp)(const void *a, const void *b, void *arg),
+		       void *arg, int n_threads);
+
 #if defined(__cplusplus)
 }
 #endif /* defined(__cplusplus) */
@@ -223,12 +223,21 @@ qsort_arg_mt_internal(void *a, size_t n, intptr_t es,
 
 void
 qsort_arg_mt(void *a, size_t n, size_t es,
-	     int (*cmp)(const void *a, const void *b, void *arg), void *arg)
+	     int (*cmp)(const void *a, const void *b, void *arg), void *arg,
+	     int n_threads)
 {
+	if (n_threads > 0) {
+#pragma omp parallel num_threads(n_threads)
+		{
+#pragma omp single
+			qsort_arg_mt_internal(a, n, es, cmp, arg);
+		}
+	} else {
 #pragma omp parallel
-	{
+		{
 #pragma omp single
-		qsort_arg_mt_internal(a, n, es, cmp, arg);
+			qsort_arg_mt_internal(a, n, es, cmp, arg);
+		}
 	}
 	thread_pool_trim();
 }